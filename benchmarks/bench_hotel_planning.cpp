@@ -0,0 +1,390 @@
+#include "benchmarks/benchmark.h"
+
+#include "hotel/availabilitysearch.h"
+#include "hotel/hotelcollection.h"
+#include "hotel/occupancyanalytics.h"
+#include "hotel/planning.h"
+#include "hotel/planningoptimizer.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+  using namespace boost::gregorian;
+
+  const date origin(2017, 1, 1);
+
+  //! Creates n non-overlapping two-night reservations in a single room, in random order
+  std::vector<hotel::Reservation> makeSingleRoomReservations(int n, std::mt19937& rng)
+  {
+    std::vector<hotel::Reservation> result;
+    result.reserve(n);
+    for (int i = 0; i < n; ++i)
+      result.emplace_back("", 1, date_period(origin + days(3 * i), origin + days(3 * i + 2)));
+    std::shuffle(result.begin(), result.end(), rng);
+    return result;
+  }
+
+  //! Creates a hotel with the given number of rooms (with ids starting at 1) in a single category with id 1
+  hotel::HotelCollection makeSingleCategoryHotel(int rooms)
+  {
+    std::vector<std::unique_ptr<hotel::Hotel>> hotels;
+    hotels.push_back(std::make_unique<hotel::Hotel>("Hotel"));
+    hotels[0]->addRoomCategory(std::make_unique<hotel::RoomCategory>("STD", "Standard"));
+    hotels[0]->getCategoryByShortCode("STD")->setId(1);
+    for (int room = 1; room <= rooms; ++room)
+    {
+      hotels[0]->addRoom(std::make_unique<hotel::HotelRoom>(std::to_string(room)), "STD");
+      hotels[0]->rooms().back()->setId(room);
+    }
+    return hotel::HotelCollection(std::move(hotels));
+  }
+
+  //! Occupies each of the rooms about two thirds of the time over two years, with stays of one to fourteen nights
+  void fillRooms(hotel::PlanningBoard& board, int rooms, std::mt19937& rng)
+  {
+    std::uniform_int_distribution<> lengthDist(1, 14);
+    for (int room = 1; room <= rooms; ++room)
+    {
+      for (int day = 0; day < 730; day += lengthDist(rng) / 2)
+      {
+        auto length = lengthDist(rng);
+        board.addReservation(std::make_unique<hotel::Reservation>(
+            "", room, date_period(origin + days(day), origin + days(day + length))));
+        day += length;
+      }
+    }
+  }
+} // namespace
+
+HOTEL_BENCHMARK(PlanningBoardSingleRoomScaling)
+{
+  // All operations should scale logarithmically with the number of reservations in a room
+  for (int n = 1000; n <= 64000; n *= 2)
+  {
+    std::mt19937 rng(42);
+    auto reservations = makeSingleRoomReservations(n, rng);
+    std::uniform_int_distribution<> dayDist(0, 3 * n);
+
+    hotel::PlanningBoard board;
+    auto insert = benchmarks::measure(n, [&](int i) {
+      board.addReservation(std::make_unique<hotel::Reservation>(reservations[i]));
+    });
+    benchmarks::report("addReservation", n, insert);
+
+    auto isFree = benchmarks::measure(100000, [&](int) {
+      auto day = origin + days(dayDist(rng));
+      benchmarks::doNotOptimize(board.isFree(1, date_period(day, day + days(1))));
+    });
+    benchmarks::report("isFree", n, isFree);
+
+    auto availableDays = benchmarks::measure(100000, [&](int) {
+      benchmarks::doNotOptimize(board.getAvailableDaysFrom(1, origin + days(dayDist(rng))));
+    });
+    benchmarks::report("getAvailableDaysFrom", n, availableDays);
+
+    auto allReservations = board.reservations();
+    std::shuffle(allReservations.begin(), allReservations.end(), rng);
+    auto remove = benchmarks::measure(n, [&](int i) { board.removeReservation(allReservations[i]); });
+    benchmarks::report("removeReservation", n, remove);
+  }
+}
+
+HOTEL_BENCHMARK(PlanningBoardUpdateBatch)
+{
+  // Replaying an update batch removes and re-adds every updated reservation, as the planning widget does. The cost per
+  // update should not depend on the number of reservations on the board.
+  for (int n = 1000; n <= 64000; n *= 2)
+  {
+    std::mt19937 rng(42);
+    hotel::PlanningBoard board;
+    for (int i = 0; i < n; ++i)
+    {
+      auto reservation = std::make_unique<hotel::Reservation>(
+          "", i % 100, date_period(origin + days(3 * (i / 100)), origin + days(3 * (i / 100) + 2)));
+      reservation->setId(i + 1);
+      board.addReservation(std::move(reservation));
+    }
+
+    std::uniform_int_distribution<> idDist(1, n);
+    auto update = benchmarks::measure(10000, [&](int) {
+      auto updated = *board.getReservationById(idDist(rng));
+      updated.setDescription("Updated");
+      board.removeReservation(updated.id());
+      board.addReservation(std::make_unique<hotel::Reservation>(std::move(updated)));
+    });
+    benchmarks::report("removeReservation + addReservation", n, update);
+  }
+}
+
+HOTEL_BENCHMARK(PlanningBoardViewportQuery)
+{
+  // A viewport of two months over a board with 100 rooms, whose history grows year by year. The query cost should only
+  // depend on the number of reservations inside the viewport.
+  for (int years = 1; years <= 32; years *= 2)
+  {
+    hotel::PlanningBoard board;
+    int n = 0;
+    for (int room = 0; room < 100; ++room)
+      for (int day = 0; day + 4 < 365 * years; day += 5 + room % 3, ++n)
+        board.addReservation(std::make_unique<hotel::Reservation>(
+            "", room, date_period(origin + days(day), origin + days(day + 4))));
+
+    auto viewport = date_period(origin + days(365 * years - 90), origin + days(365 * years - 30));
+    std::size_t hits = 0;
+    auto query = benchmarks::measure(1000, [&](int) {
+      hits = 0;
+      board.forEachReservationInPeriod(viewport, [&hits](const hotel::Reservation*) { ++hits; });
+      benchmarks::doNotOptimize(hits);
+    });
+    benchmarks::report("forEachReservationInPeriod (" + std::to_string(hits) + " hits)", n, query);
+  }
+}
+
+HOTEL_BENCHMARK(PlanningBoardFreeRooms)
+{
+  // Searching for free rooms during a multi-month stay, over all rooms of a category. Each room is occupied about two
+  // thirds of the time over two years.
+  for (int rooms = 1000; rooms <= 16000; rooms *= 4)
+  {
+    auto collection = makeSingleCategoryHotel(rooms);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<> lengthDist(1, 14);
+    hotel::PlanningBoard board;
+    fillRooms(board, rooms, rng);
+
+    std::uniform_int_distribution<> dayDist(0, 600);
+    std::size_t freeRooms = 0;
+    auto scan = benchmarks::measure(100, [&](int) {
+      auto from = origin + days(dayDist(rng));
+      freeRooms = board.getFreeRooms(collection, 1, date_period(from, from + days(lengthDist(rng) * 8))).size();
+      benchmarks::doNotOptimize(freeRooms);
+    });
+    benchmarks::report("getFreeRooms (isFree per room)", rooms, scan);
+
+    board.setOccupancyBitmapEnabled(true);
+    auto bitmapScan = benchmarks::measure(100, [&](int) {
+      auto from = origin + days(dayDist(rng));
+      freeRooms = board.getFreeRooms(collection, 1, date_period(from, from + days(lengthDist(rng) * 8))).size();
+      benchmarks::doNotOptimize(freeRooms);
+    });
+    benchmarks::report("getFreeRooms (occupancy bitmap)", rooms, bitmapScan);
+  }
+}
+
+HOTEL_BENCHMARK(PlanningBoardBulkLoad)
+{
+  // Loading a whole planning at once, e.g. when the initial stream data arrives
+  for (int n = 1000; n <= 256000; n *= 4)
+  {
+    std::vector<hotel::Reservation> reservations;
+    for (int i = 0; i < n; ++i)
+    {
+      auto from = origin + days(3 * (i / 200));
+      reservations.emplace_back("", i % 200, date_period(from, from + days(2)));
+    }
+    std::mt19937 rng(42);
+    std::shuffle(reservations.begin(), reservations.end(), rng);
+
+    auto single = benchmarks::measure(1, [&](int) {
+      hotel::PlanningBoard board;
+      for (auto& reservation : reservations)
+        board.addReservation(std::make_unique<hotel::Reservation>(reservation));
+      benchmarks::doNotOptimize(board.reservations().size());
+    });
+    benchmarks::report("addReservation (per reservation)", n, single / n);
+
+    auto bulk = benchmarks::measure(1, [&](int) {
+      std::vector<std::unique_ptr<hotel::Reservation>> batch;
+      for (auto& reservation : reservations)
+        batch.push_back(std::make_unique<hotel::Reservation>(reservation));
+      hotel::PlanningBoard board;
+      board.addReservations(std::move(batch));
+      benchmarks::doNotOptimize(board.reservations().size());
+    });
+    benchmarks::report("addReservations (per reservation)", n, bulk / n);
+  }
+}
+
+HOTEL_BENCHMARK(PlanningBoardLoadAllocations)
+{
+  // Loading a large planning, in which every fifth reservation changes rooms once
+  for (int n = 10000; n <= 1000000; n *= 10)
+  {
+    std::vector<hotel::Reservation> reservations;
+    reservations.reserve(n);
+    for (int i = 0; i < n; ++i)
+    {
+      auto room = i % 1000;
+      auto from = origin + days(4 * (i / 1000));
+      reservations.emplace_back("", room, date_period(from, from + days(2)));
+      if (i % 5 == 0)
+        reservations.back().addContinuation(1000 + room, from + days(3));
+      reservations.back().setId(i + 1);
+    }
+
+    auto allocations = benchmarks::allocationCount();
+    auto single = benchmarks::measure(1, [&](int) {
+      hotel::PlanningBoard board;
+      for (auto& reservation : reservations)
+        board.addReservation(std::make_unique<hotel::Reservation>(reservation));
+      benchmarks::doNotOptimize(board.reservations().size());
+    });
+    allocations = benchmarks::allocationCount() - allocations;
+    benchmarks::report("addReservation", n, single / n);
+    benchmarks::report("addReservation", n, static_cast<double>(allocations), "allocations");
+
+    allocations = benchmarks::allocationCount();
+    auto bulk = benchmarks::measure(1, [&](int) {
+      hotel::PlanningBoard board;
+      board.addReservations(std::move(reservations));
+      benchmarks::doNotOptimize(board.reservations().size());
+    });
+    allocations = benchmarks::allocationCount() - allocations;
+    benchmarks::report("addReservations (by value)", n, bulk / n);
+    benchmarks::report("addReservations (by value)", n, static_cast<double>(allocations), "allocations");
+  }
+}
+
+HOTEL_BENCHMARK(PlanningBoardSnapshots)
+{
+  // Taking a snapshot should not depend on the size of the board, keeping it up to date should be logarithmic
+  for (int n = 1000; n <= 64000; n *= 4)
+  {
+    std::mt19937 rng(42);
+    auto reservations = makeSingleRoomReservations(n, rng);
+
+    hotel::PlanningBoard board;
+    board.setSnapshotTrackingEnabled(true);
+    auto insert = benchmarks::measure(n, [&](int i) {
+      board.addReservation(std::make_unique<hotel::Reservation>(reservations[i]));
+    });
+    benchmarks::report("addReservation (tracked)", n, insert);
+
+    auto snapshot = benchmarks::measure(100000, [&](int) { benchmarks::doNotOptimize(board.snapshot().size()); });
+    benchmarks::report("snapshot", n, snapshot);
+
+    auto copy = benchmarks::measure(100, [&](int) {
+      hotel::PlanningBoard boardCopy;
+      boardCopy = board;
+      benchmarks::doNotOptimize(boardCopy.reservations().size());
+    });
+    benchmarks::report("operator= (deep copy)", n, copy);
+  }
+}
+
+HOTEL_BENCHMARK(AvailabilitySearch)
+{
+  // Ranked stay plans over a board in which each room is occupied about two thirds of the time
+  for (int rooms = 500; rooms <= 2000; rooms *= 2)
+  {
+    auto collection = makeSingleCategoryHotel(rooms);
+    std::mt19937 rng(42);
+    hotel::PlanningBoard board;
+    fillRooms(board, rooms, rng);
+
+    auto build = benchmarks::measure(1, [&](int) {
+      hotel::AvailabilitySearch search(collection, board);
+      benchmarks::doNotOptimize(search);
+    });
+    benchmarks::report("construction", rooms, build);
+
+    hotel::AvailabilitySearch search(collection, board);
+    std::uniform_int_distribution<> dayDist(0, 600);
+    for (int length : {7, 28})
+    {
+      for (int maxRoomChanges : {0, 2})
+      {
+        hotel::AvailabilitySearch::Query query;
+        query.categoryIds = {1};
+        query.maxRoomChanges = maxRoomChanges;
+        std::size_t plans = 0;
+        auto time = benchmarks::measure(1000, [&](int) {
+          auto from = origin + days(dayDist(rng));
+          query.period = date_period(from, from + days(length));
+          plans += search.search(query).size();
+        });
+        benchmarks::doNotOptimize(plans);
+        benchmarks::report("search (" + std::to_string(length) + " nights, up to " + std::to_string(maxRoomChanges) +
+                               " changes)",
+                           rooms, time);
+      }
+    }
+  }
+}
+
+HOTEL_BENCHMARK(PlanningOptimizer)
+{
+  // The orphaned nights which are left after spending the time budget, on a board with many short gaps
+  for (int rooms = 100; rooms <= 400; rooms *= 2)
+  {
+    auto collection = makeSingleCategoryHotel(rooms);
+    std::mt19937 rng(42);
+    hotel::PlanningBoard board;
+    fillRooms(board, rooms, rng);
+
+    auto build = benchmarks::measure(1, [&](int) {
+      hotel::PlanningOptimizer optimizer(collection, board);
+      benchmarks::doNotOptimize(optimizer);
+    });
+    benchmarks::report("construction", rooms, build);
+
+    hotel::PlanningOptimizer optimizer(collection, board);
+    for (int budget : {10, 100, 1000})
+    {
+      hotel::PlanningOptimizer::Options options;
+      options.budget = std::chrono::milliseconds(budget);
+      auto result = optimizer.optimize(options);
+      if (budget == 10)
+        benchmarks::report("orphaned nights before", rooms, result.orphanedNightsBefore, "nights");
+      benchmarks::report("orphaned nights after " + std::to_string(budget) + "ms", rooms, result.orphanedNightsAfter,
+                         "nights");
+    }
+  }
+}
+
+HOTEL_BENCHMARK(OccupancyAnalytics)
+{
+  // Occupied nights of the whole hotel over a month, compared to going through all reservations
+  for (int rooms = 500; rooms <= 2000; rooms *= 2)
+  {
+    auto collection = makeSingleCategoryHotel(rooms);
+    std::mt19937 rng(42);
+    hotel::PlanningBoard board;
+    fillRooms(board, rooms, rng);
+    auto reservations = static_cast<const hotel::PlanningBoard&>(board).reservations();
+
+    hotel::OccupancyAnalytics analytics(collection);
+    auto rebuild = benchmarks::measure(10, [&](int) { analytics.rebuild(reservations); });
+    benchmarks::report("rebuild", rooms, rebuild);
+
+    std::uniform_int_distribution<> dayDist(0, 700);
+    auto origin = hotel::Day::fromDate(date(2017, 1, 1));
+    int64_t nights = 0;
+    auto query = benchmarks::measure(100000, [&](int) {
+      auto from = origin + dayDist(rng);
+      nights += analytics.occupiedNightsInCategory(1, hotel::DayRange(from, from + 30));
+    });
+    benchmarks::report("range query", rooms, query);
+
+    auto scan = benchmarks::measure(10, [&](int) {
+      auto from = origin + dayDist(rng);
+      auto range = hotel::DayRange(from, from + 30);
+      for (auto reservation : reservations)
+        for (auto& atom : reservation->atoms())
+          nights += std::max(0, std::min(range.end(), atom.dayRange().end()) -
+                                    std::max(range.begin(), atom.dayRange().begin()));
+    });
+    benchmarks::report("scan of all reservations", rooms, scan);
+    benchmarks::doNotOptimize(nights);
+
+    auto update = benchmarks::measure(100000, [&](int i) {
+      auto from = origin + dayDist(rng);
+      analytics.addOccupancy(1, hotel::DayRange(from, from + 5), i % 2 == 0 ? 1 : -1);
+    });
+    benchmarks::report("update", rooms, update);
+  }
+}
@@ -0,0 +1,116 @@
+#include "benchmarks/benchmark.h"
+
+#include "persistence/sqlite/sqlitebackend.h"
+#include "persistence/sqlite/sqlitestorage.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  const char* databasePath = "benchmark.db";
+
+  //! Stores a hotel with the given number of rooms, each occupied about two thirds of the time over two years
+  void fillStorage(persistence::sqlite::SqliteStorage& storage, int rooms, std::mt19937& rng)
+  {
+    hotel::Hotel hotel("Hotel");
+    hotel.addRoomCategory(std::make_unique<hotel::RoomCategory>("STD", "Standard"));
+    for (int room = 1; room <= rooms; ++room)
+      hotel.addRoom(std::make_unique<hotel::HotelRoom>(std::to_string(room)), "STD");
+
+    storage.beginTransaction();
+    storage.storeNewHotel(hotel);
+    auto origin = hotel::Day::fromYmd(2017, 1, 1);
+    std::uniform_int_distribution<> lengthDist(1, 14);
+    for (auto& room : hotel.rooms())
+    {
+      for (int day = 0; day < 730; day += lengthDist(rng) / 2)
+      {
+        auto length = lengthDist(rng);
+        hotel::Reservation reservation("Reservation", room->id(), hotel::DayRange(origin + day, origin + day + length));
+        reservation.setStatus(hotel::Reservation::Confirmed);
+        storage.storeNewReservationAndAtoms(reservation);
+        day += length;
+      }
+    }
+    storage.commitTransaction();
+  }
+} // namespace
+
+HOTEL_BENCHMARK(SqliteStorage)
+{
+  for (int rooms = 50; rooms <= 200; rooms *= 2)
+  {
+    std::remove(databasePath);
+    std::mt19937 rng(42);
+    {
+      persistence::sqlite::SqliteStorage storage(databasePath);
+      fillStorage(storage, rooms, rng);
+    }
+
+    persistence::sqlite::SqliteStorage storage(databasePath);
+    std::vector<hotel::Reservation> reservations;
+    auto loadAll = benchmarks::measure(5, [&](int) { reservations = storage.loadAll<hotel::Reservation>(); });
+    benchmarks::report("load all reservations", rooms, loadAll);
+
+    // A month of the planning, found through the R*Tree instead of loading all reservations
+    std::uniform_int_distribution<> dayDist(0, 700);
+    auto origin = hotel::Day::fromYmd(2017, 1, 1);
+    auto loadInPeriod = benchmarks::measure(20, [&](int) {
+      auto from = origin + dayDist(rng);
+      benchmarks::doNotOptimize(storage.loadInPeriod<hotel::Reservation>(hotel::DayRange(from, from + 30)));
+    });
+    benchmarks::report("load reservations of a month", rooms, loadInPeriod);
+
+    std::uniform_int_distribution<std::size_t> reservationDist(0, reservations.size() - 1);
+    auto loadById = benchmarks::measure(200, [&](int) {
+      benchmarks::doNotOptimize(storage.loadById<hotel::Reservation>(reservations[reservationDist(rng)].id()));
+    });
+    benchmarks::report("load reservation by id", rooms, loadById);
+
+    storage.beginTransaction();
+    auto update = benchmarks::measure(200, [&](int) {
+      auto& reservation = reservations[reservationDist(rng)];
+      reservation.setNumberOfAdults(reservation.numberOfAdults() + 1);
+      storage.update(reservation);
+    });
+    storage.commitTransaction();
+    benchmarks::report("update reservation", rooms, update);
+  }
+  std::remove(databasePath);
+}
+
+HOTEL_BENCHMARK(SqliteBackend)
+{
+  // Many clients which each store one reservation at a time, as the server sees them
+  const int operationsPerWriter = 200;
+  for (int writers = 1; writers <= 64; writers *= 4)
+  {
+    std::remove(databasePath);
+    persistence::sqlite::SqliteBackend backend(databasePath);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int writer = 0; writer < writers; ++writer)
+    {
+      threads.emplace_back([&backend, writer]() {
+        auto origin = hotel::Day::fromYmd(2017, 1, 1);
+        for (int i = 0; i < operationsPerWriter; ++i)
+        {
+          auto reservation = std::make_unique<hotel::Reservation>("Reservation", writer + 1,
+                                                                  hotel::DayRange(origin + 7 * i, origin + 7 * i + 5));
+          backend.queueOperation(persistence::op::StoreNew{std::move(reservation)}).wait();
+        }
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+    auto end = std::chrono::steady_clock::now();
+    benchmarks::report("store reservation (concurrent writers)", writers,
+                       std::chrono::duration<double, std::nano>(end - start).count() /
+                           (writers * operationsPerWriter));
+  }
+  std::remove(databasePath);
+}
@@ -0,0 +1,68 @@
+#include "benchmarks/benchmark.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace benchmarks
+{
+  namespace
+  {
+    std::atomic<std::size_t> allocations{0};
+
+    std::vector<std::pair<const char*, void (*)()>>& registeredBenchmarks()
+    {
+      static std::vector<std::pair<const char*, void (*)()>> benchmarks;
+      return benchmarks;
+    }
+  } // namespace
+
+  Registration::Registration(const char* name, void (*function)())
+  {
+    registeredBenchmarks().emplace_back(name, function);
+  }
+
+  void report(const std::string& name, int n, double value, const char* unit)
+  {
+    std::printf("  %-40s n=%-9d %12.1f %s\n", name.c_str(), n, value, unit);
+  }
+
+  std::size_t allocationCount() { return allocations.load(std::memory_order_relaxed); }
+
+} // namespace benchmarks
+
+// Count all allocations made through the global operator new (operator new[] forwards to this one)
+void* operator new(std::size_t size)
+{
+  benchmarks::allocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto memory = std::malloc(size == 0 ? 1 : size))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+/**
+ * Runs all registered benchmarks. If arguments are given, only the benchmarks whose name contains one of the arguments
+ * are run.
+ */
+int main(int argc, char** argv)
+{
+  for (auto& [name, function] : benchmarks::registeredBenchmarks())
+  {
+    bool selected = argc < 2;
+    for (int i = 1; i < argc; ++i)
+      selected = selected || std::strstr(name, argv[i]) != nullptr;
+    if (!selected)
+      continue;
+
+    std::printf("%s\n", name);
+    function();
+  }
+  return 0;
+}
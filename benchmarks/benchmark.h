@@ -0,0 +1,59 @@
+#ifndef BENCHMARKS_BENCHMARK_H
+#define BENCHMARKS_BENCHMARK_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace benchmarks
+{
+  /**
+   * @brief The Registration struct adds a benchmark function to the global list of benchmarks
+   *
+   * Use the HOTEL_BENCHMARK macro instead of instantiating this struct directly.
+   */
+  struct Registration
+  {
+    Registration(const char* name, void (*function)());
+  };
+
+  /**
+   * @brief measure runs the given function a number of times and returns the average duration of one run
+   * @return the average duration in nanoseconds
+   */
+  template <class Fn> double measure(int iterations, Fn&& fn)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+      fn(i);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+  }
+
+  /**
+   * @brief report prints a single measurement in a uniform format
+   * @param name the name of the measured operation
+   * @param n the problem size the measurement was taken at
+   * @param value the measured value, by default the average duration of one operation in nanoseconds
+   * @param unit the unit of the measured value
+   */
+  void report(const std::string& name, int n, double value, const char* unit = "ns/op");
+
+  /**
+   * @brief allocationCount returns the number of calls to the global operator new since the start of the program
+   */
+  std::size_t allocationCount();
+
+  /**
+   * @brief doNotOptimize prevents the compiler from optimizing away the computation of the given value
+   */
+  template <class T> void doNotOptimize(const T& value) { asm volatile("" : : "r,m"(value) : "memory"); }
+
+} // namespace benchmarks
+
+#define HOTEL_BENCHMARK(name)                                                                                          \
+  static void benchmark_##name();                                                                                      \
+  static benchmarks::Registration registration_##name(#name, &benchmark_##name);                                       \
+  static void benchmark_##name()
+
+#endif // BENCHMARKS_BENCHMARK_H
@@ -3,6 +3,8 @@
 #include <QtGui/QKeyEvent>
 #include <QtWidgets/QGridLayout>
 
+#include <algorithm>
+
 namespace gui
 {
   PlanningWidget::PlanningWidget(persistence::Backend& backend)
@@ -49,6 +51,14 @@ namespace gui
     _hotelsStream.itemsRemovedSignal.connect(
         boost::bind(&PlanningWidget::hotelsRemoved, this, boost::placeholders::_1));
     _hotelsStream.allItemsRemovedSignal.connect(boost::bind(&PlanningWidget::allHotelsRemoved, this));
+    _archiveStream.itemsAddedSignal.connect(
+        boost::bind(&PlanningWidget::archivedReservationsChanged, this, boost::placeholders::_1));
+    _archiveStream.itemsUpdatedSignal.connect(
+        boost::bind(&PlanningWidget::archivedReservationsChanged, this, boost::placeholders::_1));
+    _archiveStream.itemsRemovedSignal.connect(
+        boost::bind(&PlanningWidget::archivedReservationsRemoved, this, boost::placeholders::_1));
+    _archiveStream.allItemsRemovedSignal.connect(boost::bind(&PlanningWidget::allArchivedReservationsRemoved, this));
+    connect(_horizontalScrollbar, &QScrollBar::valueChanged, this, [this]() { loadVisibleArchive(); });
     _context.reservationDoubleClickedSignal().connect(
         boost::bind(&PlanningWidget::emitReservationDoubleClicked, this, boost::placeholders::_1));
 
@@ -89,6 +99,7 @@ namespace gui
     // TODO: This should not update the whole layout!
     _context.setPivotDate(pivotDate);
     updateLayout();
+    loadVisibleArchive();
     emit pivotDateChanged(pivotDate);
   }
 
@@ -114,11 +125,7 @@ namespace gui
 
   void PlanningWidget::reservationsAdded(const std::vector<hotel::Reservation>& reservations)
   {
-    for (auto& reservation : reservations)
-    {
-      auto reservationPtr = _context.addReservation(reservation);
-      _planningBoard->addReservation(reservationPtr);
-    }
+    _planningBoard->addReservations(_context.addReservations(reservations));
     updateDateRange();
   }
 
@@ -191,6 +198,103 @@ namespace gui
     updateLayout();
   }
 
+  hotel::DayRange PlanningWidget::visibleArchiveRange() const
+  {
+    auto& layout = _context.layout();
+    auto visibleRect = _planningBoard->mapToScene(_planningBoard->viewport()->rect()).boundingRect();
+    auto first = hotel::Day::fromDate(layout.getNearestDatePosition(static_cast<int>(visibleRect.left())).first);
+    auto last = hotel::Day::fromDate(layout.getNearestDatePosition(static_cast<int>(visibleRect.right())).first);
+    auto width = std::max(last - first, 1);
+    return hotel::DayRange(first - width, last + width + 1);
+  }
+
+  void PlanningWidget::loadVisibleArchive()
+  {
+    // The archive stream is extended over the parts of the range which have not been loaded yet, the backend then only
+    // sends the reservations entering it. The stream stays open, so that changes to the archived reservations are
+    // received as well.
+    auto missingRanges = _archive.missingRanges(visibleArchiveRange());
+    if (!missingRanges.empty())
+    {
+      auto range = hotel::DayRange(missingRanges.front().begin(), missingRanges.back().end());
+      if (!_archiveStreamRange.isEmpty())
+        range = hotel::DayRange(std::min(range.begin(), _archiveStreamRange.begin()),
+                                std::max(range.end(), _archiveStreamRange.end()));
+      nlohmann::json options = {{"from", boost::gregorian::to_iso_extended_string(range.begin().toDate())},
+                                {"to", boost::gregorian::to_iso_extended_string(range.end().toDate())}};
+      if (_archiveStreamRange.isEmpty())
+        _archiveStream.connect(_context.dataBackend(), "reservation.archived", options);
+      else
+        _archiveStream._streamHandle.changeOptions(options);
+      _archiveStreamRange = range;
+      _archive.markLoaded(range);
+    }
+
+    showVisibleArchivedReservations();
+  }
+
+  void PlanningWidget::showVisibleArchivedReservations()
+  {
+    auto visible = _archive.getReservationsInRange(visibleArchiveRange());
+
+    // Take reservations which were scrolled out of view off the board
+    std::unordered_set<int> visibleIds;
+    for (auto& reservation : visible)
+      visibleIds.insert(reservation.id());
+    std::vector<int> hiddenIds;
+    for (auto id : _shownArchivedReservations)
+      if (visibleIds.count(id) == 0)
+        hiddenIds.push_back(id);
+    hideArchivedReservations(hiddenIds);
+
+    visible.erase(std::remove_if(visible.begin(), visible.end(),
+                                 [this](const hotel::Reservation& reservation) {
+                                   return _shownArchivedReservations.count(reservation.id()) != 0;
+                                 }),
+                  visible.end());
+    if (visible.empty())
+      return;
+
+    auto added = _context.addReservations(visible);
+    for (auto reservation : added)
+      _shownArchivedReservations.insert(reservation->id());
+    _planningBoard->addReservations(added);
+  }
+
+  void PlanningWidget::hideArchivedReservations(const std::vector<int>& ids)
+  {
+    for (auto reservationId : ids)
+    {
+      if (_shownArchivedReservations.erase(reservationId) == 0)
+        continue;
+      _planningBoard->removeReservation(reservationId);
+      _context.removeReservation(reservationId);
+    }
+  }
+
+  void PlanningWidget::archivedReservationsChanged(const std::vector<hotel::Reservation>& reservations)
+  {
+    std::vector<int> ids;
+    for (auto& reservation : reservations)
+      ids.push_back(reservation.id());
+    hideArchivedReservations(ids);
+    _archive.add(reservations);
+    showVisibleArchivedReservations();
+  }
+
+  void PlanningWidget::archivedReservationsRemoved(const std::vector<int>& ids)
+  {
+    hideArchivedReservations(ids);
+    _archive.remove(ids);
+  }
+
+  void PlanningWidget::allArchivedReservationsRemoved()
+  {
+    // The stream stays connected, so the range it covers remains loaded
+    hideArchivedReservations(std::vector<int>(_shownArchivedReservations.begin(), _shownArchivedReservations.end()));
+    _archive.clear();
+  }
+
   void PlanningWidget::updateDateRange()
   {
     auto pivotDate = _context.layout().pivotDate();
@@ -198,8 +302,10 @@ namespace gui
     planningExtent = _context.planning().getPlanningExtent();
 
     // Extend the date range so that it starts one week prior to the first reservation and extends for at least one year
+    // The range also reaches one year into the past, so that archived reservations can be browsed
     auto dateRange = planningExtent.merge(boost::gregorian::date_period(
         planningExtent.begin() + boost::gregorian::days(-7), planningExtent.begin() + boost::gregorian::days(365)));
+    dateRange = dateRange.merge(boost::gregorian::date_period(pivotDate + boost::gregorian::days(-365), pivotDate));
 
     // Apply the scene size
     auto& layout = _context.layout();
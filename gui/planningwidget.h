@@ -13,6 +13,7 @@
 #include "hotel/hotel.h"
 #include "hotel/hotelcollection.h"
 #include "hotel/planning.h"
+#include "hotel/reservationarchive.h"
 
 #include <QtCore/QObject>
 #include <QtWidgets/QScrollBar>
@@ -22,6 +23,7 @@
 #include <boost/signals2.hpp>
 
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
 namespace gui
@@ -72,6 +74,23 @@ namespace gui
     void hotelsRemoved(const std::vector<int>& ids);
     void allHotelsRemoved();
 
+    // Archived reservations are not part of the reservation stream. They are loaded on demand, once the visible dates
+    // reach a range of the archive which has not been loaded yet, and only the visible ones are put on the board.
+    hotel::ReservationArchive _archive;
+    //! A single stream covers the loaded ranges, it grows to the hull of the loaded ranges as more of them are loaded
+    DataStreamObserverAdapter<hotel::Reservation> _archiveStream;
+    hotel::DayRange _archiveStreamRange;
+    std::unordered_set<int> _shownArchivedReservations;
+
+    //! Returns the visible dates, extended by the width of the view on both sides
+    hotel::DayRange visibleArchiveRange() const;
+    void loadVisibleArchive();
+    void showVisibleArchivedReservations();
+    void hideArchivedReservations(const std::vector<int>& ids);
+    void archivedReservationsChanged(const std::vector<hotel::Reservation>& reservations);
+    void archivedReservationsRemoved(const std::vector<int>& ids);
+    void allArchivedReservationsRemoved();
+
     // Widgets
     QScrollBar* _verticalScrollbar;
     QScrollBar* _horizontalScrollbar;
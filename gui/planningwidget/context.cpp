@@ -43,6 +43,30 @@ namespace gui
       return _reservations.addReservation(std::make_unique<hotel::Reservation>(reservation));
     }
 
+    std::vector<const hotel::Reservation*> Context::addReservations(const std::vector<hotel::Reservation>& reservations)
+    {
+      for (auto& reservation : reservations)
+        assert(reservation.id() != 0);
+
+      // Reservations which conflict with the planning are skipped, and only the added ones are reported to the tool
+      auto added = _reservations.addReservations(reservations);
+      std::vector<const hotel::Reservation*> result;
+      result.reserve(added.size());
+      for (std::size_t i = 0; i < added.size(); ++i)
+      {
+        if (added[i] == nullptr)
+        {
+          std::cerr << "addReservations(): reservation " << reservations[i].id()
+                    << " conflicts with the planning and has been skipped." << std::endl;
+          continue;
+        }
+        if (_activeTool)
+          _activeTool->reservationAdded(*added[i]);
+        result.push_back(added[i]);
+      }
+      return result;
+    }
+
     void Context::removeHotel(int hotelId)
     {
       _hotels.erase(std::remove_if(_hotels.begin(), _hotels.end(), [=](auto& hotel) { return hotel->id() == hotelId; }),
@@ -53,6 +53,7 @@ namespace gui
       // Modifying data calls
       void addHotel(const hotel::Hotel& hotel);
       const hotel::Reservation* addReservation(const hotel::Reservation& reservation);
+      std::vector<const hotel::Reservation*> addReservations(const std::vector<hotel::Reservation>& reservations);
       void removeHotel(int hotelId);
       void removeReservation(int reservationId);
 
@@ -14,6 +14,7 @@ namespace gui
     PlanningBoardLayout::PlanningBoardLayout()
     {
       _originDate = boost::gregorian::day_clock::local_day();
+      _originDay = hotel::Day::fromDate(_originDate);
       _pivotDate = _originDate;
       _roomRowHeight = 22;
       _dateColumnWidth = 26;
@@ -48,12 +49,7 @@ namespace gui
           {
             bool isEven = true;
 
-            std::vector<hotel::HotelRoom*> roomsInCategory;
-            for (auto& hotelInner : hotels)
-              for (auto& room : hotelInner->rooms())
-                if (room->category()->id() == category->id())
-                  roomsInCategory.push_back(room.get());
-
+            auto& roomsInCategory = hotel->getRoomsByCategory(category.get());
             for (auto& room : roomsInCategory)
             {
               appendRoomRow(isEven, room->id());
@@ -73,8 +69,13 @@ namespace gui
 
     QRectF PlanningBoardLayout::getAtomRect(int roomId, boost::gregorian::date_period dateRange) const
     {
-      auto pos = getDatePositionX(dateRange.begin());
-      auto width = dateRange.length().days() * _dateColumnWidth - 1;
+      return getAtomRect(roomId, hotel::DayRange::fromPeriod(dateRange));
+    }
+
+    QRectF PlanningBoardLayout::getAtomRect(int roomId, hotel::DayRange dayRange) const
+    {
+      auto pos = getDatePositionX(dayRange.begin());
+      auto width = dayRange.length() * _dateColumnWidth - 1;
 
       auto row = getRowGeometryForRoom(roomId);
       int y = row != nullptr ? row->top() : 0;
@@ -87,6 +88,8 @@ namespace gui
       return (date - _originDate).days() * _dateColumnWidth;
     }
 
+    int PlanningBoardLayout::getDatePositionX(hotel::Day day) const { return (day - _originDay) * _dateColumnWidth; }
+
     const PlanningBoardRowGeometry* PlanningBoardLayout::getRowGeometryForRoom(int roomId) const
     {
       for (auto& row : _rows)
@@ -1,6 +1,7 @@
 #ifndef GUI_PLANNINGBOARDLAYOUT_H
 #define GUI_PLANNINGBOARDLAYOUT_H
 
+#include "hotel/day.h"
 #include "hotel/hotel.h"
 #include "hotel/hotelcollection.h"
 
@@ -156,9 +157,11 @@ namespace gui
       //! @brief getAtomRect produces the rectangle for the given room and date on the virtual planning board
       //! If the room does not exist, a zero height rectangle is returned
       QRectF getAtomRect(int roomId, boost::gregorian::date_period dateRange) const;
+      QRectF getAtomRect(int roomId, hotel::DayRange dayRange) const;
 
       //! @brief getPositionX returns the x coordiante associated to the given date, w.r.t. the layout's origin date
       int getDatePositionX(boost::gregorian::date date) const;
+      int getDatePositionX(hotel::Day day) const;
 
       const PlanningBoardRowGeometry* getRowGeometryForRoom(int roomId) const;
 
@@ -194,6 +197,7 @@ namespace gui
       // The date which will correspond to the x=0 line. This value does not represent the currently selected date, it
       // is only used for setting a coordinate system, in which to place the reservations.
       boost::gregorian::date _originDate;
+      hotel::Day _originDay;
 
       void appendRoomRow(bool isEven, int roomId);
       void appendSeparatorRow(int separatorHeight);
@@ -23,7 +23,7 @@ namespace gui
 
       auto atom = _reservation->atomAtIndex(_atomIndex);
       if (atom != nullptr)
-        itemRect = _context->layout().getAtomRect(atom->roomId(), atom->dateRange());
+        itemRect = _context->layout().getAtomRect(atom->roomId(), atom->dayRange());
 
       setRect(itemRect);
     }
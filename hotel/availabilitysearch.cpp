@@ -0,0 +1,244 @@
+#include "hotel/availabilitysearch.h"
+
+#include "hotel/hotelcollection.h"
+#include "hotel/planning.h"
+#include "hotel/planningsnapshot.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <map>
+
+namespace hotel
+{
+  namespace
+  {
+    // The free runs before the first and after the last reservation of a room are bounded by these days
+    constexpr Day UnboundedBegin = Day(std::numeric_limits<int32_t>::min());
+    constexpr Day UnboundedEnd = Day(std::numeric_limits<int32_t>::max());
+
+    //! Returns the length of the gap from a to b, if it is too short to be sold on its own, otherwise 0
+    int orphanedNights(Day a, Day b, int minimumStay)
+    {
+      if (a == UnboundedBegin || b == UnboundedEnd)
+        return 0;
+      auto gap = b - a;
+      return gap > 0 && gap < minimumStay ? gap : 0;
+    }
+  } // namespace
+
+  Reservation AvailabilitySearch::Plan::toReservation(const std::string& description) const
+  {
+    if (segments.empty())
+      return Reservation(description);
+
+    Reservation reservation(description, segments.front().roomId, segments.front().range);
+    for (auto it = segments.begin() + 1; it != segments.end(); ++it)
+      reservation.addContinuation(it->roomId, it->range.end());
+    return reservation;
+  }
+
+  /**
+   * @brief The SearchState class holds the intermediate results of a single query
+   *
+   * Plans are built depth first, one segment at a time. The rooms which are free on a given day are only computed once
+   * per query, since many partial plans change rooms on the same days.
+   */
+  class AvailabilitySearch::SearchState
+  {
+  public:
+    SearchState(const Query& query, DayRange range, std::vector<Candidate> runs)
+        : _query(query), _range(range), _runs(std::move(runs))
+    {
+    }
+
+    //! Returns the best plans with exactly the given number of room changes
+    std::vector<Plan> findPlans(int roomChanges, std::size_t maxPlans)
+    {
+      _plans.clear();
+      _maxPlans = maxPlans;
+      extend(_range.begin(), roomChanges, 0);
+      return std::move(_plans);
+    }
+
+  private:
+    void extend(Day day, int remainingChanges, int orphaned)
+    {
+      // Segments can only add orphaned nights, so this branch cannot improve on any of the collected plans
+      if (_plans.size() == _maxPlans && orphaned >= _plans.back().orphanedNights)
+        return;
+
+      if (remainingChanges == 0)
+      {
+        for (auto& candidate : candidatesAt(day))
+        {
+          if (candidate.run.end() < _range.end())
+            continue;
+          auto total = orphaned + orphanedNights(candidate.run.begin(), day, _query.minimumStay) +
+                       orphanedNights(_range.end(), candidate.run.end(), _query.minimumStay);
+          _path.push_back(Segment{candidate.room->id, DayRange(day, _range.end())});
+          addPlan(total);
+          _path.pop_back();
+        }
+        return;
+      }
+
+      // Each room is used until it is occupied, the room change happens on that day
+      for (auto& candidate : branchesAt(day))
+      {
+        _path.push_back(Segment{candidate.room->id, DayRange(day, candidate.run.end())});
+        extend(candidate.run.end(), remainingChanges - 1,
+               orphaned + orphanedNights(candidate.run.begin(), day, _query.minimumStay));
+        _path.pop_back();
+      }
+    }
+
+    void addPlan(int orphaned)
+    {
+      if (_plans.size() == _maxPlans && orphaned >= _plans.back().orphanedNights)
+        return;
+
+      // Keep the plans sorted, plans found first win ties
+      auto it = std::upper_bound(_plans.begin(), _plans.end(), orphaned,
+                                 [](int value, const Plan& plan) { return value < plan.orphanedNights; });
+      _plans.insert(it, Plan{_path, orphaned});
+      if (_plans.size() > _maxPlans)
+        _plans.pop_back();
+    }
+
+    //! Returns all rooms which are free on the given day
+    const std::vector<Candidate>& candidatesAt(Day day)
+    {
+      auto it = _candidates.find(day);
+      if (it != _candidates.end())
+        return it->second;
+
+      std::vector<Candidate> candidates;
+      for (auto& candidate : _runs)
+        if (candidate.run.contains(day))
+          candidates.push_back(candidate);
+      return _candidates.emplace(day, std::move(candidates)).first->second;
+    }
+
+    //! Returns the rooms which are free on the given day, but not until the end of the stay, furthest reaching first
+    const std::vector<Candidate>& branchesAt(Day day)
+    {
+      auto it = _branches.find(day);
+      if (it != _branches.end())
+        return it->second;
+
+      std::vector<Candidate> branches;
+      for (auto& candidate : candidatesAt(day))
+        if (candidate.run.end() < _range.end())
+          branches.push_back(candidate);
+      auto count = std::min(branches.size(), static_cast<std::size_t>(std::max(0, _query.maxCandidatesPerChange)));
+      std::partial_sort(branches.begin(), branches.begin() + count, branches.end(),
+                        [](const Candidate& a, const Candidate& b) { return a.run.end() > b.run.end(); });
+      branches.resize(count);
+      return _branches.emplace(day, std::move(branches)).first->second;
+    }
+
+    const Query& _query;
+    DayRange _range;
+    // The free runs of the eligible rooms which overlap the stay
+    std::vector<Candidate> _runs;
+
+    std::map<Day, std::vector<Candidate>> _candidates;
+    std::map<Day, std::vector<Candidate>> _branches;
+
+    std::vector<Segment> _path;
+    std::vector<Plan> _plans;
+    std::size_t _maxPlans = 0;
+  };
+
+  AvailabilitySearch::AvailabilitySearch(const HotelCollection& hotels, const PlanningBoard& planning,
+                                         RoomCapacity roomCapacity)
+  {
+    OccupiedRanges occupied;
+    for (auto reservation : planning.reservations())
+      for (auto& atom : reservation->atoms())
+        occupied[atom.roomId()].push_back(atom.dayRange());
+    buildIndex(hotels, std::move(occupied), roomCapacity);
+  }
+
+  AvailabilitySearch::AvailabilitySearch(const HotelCollection& hotels, const PlanningSnapshot& planning,
+                                         RoomCapacity roomCapacity)
+  {
+    OccupiedRanges occupied;
+    planning.forEachReservation([&occupied](const Reservation* reservation) {
+      for (auto& atom : reservation->atoms())
+        occupied[atom.roomId()].push_back(atom.dayRange());
+    });
+    buildIndex(hotels, std::move(occupied), roomCapacity);
+  }
+
+  std::vector<AvailabilitySearch::Plan> AvailabilitySearch::search(const Query& query) const
+  {
+    auto range = DayRange::fromPeriod(query.period);
+    if (range.isEmpty() || query.maxPlans <= 0)
+      return {};
+
+    // Plans can only use the free runs which overlap the stay, the first of them is the last one beginning on or before
+    // the first night
+    std::vector<Candidate> runs;
+    for (auto categoryId : query.categoryIds)
+    {
+      auto it = _roomsByCategory.find(categoryId);
+      if (it == _roomsByCategory.end())
+        continue;
+      for (auto index : it->second)
+      {
+        auto& room = _rooms[index];
+        if (room.capacity < query.partySize)
+          continue;
+        auto first = _freeRuns.begin() + room.firstRun;
+        auto end = _freeRuns.begin() + room.endRun;
+        auto run = std::prev(std::upper_bound(first + 1, end, range.begin(),
+                                              [](Day day, DayRange run) { return day < run.begin(); }));
+        for (; run != end && run->begin() < range.end(); ++run)
+          if (run->end() > range.begin())
+            runs.push_back(Candidate{&room, *run});
+      }
+    }
+
+    SearchState state(query, range, std::move(runs));
+    std::vector<Plan> result;
+    auto maxPlans = static_cast<std::size_t>(query.maxPlans);
+    for (int roomChanges = 0; roomChanges <= query.maxRoomChanges && result.size() < maxPlans; ++roomChanges)
+    {
+      auto plans = state.findPlans(roomChanges, maxPlans - result.size());
+      std::move(plans.begin(), plans.end(), std::back_inserter(result));
+    }
+    return result;
+  }
+
+  void AvailabilitySearch::buildIndex(const HotelCollection& hotels, OccupiedRanges occupied,
+                                      const RoomCapacity& roomCapacity)
+  {
+    for (auto& hotel : hotels.hotels())
+      for (auto& hotelRoom : hotel->rooms())
+      {
+        Room room{hotelRoom->id(), roomCapacity ? roomCapacity(*hotelRoom) : std::numeric_limits<int>::max(),
+                  _freeRuns.size(), 0};
+
+        // The free runs are the gaps between the occupied ranges
+        auto& ranges = occupied[room.id];
+        std::sort(ranges.begin(), ranges.end(), [](DayRange a, DayRange b) { return a.begin() < b.begin(); });
+        auto freeFrom = UnboundedBegin;
+        for (auto& range : ranges)
+        {
+          if (freeFrom < range.begin())
+            _freeRuns.emplace_back(freeFrom, range.begin());
+          freeFrom = std::max(freeFrom, range.end());
+        }
+        _freeRuns.emplace_back(freeFrom, UnboundedEnd);
+        room.endRun = _freeRuns.size();
+
+        if (hotelRoom->category() != nullptr)
+          _roomsByCategory[hotelRoom->category()->id()].push_back(_rooms.size());
+        _rooms.push_back(room);
+      }
+  }
+
+} // namespace hotel
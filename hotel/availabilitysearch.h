@@ -0,0 +1,120 @@
+#ifndef HOTEL_AVAILABILITYSEARCH_H
+#define HOTEL_AVAILABILITYSEARCH_H
+
+#include "hotel/day.h"
+#include "hotel/reservation.h"
+
+#include <boost/date_time.hpp>
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hotel
+{
+  class HotelCollection;
+  class HotelRoom;
+  class PlanningBoard;
+  class PlanningSnapshot;
+
+  /**
+   * @brief The AvailabilitySearch class finds ways to accommodate a stay, possibly with room changes
+   *
+   * On construction, the free nights of every room are collected into a sorted list of free runs. A query first
+   * collects the free runs of the eligible rooms which overlap the stay, with one binary search per room. All further
+   * questions of the form "which rooms are free on this day, and for how long" are answered from that short list.
+   * Plans are searched with an increasing number of room changes, so plans without room changes are always found first
+   * and plans with many room changes are only looked for if there are not enough simpler ones.
+   *
+   * The search works on the state of the planning at construction time. The object is immutable afterwards, so any
+   * number of threads may run queries at the same time.
+   */
+  class AvailabilitySearch
+  {
+  public:
+    //! Returns the number of guests a room can accommodate
+    typedef std::function<int(const HotelRoom&)> RoomCapacity;
+
+    struct Query
+    {
+      //! Only rooms of these categories are considered
+      std::vector<int> categoryIds;
+      boost::gregorian::date_period period = boost::gregorian::date_period(boost::gregorian::date(),
+                                                                           boost::gregorian::date());
+      int partySize = 1;
+      int maxRoomChanges = 0;
+      int maxPlans = 10;
+      //! Free gaps shorter than this are hard to sell, and count as orphaned nights when a plan leaves them behind
+      int minimumStay = 3;
+      //! Limits the number of rooms which are tried before each room change
+      int maxCandidatesPerChange = 16;
+    };
+
+    struct Segment
+    {
+      int roomId;
+      DayRange range;
+    };
+
+    struct Plan
+    {
+      std::vector<Segment> segments;
+      //! The number of free nights next to the plan which it would leave in gaps shorter than Query::minimumStay
+      int orphanedNights = 0;
+
+      int roomChanges() const { return static_cast<int>(segments.size()) - 1; }
+      Reservation toReservation(const std::string& description) const;
+    };
+
+    /**
+     * @brief Builds the search for the given rooms and reservations
+     * @param roomCapacity returns the capacity of each room. If it is not set, every room fits any party.
+     */
+    AvailabilitySearch(const HotelCollection& hotels, const PlanningBoard& planning, RoomCapacity roomCapacity = {});
+    AvailabilitySearch(const HotelCollection& hotels, const PlanningSnapshot& planning, RoomCapacity roomCapacity = {});
+
+    /**
+     * @brief search returns the best plans to accommodate the party during the whole period of the query
+     *
+     * Plans are ranked by the number of room changes first, and by the number of orphaned nights second. Each room is
+     * used for as long as it is free before changing to the next one.
+     *
+     * @return at most query.maxPlans plans, best plan first. The result is empty if the stay cannot be accommodated
+     *         with the allowed number of room changes.
+     */
+    std::vector<Plan> search(const Query& query) const;
+
+  private:
+    struct Room
+    {
+      int id;
+      int capacity;
+      //! The free runs of the room are _freeRuns[firstRun] up to, but not including, _freeRuns[endRun]
+      std::size_t firstRun;
+      std::size_t endRun;
+    };
+
+    //! A free run of a room
+    struct Candidate
+    {
+      const Room* room;
+      DayRange run;
+    };
+
+    class SearchState;
+
+    typedef std::unordered_map<int, std::vector<DayRange>> OccupiedRanges;
+    void buildIndex(const HotelCollection& hotels, OccupiedRanges occupied, const RoomCapacity& roomCapacity);
+
+    std::vector<Room> _rooms;
+    // The sorted, disjoint free runs of all rooms, stored room after room. The first and last run of each room are
+    // unbounded.
+    std::vector<DayRange> _freeRuns;
+    // Indices into _rooms, so that the search can be copied
+    std::unordered_map<int, std::vector<std::size_t>> _roomsByCategory;
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_AVAILABILITYSEARCH_H
@@ -0,0 +1,160 @@
+#ifndef HOTEL_DAY_H
+#define HOTEL_DAY_H
+
+#include <boost/date_time.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+namespace hotel
+{
+  /**
+   * @brief The Day class represents a single calendar day as a 32 bit day number
+   *
+   * Day 0 is 1970-01-01. The class is trivially copyable and all of its arithmetic is constexpr, which makes it much
+   * cheaper than boost::gregorian::date inside of the data structures of the planning. Conversions to and from boost
+   * are only meant to happen at the boundaries of the API.
+   *
+   * @see DayRange
+   */
+  class Day
+  {
+  public:
+    constexpr Day() = default;
+    constexpr explicit Day(int32_t number) : _number(number) {}
+
+    //! Creates the day from a proleptic gregorian calendar date
+    static constexpr Day fromYmd(int year, int month, int day)
+    {
+      // See http://howardhinnant.github.io/date_algorithms.html (days_from_civil)
+      year -= month <= 2;
+      const int era = (year >= 0 ? year : year - 399) / 400;
+      const int yearOfEra = year - era * 400;
+      const int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+      const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+      return Day(era * 146097 + dayOfEra - 719468);
+    }
+
+    /**
+     * @brief fromDate converts a boost date into a day
+     * @throw std::invalid_argument if the date is a special value (e.g. not_a_date_time)
+     */
+    static Day fromDate(boost::gregorian::date date)
+    {
+      if (date.is_special())
+        throw std::invalid_argument("cannot convert special date value to a day");
+      return Day(static_cast<int32_t>(date.day_number()) - EpochDayNumber);
+    }
+
+    boost::gregorian::date toDate() const
+    {
+      return boost::gregorian::date(1970, 1, 1) + boost::gregorian::days(_number);
+    }
+
+    constexpr int32_t number() const { return _number; }
+
+    //! Returns the day of the week, from 0 (Sunday) to 6 (Saturday), as boost::gregorian::greg_weekday does
+    constexpr int weekday() const { return _number >= -4 ? (_number + 4) % 7 : (_number + 5) % 7 + 6; }
+    constexpr int year() const { return civil().year; }
+    //! Returns the month, from 1 (January) to 12 (December)
+    constexpr int month() const { return civil().month; }
+    //! Returns the day of the month, starting at 1
+    constexpr int dayOfMonth() const { return civil().day; }
+
+    constexpr Day& operator+=(int days)
+    {
+      _number += days;
+      return *this;
+    }
+    constexpr Day& operator-=(int days)
+    {
+      _number -= days;
+      return *this;
+    }
+    constexpr Day& operator++() { return *this += 1; }
+    constexpr Day& operator--() { return *this -= 1; }
+
+  private:
+    // The julian day number of 1970-01-01, as returned by boost::gregorian::date::day_number()
+    static constexpr int32_t EpochDayNumber = 2440588;
+
+    struct Civil
+    {
+      int year;
+      int month;
+      int day;
+    };
+
+    constexpr Civil civil() const
+    {
+      // See http://howardhinnant.github.io/date_algorithms.html (civil_from_days)
+      const int z = _number + 719468;
+      const int era = (z >= 0 ? z : z - 146096) / 146097;
+      const int dayOfEra = z - era * 146097;
+      const int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+      const int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+      const int mp = (5 * dayOfYear + 2) / 153;
+      const int day = dayOfYear - (153 * mp + 2) / 5 + 1;
+      const int month = mp < 10 ? mp + 3 : mp - 9;
+      return Civil{yearOfEra + era * 400 + (month <= 2), month, day};
+    }
+
+    int32_t _number = 0;
+  };
+
+  constexpr Day operator+(Day day, int days) { return day += days; }
+  constexpr Day operator-(Day day, int days) { return day -= days; }
+  //! Returns the number of days from b to a
+  constexpr int operator-(Day a, Day b) { return a.number() - b.number(); }
+
+  constexpr bool operator==(Day a, Day b) { return a.number() == b.number(); }
+  constexpr bool operator!=(Day a, Day b) { return a.number() != b.number(); }
+  constexpr bool operator<(Day a, Day b) { return a.number() < b.number(); }
+  constexpr bool operator<=(Day a, Day b) { return a.number() <= b.number(); }
+  constexpr bool operator>(Day a, Day b) { return a.number() > b.number(); }
+  constexpr bool operator>=(Day a, Day b) { return a.number() >= b.number(); }
+
+  /**
+   * @brief The DayRange class represents the nights from begin up to, but not including, end
+   *
+   * This is the equivalent of boost::gregorian::date_period. A range whose end is not after its begin is empty.
+   */
+  class DayRange
+  {
+  public:
+    constexpr DayRange() = default;
+    constexpr DayRange(Day begin, Day end) : _begin(begin), _end(end) {}
+
+    static DayRange fromPeriod(boost::gregorian::date_period period)
+    {
+      return DayRange(Day::fromDate(period.begin()), Day::fromDate(period.end()));
+    }
+    boost::gregorian::date_period toPeriod() const
+    {
+      return boost::gregorian::date_period(_begin.toDate(), _end.toDate());
+    }
+
+    constexpr Day begin() const { return _begin; }
+    constexpr Day end() const { return _end; }
+    constexpr int length() const { return _end - _begin; }
+    constexpr bool isEmpty() const { return _end <= _begin; }
+
+    constexpr bool contains(Day day) const { return _begin <= day && day < _end; }
+    //! Returns true if both ranges share at least one night. Empty ranges never intersect.
+    constexpr bool intersects(DayRange other) const
+    {
+      return std::max(_begin, other._begin) < std::min(_end, other._end);
+    }
+
+  private:
+    Day _begin;
+    Day _end;
+  };
+
+  constexpr bool operator==(DayRange a, DayRange b) { return a.begin() == b.begin() && a.end() == b.end(); }
+  constexpr bool operator!=(DayRange a, DayRange b) { return !(a == b); }
+
+} // namespace hotel
+
+#endif // HOTEL_DAY_H
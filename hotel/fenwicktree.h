@@ -0,0 +1,110 @@
+#ifndef HOTEL_FENWICKTREE_H
+#define HOTEL_FENWICKTREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hotel
+{
+  /**
+   * @brief The RangeFenwickTree class holds an array of integers, supporting range updates and range sums in O(log n)
+   *
+   * The tree is the usual pair of Fenwick (binary indexed) trees over the differences of the values: adding a value to
+   * a range changes only two differences, and the sum of a prefix can be computed from the prefix sums of the
+   * differences d[i] and i * d[i].
+   */
+  class RangeFenwickTree
+  {
+  public:
+    //! Creates a tree of the given size, with all values set to 0
+    explicit RangeFenwickTree(std::size_t size = 0) : _differences(size + 1), _weightedDifferences(size + 1) {}
+
+    //! Creates a tree holding the given values in O(n)
+    explicit RangeFenwickTree(const std::vector<int64_t>& values) : RangeFenwickTree(values.size())
+    {
+      int64_t previous = 0;
+      for (std::size_t i = 1; i <= values.size(); ++i)
+      {
+        _differences[i] = values[i - 1] - previous;
+        _weightedDifferences[i] = _differences[i] * static_cast<int64_t>(i - 1);
+        previous = values[i - 1];
+      }
+
+      // Every node passes its partial sum on to its parent, which turns the differences into a tree in one pass
+      for (std::size_t i = 1; i <= values.size(); ++i)
+      {
+        auto parent = i + (i & (~i + 1));
+        if (parent <= values.size())
+        {
+          _differences[parent] += _differences[i];
+          _weightedDifferences[parent] += _weightedDifferences[i];
+        }
+      }
+    }
+
+    std::size_t size() const { return _differences.size() - 1; }
+
+    //! Adds delta to all values in [begin, end)
+    void add(std::size_t begin, std::size_t end, int64_t delta)
+    {
+      if (begin >= end)
+        return;
+      addDifference(begin + 1, delta);
+      addDifference(end + 1, -delta);
+    }
+
+    //! Returns the sum of the values in [begin, end)
+    int64_t sum(std::size_t begin, std::size_t end) const
+    {
+      return begin < end ? prefixSum(end) - prefixSum(begin) : 0;
+    }
+
+    int64_t value(std::size_t index) const { return sum(index, index + 1); }
+
+    //! Returns all values in O(n log n)
+    std::vector<int64_t> values() const
+    {
+      std::vector<int64_t> result(size());
+      int64_t previous = 0;
+      for (std::size_t i = 0; i < result.size(); ++i)
+      {
+        auto current = prefixSum(i + 1);
+        result[i] = current - previous;
+        previous = current;
+      }
+      return result;
+    }
+
+  private:
+    // The difference at position i (1-based) is d[i] = value[i - 1] - value[i - 2]
+    void addDifference(std::size_t position, int64_t delta)
+    {
+      auto weighted = delta * static_cast<int64_t>(position - 1);
+      for (; position < _differences.size(); position += position & (~position + 1))
+      {
+        _differences[position] += delta;
+        _weightedDifferences[position] += weighted;
+      }
+    }
+
+    //! Returns the sum of the first count values
+    int64_t prefixSum(std::size_t count) const
+    {
+      int64_t differences = 0;
+      int64_t weightedDifferences = 0;
+      for (auto position = count; position > 0; position -= position & (~position + 1))
+      {
+        differences += _differences[position];
+        weightedDifferences += _weightedDifferences[position];
+      }
+      return differences * static_cast<int64_t>(count) - weightedDifferences;
+    }
+
+    std::vector<int64_t> _differences;
+    std::vector<int64_t> _weightedDifferences;
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_FENWICKTREE_H
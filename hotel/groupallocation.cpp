@@ -0,0 +1,13 @@
+#include "hotel/groupallocation.h"
+
+namespace hotel
+{
+  std::vector<Reservation> GroupAllocation::toReservations(const std::string& description) const
+  {
+    std::vector<Reservation> reservations;
+    for (auto roomId : roomIds)
+      reservations.emplace_back(description, roomId, period);
+    return reservations;
+  }
+
+} // namespace hotel
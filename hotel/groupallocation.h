@@ -0,0 +1,48 @@
+#ifndef HOTEL_GROUPALLOCATION_H
+#define HOTEL_GROUPALLOCATION_H
+
+#include "hotel/reservation.h"
+
+#include <boost/date_time.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace hotel
+{
+  /**
+   * @brief The GroupRequest struct describes a number of rooms which are needed for the same period, e.g. by a tour
+   *        operator
+   *
+   * @see PlanningBoard::allocateGroup
+   */
+  struct GroupRequest
+  {
+    boost::gregorian::date_period period = boost::gregorian::date_period(boost::gregorian::date(),
+                                                                         boost::gregorian::date());
+    //! The number of rooms needed, by room category id
+    std::map<int, int> roomsPerCategory;
+  };
+
+  /**
+   * @brief The GroupAllocation struct holds the result of PlanningBoard::allocateGroup
+   *
+   * Either roomIds holds the allocated rooms, or error explains why the request cannot be fulfilled.
+   */
+  struct GroupAllocation
+  {
+    boost::gregorian::date_period period = boost::gregorian::date_period(boost::gregorian::date(),
+                                                                         boost::gregorian::date());
+    //! The allocated rooms, grouped by category (in ascending order of the category id), each group in row order
+    std::vector<int> roomIds;
+    std::string error;
+
+    bool succeeded() const { return error.empty(); }
+    //! Returns one reservation per allocated room, all of them with the given description
+    std::vector<Reservation> toReservations(const std::string& description) const;
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_GROUPALLOCATION_H
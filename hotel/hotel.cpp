@@ -2,10 +2,29 @@
 
 #include <algorithm>
 #include <iostream>
+#include <stdexcept>
 #include <cassert>
 
 namespace hotel
 {
+  namespace
+  {
+    //! Looks up an item in the id index, or among all items if some of them may not have been indexed yet
+    template <typename T>
+    T* findById(const std::unordered_map<int, T*>& index, const std::vector<std::unique_ptr<T>>& items, int id,
+                bool hasUnindexedIds)
+    {
+      auto it = index.find(id);
+      if (it != index.end() && it->second->id() == id)
+        return it->second;
+      if (!hasUnindexedIds)
+        return nullptr;
+
+      auto item = std::find_if(items.begin(), items.end(), [id](auto& item) { return item->id() == id; });
+      return item != items.end() ? item->get() : nullptr;
+    }
+  } // namespace
+
   RoomCategory::RoomCategory(const std::string& shortCode, const std::string& name)
       : _shortCode(shortCode), _name(name)
   {
@@ -38,11 +57,21 @@ namespace hotel
   {
     PersistentObject::operator=(that);
 
+    if (this == &that)
+      return *this;
+
     _name = that._name;
+    _rooms.clear();
+    _categories.clear();
+    _categoriesByShortCode.clear();
+    _categoriesById.clear();
+    _roomsById.clear();
+    _roomsByCategory.clear();
+    _hasUnindexedIds = false;
 
     // Clone categories
     for (auto& category : that._categories)
-      _categories.push_back(std::make_unique<hotel::RoomCategory>(*category));
+      addRoomCategory(std::make_unique<hotel::RoomCategory>(*category));
 
     // Clone rooms
     for (auto& room : that._rooms)
@@ -86,6 +115,8 @@ namespace hotel
       throw std::logic_error("Category already registered! Category short code: " + category->shortCode() +
                              ", name: " + existingCategory->name());
 
+    _categoriesByShortCode.emplace(category->shortCode(), category.get());
+    indexCategory(category.get());
     _categories.push_back(std::move(category));
   }
 
@@ -99,23 +130,53 @@ namespace hotel
       throw std::logic_error("Trying to add a room with unknown category " + categoryShortCode);
 
     room->setCategory(existingCategory);
+    _roomsByCategory[existingCategory].push_back(room.get());
+    indexRoom(room.get());
     _rooms.push_back(std::move(room));
   }
 
-  RoomCategory* Hotel::getCategoryById(int id)
+  RoomCategory* Hotel::getCategoryById(int id) { return findById(_categoriesById, _categories, id, _hasUnindexedIds); }
+
+  RoomCategory* Hotel::getCategoryByShortCode(const std::string& shortCode)
   {
-    auto it = std::find_if(_categories.begin(), _categories.end(),
-                           [id](const std::unique_ptr<RoomCategory>& category) { return category->id() == id; });
-    return it != _categories.end() ? it->get() : nullptr;
+    auto it = _categoriesByShortCode.find(shortCode);
+    return it != _categoriesByShortCode.end() ? it->second : nullptr;
   }
 
-  RoomCategory* Hotel::getCategoryByShortCode(const std::string& shortCode)
+  HotelRoom* Hotel::getRoomById(int id) { return findById(_roomsById, _rooms, id, _hasUnindexedIds); }
+
+  const std::vector<HotelRoom*>& Hotel::getRoomsByCategory(const RoomCategory* category) const
+  {
+    static const std::vector<HotelRoom*> noRooms;
+    auto it = _roomsByCategory.find(category);
+    return it != _roomsByCategory.end() ? it->second : noRooms;
+  }
+
+  void Hotel::reindex()
+  {
+    _categoriesById.clear();
+    _roomsById.clear();
+    for (auto& category : _categories)
+      indexCategory(category.get());
+    for (auto& room : _rooms)
+      indexRoom(room.get());
+    _hasUnindexedIds = false;
+  }
+
+  void Hotel::indexCategory(RoomCategory* category)
+  {
+    if (category->id() != 0)
+      _categoriesById.emplace(category->id(), category);
+    else
+      _hasUnindexedIds = true;
+  }
+
+  void Hotel::indexRoom(HotelRoom* room)
   {
-    auto it =
-        std::find_if(_categories.begin(), _categories.end(), [shortCode](const std::unique_ptr<RoomCategory>& category) {
-          return category->shortCode() == shortCode;
-        });
-    return it != _categories.end() ? it->get() : nullptr;
+    if (room->id() != 0)
+      _roomsById.emplace(room->id(), room);
+    else
+      _hasUnindexedIds = true;
   }
 
 } // namespace hotel
@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "hotel/persistentobject.h"
@@ -49,6 +50,14 @@ namespace hotel
     std::string _name;
   };
 
+  /**
+   * @brief The Hotel class owns the room categories and rooms of a single hotel
+   *
+   * Categories are indexed by short code and by id, rooms by id, and the rooms of every category are indexed by
+   * category. The indices are maintained in addRoomCategory() and addRoom(). Since ids are usually assigned after an
+   * object has been added, reindex() has to be called once they have been set. Until then, a lookup by id which misses
+   * falls back to searching the categories or rooms of this hotel.
+   */
   class Hotel : public PersistentObject
   {
   public:
@@ -73,11 +82,27 @@ namespace hotel
 
     RoomCategory* getCategoryById(int id);
     RoomCategory* getCategoryByShortCode(const std::string& shortCode);
+    HotelRoom* getRoomById(int id);
+    //! Returns the rooms of the given category, in the order in which they have been added
+    const std::vector<HotelRoom*>& getRoomsByCategory(const RoomCategory* category) const;
+
+    //! Updates the id indices after the ids of categories or rooms have been set, e.g. when the hotel has been stored
+    void reindex();
 
   private:
+    void indexCategory(RoomCategory* category);
+    void indexRoom(HotelRoom* room);
+
     std::string _name;
     std::vector<std::unique_ptr<RoomCategory>> _categories;
     std::vector<std::unique_ptr<HotelRoom>> _rooms;
+
+    std::unordered_map<std::string, RoomCategory*> _categoriesByShortCode;
+    std::unordered_map<int, RoomCategory*> _categoriesById;
+    std::unordered_map<int, HotelRoom*> _roomsById;
+    std::unordered_map<const RoomCategory*, std::vector<HotelRoom*>> _roomsByCategory;
+    // Whether a category or room has been added without an id since the last call to reindex()
+    bool _hasUnindexedIds = false;
   };
 
 } // namespace hotel
@@ -6,7 +6,11 @@ namespace hotel
 {
   HotelCollection::HotelCollection() : _hotels() {}
 
-  HotelCollection::HotelCollection(std::vector<std::unique_ptr<Hotel>> hotel) : _hotels(std::move(hotel)) {}
+  HotelCollection::HotelCollection(std::vector<std::unique_ptr<Hotel>> hotel) : _hotels(std::move(hotel))
+  {
+    for (auto& hotel : _hotels)
+      indexHotel(hotel.get());
+  }
 
   HotelCollection::HotelCollection(const HotelCollection &that)
   {
@@ -18,11 +22,11 @@ namespace hotel
     assert(this != &that);
     if (this == &that) return *this;
 
-    _hotels.clear();
+    clear();
 
     // Deep copy all hotels
     for (auto& hotel : that._hotels)
-      _hotels.push_back(std::make_unique<Hotel>(*hotel));
+      addHotel(std::make_unique<Hotel>(*hotel));
 
     return *this;
   }
@@ -30,17 +34,34 @@ namespace hotel
   HotelCollection& HotelCollection::operator=(HotelCollection&& that)
   {
     _hotels = std::move(that._hotels);
+    _hotelsByRoomId = std::move(that._hotelsByRoomId);
+    _hotelsByCategoryId = std::move(that._hotelsByCategoryId);
     return *this;
   }
 
   void HotelCollection::addHotel(std::unique_ptr<Hotel> hotel)
   {
+    indexHotel(hotel.get());
     _hotels.push_back(std::move(hotel));
   }
 
+  void HotelCollection::reindexHotel(Hotel& hotel)
+  {
+    // The old ids of the hotel are not known anymore, so its entries are found by value
+    auto unindex = [&](std::unordered_map<int, Hotel*>& index) {
+      for (auto it = index.begin(); it != index.end();)
+        it = it->second == &hotel ? index.erase(it) : std::next(it);
+    };
+    unindex(_hotelsByRoomId);
+    unindex(_hotelsByCategoryId);
+    indexHotel(&hotel);
+  }
+
   void HotelCollection::clear()
   {
     _hotels.clear();
+    _hotelsByRoomId.clear();
+    _hotelsByCategoryId.clear();
   }
 
   const std::vector<std::unique_ptr<Hotel>>& HotelCollection::hotels() const { return _hotels; }
@@ -65,11 +86,8 @@ namespace hotel
 
   HotelRoom *HotelCollection::findRoomById(int id)
   {
-    for (auto& hotel : _hotels)
-      for (auto& room : hotel->rooms())
-        if (room->id() == id)
-          return room.get();
-    return nullptr;
+    auto it = _hotelsByRoomId.find(id);
+    return it != _hotelsByRoomId.end() ? it->second->getRoomById(id) : nullptr;
   }
 
   std::vector<HotelRoom*> HotelCollection::allRooms()
@@ -83,12 +101,25 @@ namespace hotel
 
   std::vector<HotelRoom*> HotelCollection::allRoomsByCategory(int categoryId)
   {
-    std::vector<hotel::HotelRoom*> rooms;
-    for (auto& hotel : _hotels)
-      for (auto& room : hotel->rooms())
-        if (room->category()->id() == categoryId)
-          rooms.push_back(room.get());
-    return rooms;
+    auto it = _hotelsByCategoryId.find(categoryId);
+    if (it == _hotelsByCategoryId.end())
+      return {};
+    auto category = it->second->getCategoryById(categoryId);
+    if (category == nullptr)
+      return {};
+    return it->second->getRoomsByCategory(category);
+  }
+
+  void HotelCollection::indexHotel(Hotel* hotel)
+  {
+    // The hotel is owned by the collection, so its own indices can be brought up to date as well
+    hotel->reindex();
+    for (auto& room : hotel->rooms())
+      if (room->id() != 0)
+        _hotelsByRoomId.insert_or_assign(room->id(), hotel);
+    for (auto& category : hotel->categories())
+      if (category->id() != 0)
+        _hotelsByCategoryId.insert_or_assign(category->id(), hotel);
   }
 
 } // namespace hotel
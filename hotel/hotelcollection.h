@@ -3,6 +3,7 @@
 
 #include "hotel/hotel.h"
 
+#include <unordered_map>
 #include <vector>
 
 namespace hotel
@@ -10,7 +11,10 @@ namespace hotel
   /**
    * @brief The HotelCollection class holds a list of hotels.
    *
-   * The class also provides utility functions to iterate over the whole collection.
+   * The class also provides utility functions to iterate over the whole collection. Hotels are indexed by the ids of
+   * their rooms and categories, and the rooms and categories themselves are then looked up in the hotel. When rooms or
+   * categories of a hotel in the collection are added, renumbered or replaced by assigning to the hotel, reindexHotel()
+   * has to be called.
    */
   class HotelCollection
   {
@@ -19,9 +23,12 @@ namespace hotel
     explicit HotelCollection(std::vector<std::unique_ptr<hotel::Hotel>> hotel);
     HotelCollection(const HotelCollection& that);
     HotelCollection& operator=(const HotelCollection& that);
+    HotelCollection(HotelCollection&& that) = default;
     HotelCollection& operator=(HotelCollection&& that);
 
     void addHotel(std::unique_ptr<hotel::Hotel> hotel);
+    //! Updates the indices after the rooms or categories of the given hotel of the collection have changed
+    void reindexHotel(hotel::Hotel& hotel);
     void clear();
 
     const std::vector<std::unique_ptr<Hotel>> &hotels() const;
@@ -35,7 +42,11 @@ namespace hotel
     std::vector<hotel::HotelRoom*> allRoomsByCategory(int categoryId);
 
   private:
+    void indexHotel(hotel::Hotel* hotel);
+
     std::vector<std::unique_ptr<hotel::Hotel>> _hotels;
+    std::unordered_map<int, hotel::Hotel*> _hotelsByRoomId;
+    std::unordered_map<int, hotel::Hotel*> _hotelsByCategoryId;
   };
 
 } // namespace hotel
@@ -0,0 +1,191 @@
+#include "hotel/occupancyanalytics.h"
+
+#include "hotel/hotelcollection.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+
+namespace hotel
+{
+  OccupancyAnalytics::OccupancyAnalytics(const HotelCollection& hotels)
+  {
+    std::unordered_map<const RoomCategory*, int> categoryIndices;
+    for (auto& hotel : hotels.hotels())
+    {
+      auto hotelIndex = static_cast<int>(_hotels.size());
+      _hotelIndices.emplace(hotel->id(), hotelIndex);
+      _hotels.emplace_back();
+      for (auto& category : hotel->categories())
+      {
+        auto categoryIndex = static_cast<int>(_categories.size());
+        categoryIndices[category.get()] = categoryIndex;
+        _categoryIndices.emplace(category->id(), categoryIndex);
+        _categoryHotels.push_back(hotelIndex);
+        _categories.emplace_back();
+      }
+      for (auto& room : hotel->rooms())
+      {
+        auto category = categoryIndices.find(room->category());
+        if (category != categoryIndices.end())
+          _roomCategories.emplace(room->id(), category->second);
+      }
+    }
+  }
+
+  void OccupancyAnalytics::addOccupancy(int roomId, DayRange range, int delta)
+  {
+    if (range.isEmpty())
+      return;
+
+    growToInclude(range);
+    auto begin = static_cast<std::size_t>(range.begin() - _origin);
+    auto end = static_cast<std::size_t>(range.end() - _origin);
+    _total.add(begin, end, delta);
+    auto category = _roomCategories.find(roomId);
+    if (category != _roomCategories.end())
+    {
+      _categories[category->second].add(begin, end, delta);
+      _hotels[_categoryHotels[category->second]].add(begin, end, delta);
+    }
+  }
+
+  void OccupancyAnalytics::addReservation(const Reservation& reservation)
+  {
+    for (auto& atom : reservation.atoms())
+      addOccupancy(atom.roomId(), atom.dayRange(), 1);
+  }
+
+  void OccupancyAnalytics::removeReservation(const Reservation& reservation)
+  {
+    for (auto& atom : reservation.atoms())
+      addOccupancy(atom.roomId(), atom.dayRange(), -1);
+  }
+
+  void OccupancyAnalytics::rebuild(const std::vector<const Reservation*>& reservations, ThreadPool& pool)
+  {
+    clear();
+
+    // Group the atoms by category, atoms of unknown rooms go into an additional group at the end
+    std::vector<std::vector<const ReservationAtom*>> atomsByCategory(_categories.size() + 1);
+    std::optional<DayRange> extent;
+    for (auto reservation : reservations)
+      for (auto& atom : reservation->atoms())
+      {
+        if (atom.dayRange().isEmpty())
+          continue;
+        auto category = _roomCategories.find(atom.roomId());
+        atomsByCategory[category != _roomCategories.end() ? category->second : _categories.size()].push_back(&atom);
+        extent = extent ? DayRange(std::min(extent->begin(), atom.dayRange().begin()),
+                                   std::max(extent->end(), atom.dayRange().end()))
+                        : atom.dayRange();
+      }
+    if (!extent)
+      return;
+
+    // Leave some room at the end of the range, since new reservations are usually made for the future
+    _origin = extent->begin();
+    auto days = static_cast<std::size_t>(2 * extent->length());
+
+    // Count the occupied rooms per day as the prefix sum of the arrivals and departures
+    std::vector<std::vector<int64_t>> occupancy(atomsByCategory.size());
+    pool.parallelFor(atomsByCategory.size(), [&](std::size_t category) {
+      auto& counts = occupancy[category];
+      counts.assign(days + 1, 0);
+      for (auto atom : atomsByCategory[category])
+      {
+        ++counts[static_cast<std::size_t>(atom->dayRange().begin() - _origin)];
+        --counts[static_cast<std::size_t>(atom->dayRange().end() - _origin)];
+      }
+      for (std::size_t day = 1; day < days; ++day)
+        counts[day] += counts[day - 1];
+      counts.pop_back();
+      if (category < _categories.size())
+        _categories[category] = RangeFenwickTree(counts);
+    });
+
+    // The hotels and the total are sums over the categories
+    std::vector<std::vector<int>> hotelCategories(_hotels.size());
+    for (std::size_t category = 0; category < _categories.size(); ++category)
+      hotelCategories[_categoryHotels[category]].push_back(static_cast<int>(category));
+    pool.parallelFor(_hotels.size() + 1, [&](std::size_t hotel) {
+      std::vector<int64_t> counts(days, 0);
+      auto addCounts = [&counts](const std::vector<int64_t>& other) {
+        std::transform(counts.begin(), counts.end(), other.begin(), counts.begin(), std::plus<int64_t>());
+      };
+      if (hotel < _hotels.size())
+      {
+        for (auto category : hotelCategories[hotel])
+          addCounts(occupancy[category]);
+        _hotels[hotel] = RangeFenwickTree(counts);
+      }
+      else
+      {
+        for (auto& categoryCounts : occupancy)
+          addCounts(categoryCounts);
+        _total = RangeFenwickTree(counts);
+      }
+    });
+  }
+
+  void OccupancyAnalytics::clear()
+  {
+    _origin = Day();
+    std::fill(_categories.begin(), _categories.end(), RangeFenwickTree());
+    std::fill(_hotels.begin(), _hotels.end(), RangeFenwickTree());
+    _total = RangeFenwickTree();
+  }
+
+  int64_t OccupancyAnalytics::occupiedNights(DayRange range) const { return sum(_total, range); }
+
+  int64_t OccupancyAnalytics::occupiedNightsInHotel(int hotelId, DayRange range) const
+  {
+    auto hotel = _hotelIndices.find(hotelId);
+    return hotel != _hotelIndices.end() ? sum(_hotels[hotel->second], range) : 0;
+  }
+
+  int64_t OccupancyAnalytics::occupiedNightsInCategory(int categoryId, DayRange range) const
+  {
+    auto category = _categoryIndices.find(categoryId);
+    return category != _categoryIndices.end() ? sum(_categories[category->second], range) : 0;
+  }
+
+  int64_t OccupancyAnalytics::sum(const RangeFenwickTree& tree, DayRange range) const
+  {
+    // Nights outside of the trees are not occupied
+    auto size = static_cast<int>(tree.size());
+    auto begin = std::clamp(range.begin() - _origin, 0, size);
+    auto end = std::clamp(range.end() - _origin, 0, size);
+    return tree.sum(static_cast<std::size_t>(begin), static_cast<std::size_t>(end));
+  }
+
+  void OccupancyAnalytics::growToInclude(DayRange range)
+  {
+    auto size = static_cast<int>(_total.size());
+    if (size > 0 && range.begin() >= _origin && range.end() <= _origin + size)
+      return;
+
+    // At least double the number of days, so that growing costs amortized O(log n) per day. The new days are added on
+    // the side on which the range lies.
+    auto begin = size > 0 ? std::min(_origin, range.begin()) : range.begin();
+    auto end = size > 0 ? std::max(_origin + size, range.end()) : range.end();
+    auto newSize = std::max({end - begin, 2 * size, 64});
+    if (size > 0 && range.begin() < _origin)
+      begin = end - newSize;
+
+    auto offset = size > 0 ? static_cast<std::size_t>(_origin - begin) : 0;
+    auto relocate = [&](RangeFenwickTree& tree) {
+      std::vector<int64_t> values(static_cast<std::size_t>(newSize), 0);
+      auto oldValues = tree.values();
+      std::copy(oldValues.begin(), oldValues.end(), values.begin() + static_cast<std::ptrdiff_t>(offset));
+      tree = RangeFenwickTree(values);
+    };
+    for (auto& tree : _categories)
+      relocate(tree);
+    for (auto& tree : _hotels)
+      relocate(tree);
+    relocate(_total);
+    _origin = begin;
+  }
+
+} // namespace hotel
@@ -0,0 +1,75 @@
+#ifndef HOTEL_OCCUPANCYANALYTICS_H
+#define HOTEL_OCCUPANCYANALYTICS_H
+
+#include "hotel/day.h"
+#include "hotel/fenwicktree.h"
+#include "hotel/reservation.h"
+#include "hotel/threadpool.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace hotel
+{
+  class HotelCollection;
+
+  /**
+   * @brief The OccupancyAnalytics class counts the occupied room nights per day, room category and hotel
+   *
+   * Every category and every hotel, as well as the whole collection, keeps the number of occupied rooms of each day in
+   * a RangeFenwickTree. Adding or removing an atom and querying the occupied nights over any range of days both cost
+   * O(log n) in the number of days covered.
+   *
+   * Rooms which are not part of the collection only count towards the totals of the whole collection.
+   *
+   * @see PlanningBoard::enableOccupancyAnalytics
+   */
+  class OccupancyAnalytics
+  {
+  public:
+    explicit OccupancyAnalytics(const HotelCollection& hotels);
+
+    //! Adds delta occupied rooms to each night of the range in the given room, i.e. 1 for a new atom, -1 for a removed
+    void addOccupancy(int roomId, DayRange range, int delta);
+    void addReservation(const Reservation& reservation);
+    void removeReservation(const Reservation& reservation);
+
+    /**
+     * @brief rebuild replaces all counts with the occupancy of the given reservations
+     *
+     * The counts of the categories are computed in parallel on the given thread pool, and are then summed up to the
+     * counts of the hotels. This takes O(n + d) time for n atoms and d days, which is faster than adding many
+     * reservations one by one.
+     */
+    void rebuild(const std::vector<const Reservation*>& reservations, ThreadPool& pool = ThreadPool::shared());
+    void clear();
+
+    //! Returns the number of occupied room nights during the range, over all rooms
+    int64_t occupiedNights(DayRange range) const;
+    //! Returns the number of occupied room nights during the range in the given hotel, 0 if the hotel is unknown
+    int64_t occupiedNightsInHotel(int hotelId, DayRange range) const;
+    //! Returns the number of occupied room nights during the range in the given category, 0 if it is unknown
+    int64_t occupiedNightsInCategory(int categoryId, DayRange range) const;
+
+  private:
+    //! Returns the sum over the given range of days of the tree, which covers the days starting at _origin
+    int64_t sum(const RangeFenwickTree& tree, DayRange range) const;
+    //! Makes sure that all trees cover the given range of days
+    void growToInclude(DayRange range);
+
+    // Categories and hotels are identified by a dense index, the trees are stored in the same order
+    std::unordered_map<int, int> _roomCategories;
+    std::unordered_map<int, int> _categoryIndices;
+    std::unordered_map<int, int> _hotelIndices;
+    std::vector<int> _categoryHotels;
+
+    Day _origin;
+    std::vector<RangeFenwickTree> _categories;
+    std::vector<RangeFenwickTree> _hotels;
+    RangeFenwickTree _total;
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_OCCUPANCYANALYTICS_H
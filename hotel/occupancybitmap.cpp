@@ -0,0 +1,115 @@
+#include "hotel/occupancybitmap.h"
+
+#include <algorithm>
+
+namespace hotel
+{
+  template <class Func> void OccupancyBitmap::forEachWord(DayRange range, Func&& fn)
+  {
+    // An empty range is treated as the single night starting at its begin date, as in PlanningBoard::isFree
+    auto firstNight = range.begin().number();
+    auto endNight = std::max(range.end().number(), firstNight + 1);
+    for (auto night = firstNight; night < endNight;)
+    {
+      // Rounds towards negative infinity, so that days before the epoch are mapped correctly as well
+      auto chunk = (night >= 0 ? night : night - (NightsPerChunk - 1)) / NightsPerChunk;
+      auto bit = night - chunk * NightsPerChunk;
+      auto word = bit / 64;
+      auto firstBit = bit % 64;
+      auto bitCount = std::min(64 - firstBit, endNight - night);
+      auto mask = (bitCount == 64 ? ~uint64_t(0) : ((uint64_t(1) << bitCount) - 1)) << firstBit;
+      fn(chunk, word, mask);
+      night += bitCount;
+    }
+  }
+
+  void OccupancyBitmap::setOccupied(int roomId, DayRange range, bool occupied)
+  {
+    auto slot = slotForRoom(roomId);
+    forEachWord(range, [&](int chunkKey, int word, uint64_t mask) {
+      auto& chunk = _chunks[chunkKey];
+      if (chunk.empty())
+        chunk.resize(WordsPerChunk * _slotCapacity, 0);
+
+      auto& bits = chunk[word * _slotCapacity + slot];
+      bits = occupied ? (bits | mask) : (bits & ~mask);
+    });
+  }
+
+  bool OccupancyBitmap::isFree(int roomId, DayRange range) const
+  {
+    auto slotIt = _roomSlots.find(roomId);
+    if (slotIt == _roomSlots.end())
+      return true;
+
+    uint64_t occupied = 0;
+    forEachWord(range, [&](int chunkKey, int word, uint64_t mask) {
+      auto chunkIt = _chunks.find(chunkKey);
+      if (chunkIt != _chunks.end())
+        occupied |= chunkIt->second[word * _slotCapacity + slotIt->second] & mask;
+    });
+    return occupied == 0;
+  }
+
+  std::vector<int> OccupancyBitmap::getFreeRooms(const std::vector<int>& roomIds, DayRange range) const
+  {
+    // OR together all of the words covering the range, for all rooms at once. Each pass over a row touches contiguous
+    // memory, which lets this loop be vectorized.
+    std::vector<uint64_t> occupied(_slotCapacity, 0);
+    forEachWord(range, [&](int chunkKey, int word, uint64_t mask) {
+      auto chunkIt = _chunks.find(chunkKey);
+      if (chunkIt == _chunks.end())
+        return;
+
+      const uint64_t* row = chunkIt->second.data() + word * _slotCapacity;
+      uint64_t* out = occupied.data();
+      for (std::size_t slot = 0; slot < _slotCapacity; ++slot)
+        out[slot] |= row[slot] & mask;
+    });
+
+    std::vector<int> result;
+    for (auto roomId : roomIds)
+    {
+      auto slotIt = _roomSlots.find(roomId);
+      if (slotIt == _roomSlots.end() || occupied[slotIt->second] == 0)
+        result.push_back(roomId);
+    }
+    return result;
+  }
+
+  void OccupancyBitmap::clear()
+  {
+    _roomSlots.clear();
+    _slotCapacity = 0;
+    _chunks.clear();
+  }
+
+  int OccupancyBitmap::slotForRoom(int roomId)
+  {
+    auto slotIt = _roomSlots.find(roomId);
+    if (slotIt != _roomSlots.end())
+      return static_cast<int>(slotIt->second);
+
+    auto slot = _roomSlots.size();
+    if (slot == _slotCapacity)
+      growCapacity();
+    _roomSlots[roomId] = slot;
+    return static_cast<int>(slot);
+  }
+
+  void OccupancyBitmap::growCapacity()
+  {
+    // Rooms are added rarely, so the chunks are simply re-laid out with twice the number of slots
+    auto newCapacity = std::max<std::size_t>(64, 2 * _slotCapacity);
+    for (auto& chunk : _chunks)
+    {
+      std::vector<uint64_t> newChunk(WordsPerChunk * newCapacity, 0);
+      for (std::size_t word = 0; word < WordsPerChunk; ++word)
+        std::copy_n(chunk.second.begin() + word * _slotCapacity, _slotCapacity,
+                    newChunk.begin() + word * newCapacity);
+      chunk.second = std::move(newChunk);
+    }
+    _slotCapacity = newCapacity;
+  }
+
+} // namespace hotel
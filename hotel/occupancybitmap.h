@@ -0,0 +1,61 @@
+#ifndef HOTEL_OCCUPANCYBITMAP_H
+#define HOTEL_OCCUPANCYBITMAP_H
+
+#include "hotel/day.h"
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace hotel
+{
+  /**
+   * @brief The OccupancyBitmap class stores one bit per room and night, set if the room is occupied in that night
+   *
+   * The nights are split into year sized chunks of 384 nights. Within a chunk, the bitmap is stored word-major: the
+   * n-th 64 bit word of all rooms is stored contiguously. This allows availability queries over many rooms to be
+   * evaluated with a single pass over contiguous memory per word, which the compiler turns into vector instructions.
+   *
+   * @see PlanningBoard
+   */
+  class OccupancyBitmap
+  {
+  public:
+    /**
+     * @brief setOccupied marks the nights in the given range as occupied or free for the given room
+     */
+    void setOccupied(int roomId, DayRange range, bool occupied);
+
+    /**
+     * @brief isFree returns true if none of the nights in the given range are occupied in the given room
+     */
+    bool isFree(int roomId, DayRange range) const;
+
+    /**
+     * @brief getFreeRooms returns the subset of the given rooms which are free during the whole range
+     * @return the free room ids, in the order in which they were given.
+     */
+    std::vector<int> getFreeRooms(const std::vector<int>& roomIds, DayRange range) const;
+
+    void clear();
+
+  private:
+    static constexpr int NightsPerChunk = 384;
+    static constexpr int WordsPerChunk = NightsPerChunk / 64;
+
+    // Calls fn(chunkKey, wordIndex, mask) for every word which covers at least one night of the given range
+    template <class Func> static void forEachWord(DayRange range, Func&& fn);
+
+    int slotForRoom(int roomId);
+    void growCapacity();
+
+    // Each room is assigned a dense slot index. A chunk holds WordsPerChunk rows of _slotCapacity words each.
+    std::unordered_map<int, std::size_t> _roomSlots;
+    std::size_t _slotCapacity = 0;
+    std::map<int, std::vector<uint64_t>> _chunks;
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_OCCUPANCYBITMAP_H
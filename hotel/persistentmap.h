@@ -0,0 +1,224 @@
+#ifndef HOTEL_PERSISTENTMAP_H
+#define HOTEL_PERSISTENTMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace hotel
+{
+  /**
+   * @brief The PersistentMap class is an immutable ordered map, which shares structure between versions
+   *
+   * The map is an AVL tree of immutable nodes. Inserting or erasing an element does not modify the map, but returns a
+   * new map: only the O(log n) nodes on the path to the element are copied, all other nodes are shared with the
+   * previous version. Copying a map costs O(1).
+   *
+   * Since nodes are never modified after their construction, maps may be read and copied from multiple threads at the
+   * same time without any locking (the reference counts of std::shared_ptr are thread safe).
+   */
+  template <class Key, class Value, class Compare = std::less<Key>> class PersistentMap
+  {
+  public:
+    typedef std::pair<const Key, Value> value_type;
+
+    PersistentMap() = default;
+
+    std::size_t size() const { return sizeOf(_root); }
+    bool empty() const { return _root == nullptr; }
+
+    //! Returns the element with the given key, or nullptr
+    const value_type* find(const Key& key) const
+    {
+      auto node = _root.get();
+      while (node != nullptr)
+      {
+        if (_compare(key, node->entry.first))
+          node = node->left.get();
+        else if (_compare(node->entry.first, key))
+          node = node->right.get();
+        else
+          return &node->entry;
+      }
+      return nullptr;
+    }
+
+    //! Returns the element with the greatest key which is not greater than the given key, or nullptr
+    const value_type* findLastNotAfter(const Key& key) const
+    {
+      const value_type* result = nullptr;
+      auto node = _root.get();
+      while (node != nullptr)
+      {
+        if (_compare(key, node->entry.first))
+          node = node->left.get();
+        else
+        {
+          result = &node->entry;
+          node = node->right.get();
+        }
+      }
+      return result;
+    }
+
+    //! Returns the element with the smallest key which is greater than the given key, or nullptr
+    const value_type* findFirstAfter(const Key& key) const
+    {
+      const value_type* result = nullptr;
+      auto node = _root.get();
+      while (node != nullptr)
+      {
+        if (_compare(key, node->entry.first))
+        {
+          result = &node->entry;
+          node = node->left.get();
+        }
+        else
+          node = node->right.get();
+      }
+      return result;
+    }
+
+    //! Returns the element with the smallest key, or nullptr if the map is empty
+    const value_type* first() const
+    {
+      auto node = _root.get();
+      while (node != nullptr && node->left != nullptr)
+        node = node->left.get();
+      return node != nullptr ? &node->entry : nullptr;
+    }
+
+    //! Returns the element with the greatest key, or nullptr if the map is empty
+    const value_type* last() const
+    {
+      auto node = _root.get();
+      while (node != nullptr && node->right != nullptr)
+        node = node->right.get();
+      return node != nullptr ? &node->entry : nullptr;
+    }
+
+    //! Returns a map in which the given key is mapped to the given value. An existing value is replaced.
+    PersistentMap insert(const Key& key, Value value) const
+    {
+      return PersistentMap(insert(_root, key, std::move(value)), _compare);
+    }
+
+    //! Returns a map without the given key
+    PersistentMap erase(const Key& key) const
+    {
+      if (find(key) == nullptr)
+        return *this;
+      return PersistentMap(erase(_root, key), _compare);
+    }
+
+    //! Calls func for every element, in ascending order of the keys
+    template <class Func> void forEach(Func&& func) const { forEach(_root.get(), func); }
+
+  private:
+    struct Node;
+    typedef std::shared_ptr<const Node> NodePtr;
+
+    struct Node
+    {
+      Node(value_type entry, NodePtr left, NodePtr right)
+          : entry(std::move(entry)), left(std::move(left)), right(std::move(right)),
+            height(1 + std::max(heightOf(this->left), heightOf(this->right))),
+            size(1 + sizeOf(this->left) + sizeOf(this->right))
+      {
+      }
+
+      value_type entry;
+      NodePtr left;
+      NodePtr right;
+      int height;
+      std::size_t size;
+    };
+
+    PersistentMap(NodePtr root, Compare compare) : _root(std::move(root)), _compare(std::move(compare)) {}
+
+    static int heightOf(const NodePtr& node) { return node != nullptr ? node->height : 0; }
+    static std::size_t sizeOf(const NodePtr& node) { return node != nullptr ? node->size : 0; }
+
+    static NodePtr makeNode(value_type entry, NodePtr left, NodePtr right)
+    {
+      return std::make_shared<const Node>(std::move(entry), std::move(left), std::move(right));
+    }
+
+    //! Creates a node from the given parts, rotating once or twice if the heights of the subtrees differ by two
+    static NodePtr balance(value_type entry, NodePtr left, NodePtr right)
+    {
+      if (heightOf(left) > heightOf(right) + 1)
+      {
+        if (heightOf(left->left) >= heightOf(left->right))
+          return makeNode(left->entry, left->left, makeNode(std::move(entry), left->right, std::move(right)));
+        auto& pivot = left->right;
+        return makeNode(pivot->entry, makeNode(left->entry, left->left, pivot->left),
+                        makeNode(std::move(entry), pivot->right, std::move(right)));
+      }
+      if (heightOf(right) > heightOf(left) + 1)
+      {
+        if (heightOf(right->right) >= heightOf(right->left))
+          return makeNode(right->entry, makeNode(std::move(entry), std::move(left), right->left), right->right);
+        auto& pivot = right->left;
+        return makeNode(pivot->entry, makeNode(std::move(entry), std::move(left), pivot->left),
+                        makeNode(right->entry, pivot->right, right->right));
+      }
+      return makeNode(std::move(entry), std::move(left), std::move(right));
+    }
+
+    NodePtr insert(const NodePtr& node, const Key& key, Value value) const
+    {
+      if (node == nullptr)
+        return makeNode(value_type(key, std::move(value)), nullptr, nullptr);
+      if (_compare(key, node->entry.first))
+        return balance(node->entry, insert(node->left, key, std::move(value)), node->right);
+      if (_compare(node->entry.first, key))
+        return balance(node->entry, node->left, insert(node->right, key, std::move(value)));
+      return makeNode(value_type(key, std::move(value)), node->left, node->right);
+    }
+
+    //! Removes the key, which must be contained in the subtree
+    NodePtr erase(const NodePtr& node, const Key& key) const
+    {
+      if (_compare(key, node->entry.first))
+        return balance(node->entry, erase(node->left, key), node->right);
+      if (_compare(node->entry.first, key))
+        return balance(node->entry, node->left, erase(node->right, key));
+      if (node->left == nullptr)
+        return node->right;
+      if (node->right == nullptr)
+        return node->left;
+
+      // Replace the node by the smallest element of its right subtree
+      auto successor = node->right.get();
+      while (successor->left != nullptr)
+        successor = successor->left.get();
+      return balance(successor->entry, node->left, eraseFirst(node->right));
+    }
+
+    static NodePtr eraseFirst(const NodePtr& node)
+    {
+      if (node->left == nullptr)
+        return node->right;
+      return balance(node->entry, eraseFirst(node->left), node->right);
+    }
+
+    template <class Func> static void forEach(const Node* node, Func& func)
+    {
+      while (node != nullptr)
+      {
+        forEach(node->left.get(), func);
+        func(node->entry);
+        node = node->right.get();
+      }
+    }
+
+    NodePtr _root;
+    Compare _compare;
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_PERSISTENTMAP_H
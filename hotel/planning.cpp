@@ -1,17 +1,39 @@
 #include "hotel/planning.h"
 
+#include "hotel/hotelcollection.h"
+
+#include <sstream>
+
 namespace hotel
 {
+  PlanningBoard::PlanningBoard()
+      : _indexMemory(std::make_unique<std::pmr::unsynchronized_pool_resource>()),
+        _reservationsById(_indexMemory.get()), _rooms(_indexMemory.get()), _periodIndex(_indexMemory.get()),
+        _extentBegins(_indexMemory.get()), _extentEnds(_indexMemory.get())
+  {
+  }
+
   PlanningBoard& PlanningBoard::operator=(const PlanningBoard& that)
   {
     assert(this != &that);
     if (this == &that) return *this;
 
     clear();
+    setOccupancyBitmapEnabled(that.isOccupancyBitmapEnabled());
+    setSnapshotTrackingEnabled(false);
+    disableOccupancyAnalytics();
 
     // Copy reservations
-    for (auto& reservation : that._reservations)
-      addReservation(std::make_unique<Reservation>(*reservation));
+    std::vector<Reservation> copies;
+    copies.reserve(that._reservations.size());
+    that._reservations.forEach([&copies](const Reservation* reservation) { copies.push_back(*reservation); });
+    addReservations(std::move(copies));
+
+    // Both boards hold the same reservations, so they can share the snapshot
+    if (that._snapshot)
+      _snapshot = std::make_unique<PlanningSnapshot>(*that._snapshot);
+    if (that._analytics)
+      _analytics = std::make_unique<OccupancyAnalytics>(*that._analytics);
 
     return *this;
   }
@@ -20,9 +42,17 @@ namespace hotel
   {
     assert(this != &that);
 
+    // The indices keep using their own memory pool, so their elements are moved one by one
     clear();
     _rooms = std::move(that._rooms);
     _reservations = std::move(that._reservations);
+    _reservationsById = std::move(that._reservationsById);
+    _periodIndex = std::move(that._periodIndex);
+    _extentBegins = std::move(that._extentBegins);
+    _extentEnds = std::move(that._extentEnds);
+    _occupancy = std::move(that._occupancy);
+    _snapshot = std::move(that._snapshot);
+    _analytics = std::move(that._analytics);
     that.clear();
 
     return *this;
@@ -36,60 +66,197 @@ namespace hotel
     if (!canAddReservation(*reservation))
       throw std::logic_error("cannot add reservation " + reservation->description());
 
-    // Insert reservation and atoms
-    for (auto& atom : reservation->atoms())
+    if (reservation->id() != 0 && _reservationsById.count(reservation->id()) != 0)
+      throw std::logic_error("cannot add reservation " + reservation->description() + ", its id is already used");
+
+    // Move the reservation into the pool, then insert its atoms and index entries
+    auto snapshot = snapshotWithReservation(*reservation);
+    auto reservationPtr = _reservations.create(std::move(*reservation));
+    for (auto& atom : reservationPtr->atoms())
       insertAtom(&atom);
-    auto reservationPtr = reservation.get();
-    _reservations.push_back(std::move(reservation));
+    insertIntoIndices(reservationPtr, std::move(snapshot));
 
     return reservationPtr;
   }
 
-  void PlanningBoard::removeReservation(const Reservation* reservation)
+  std::vector<Reservation*> PlanningBoard::addReservations(std::vector<std::unique_ptr<Reservation>> reservations)
   {
-    if (reservation == nullptr)
-      throw std::invalid_argument("cannot remove nullptr reservation from planning board");
+    std::vector<Reservation*> candidates;
+    candidates.reserve(reservations.size());
+    for (auto& reservation : reservations)
+      candidates.push_back(reservation.get());
+    return addReservationBatch(candidates);
+  }
 
-    // Remove the atoms
-    for (auto& atom : reservation->atoms())
+  std::vector<Reservation*> PlanningBoard::addReservations(std::vector<Reservation> reservations)
+  {
+    std::vector<Reservation*> candidates;
+    candidates.reserve(reservations.size());
+    for (auto& reservation : reservations)
+      candidates.push_back(&reservation);
+    return addReservationBatch(candidates);
+  }
+
+  std::vector<Reservation*> PlanningBoard::addReservationBatch(const std::vector<Reservation*>& candidates)
+  {
+    // A reservation is a candidate if it is valid, its id is unused and it does not overlap with the planning board.
+    // Conflicts within the batch are resolved later on, in the same order as with repeated calls to addReservation.
+    std::vector<char> accepted(candidates.size(), 0);
+    for (std::size_t i = 0; i < candidates.size(); ++i)
     {
-      auto& roomAtoms = _rooms[atom.roomId()];
-      auto atomIt = std::find(roomAtoms.begin(), roomAtoms.end(), &atom);
-      if (atomIt != roomAtoms.end())
-        roomAtoms.erase(atomIt);
+      auto reservation = candidates[i];
+      if (reservation == nullptr || !reservation->isValid())
+        continue;
+      if (reservation->id() != 0 && _reservationsById.count(reservation->id()) != 0)
+        continue;
+      auto& atoms = reservation->atoms();
+      accepted[i] = std::all_of(atoms.begin(), atoms.end(),
+                                [this](auto& atom) { return this->isFree(atom.roomId(), atom.dayRange()); });
     }
 
-    // Find and remove the reservation, then notify the observers
-    auto reservationIt =
-        std::find_if(_reservations.begin(), _reservations.end(), [=](auto& x) { return x.get() == reservation; });
-    if (reservationIt != _reservations.end())
-      _reservations.erase(reservationIt);
-  }
+    // Sort all of the candidate atoms by room and date, and sweep over each room to find the overlapping pairs
+    struct BatchAtom
+    {
+      int roomId;
+      DayRange range;
+      std::size_t index;
+      std::size_t atomIndex;
+    };
+    std::vector<BatchAtom> atoms;
+    for (std::size_t i = 0; i < candidates.size(); ++i)
+      if (accepted[i])
+        for (std::size_t j = 0; j < candidates[i]->atoms().size(); ++j)
+          atoms.push_back(BatchAtom{candidates[i]->atoms()[j].roomId(), candidates[i]->atoms()[j].dayRange(), i, j});
+    std::sort(atoms.begin(), atoms.end(), [](const BatchAtom& a, const BatchAtom& b) {
+      if (a.roomId != b.roomId)
+        return a.roomId < b.roomId;
+      return a.range.begin() < b.range.begin();
+    });
+
+    // Each conflict is stored as (later index, earlier index)
+    std::vector<std::pair<std::size_t, std::size_t>> conflicts;
+    std::vector<const BatchAtom*> active;
+    for (auto& current : atoms)
+    {
+      active.erase(std::remove_if(active.begin(), active.end(),
+                                  [&](const BatchAtom* a) {
+                                    return a->roomId != current.roomId || a->range.end() <= current.range.begin();
+                                  }),
+                   active.end());
+      for (auto other : active)
+        if (other->index != current.index)
+          conflicts.emplace_back(std::max(other->index, current.index), std::min(other->index, current.index));
+      active.push_back(&current);
+    }
 
-  void PlanningBoard::removeReservation(int reservationId)
-  {
-    // Find the reservation
-    auto reservationIt = std::find_if(_reservations.begin(), _reservations.end(), [=](auto& x) { return x->id() == reservationId; });
-    if (reservationIt != _reservations.end())
+    // Going through the batch in order, a reservation is rejected if it overlaps with an earlier accepted one, or if
+    // an earlier accepted one uses the same id. The accepted ones are moved into the pool right away, so that their
+    // ids are known to the id index.
+    std::sort(conflicts.begin(), conflicts.end());
+    std::vector<Reservation*> result(candidates.size(), nullptr);
+    auto conflictIt = conflicts.begin();
+    for (std::size_t i = 0; i < candidates.size(); ++i)
     {
-      // First, remove the atoms
-      for (auto& atom : (*reservationIt)->atoms())
+      for (; conflictIt != conflicts.end() && conflictIt->first == i; ++conflictIt)
+        if (accepted[conflictIt->second])
+          accepted[i] = 0;
+      if (!accepted[i])
+        continue;
+      auto id = candidates[i]->id();
+      if (id != 0 && _reservationsById.count(id) != 0)
       {
-        auto& roomAtoms = _rooms[atom.roomId()];
-        auto atomIt = std::find(roomAtoms.begin(), roomAtoms.end(), &atom);
-        if (atomIt != roomAtoms.end())
-          roomAtoms.erase(atomIt);
+        accepted[i] = 0;
+        continue;
       }
-
-      // Then, remove the reservation
-      _reservations.erase(reservationIt);
+      std::optional<PlanningSnapshot> snapshot;
+      try
+      {
+        snapshot = snapshotWithReservation(*candidates[i]);
+      }
+      catch (const std::logic_error&)
+      {
+        // The snapshot is out of sync with the board, which leaves the reservation out as well
+        accepted[i] = 0;
+        continue;
+      }
+      result[i] = _reservations.create(std::move(*candidates[i]));
+      insertIntoIndices(result[i], std::move(snapshot));
     }
+
+    // Finally, insert the atoms. They are inserted in sorted order, which makes inserting into empty rooms a constant
+    // time operation.
+    for (auto& atom : atoms)
+      if (accepted[atom.index])
+        insertAtom(&result[atom.index]->atoms()[atom.atomIndex]);
+
+    return result;
+  }
+
+  void PlanningBoard::removeReservation(const Reservation* reservation)
+  {
+    if (reservation == nullptr)
+      throw std::invalid_argument("cannot remove nullptr reservation from planning board");
+
+    if (_reservations.contains(reservation))
+      eraseReservation(const_cast<Reservation*>(reservation));
+  }
+
+  void PlanningBoard::removeReservation(int reservationId)
+  {
+    auto it = _reservationsById.find(reservationId);
+    if (it != _reservationsById.end())
+      eraseReservation(it->second);
+  }
+
+  void PlanningBoard::eraseReservation(Reservation* reservation)
+  {
+    // As when adding, the new snapshot is built before the board is modified
+    std::optional<PlanningSnapshot> snapshot;
+    if (_snapshot)
+      snapshot = _snapshot->withoutReservation(*reservation);
+
+    for (auto& atom : reservation->atoms())
+      removeAtom(&atom);
+    removeFromPeriodIndex(reservation);
+    removeFromExtent(reservation);
+    if (reservation->id() != 0)
+      _reservationsById.erase(reservation->id());
+    if (snapshot)
+      *_snapshot = std::move(*snapshot);
+    _reservations.destroy(reservation);
+  }
+
+  std::optional<PlanningSnapshot> PlanningBoard::snapshotWithReservation(const Reservation& reservation) const
+  {
+    if (!_snapshot)
+      return std::nullopt;
+    return _snapshot->withReservation(reservation);
+  }
+
+  void PlanningBoard::insertIntoIndices(Reservation* reservation, std::optional<PlanningSnapshot> snapshot)
+  {
+    insertIntoPeriodIndex(reservation);
+    insertIntoExtent(reservation);
+    if (reservation->id() != 0)
+      _reservationsById[reservation->id()] = reservation;
+    if (snapshot)
+      *_snapshot = std::move(*snapshot);
   }
 
   void PlanningBoard::clear()
   {
     _reservations.clear();
+    _reservationsById.clear();
     _rooms.clear();
+    _periodIndex.clear();
+    _extentBegins.clear();
+    _extentEnds.clear();
+    if (_occupancy)
+      _occupancy->clear();
+    if (_snapshot)
+      *_snapshot = PlanningSnapshot();
+    if (_analytics)
+      _analytics->clear();
   }
 
   bool PlanningBoard::canAddReservation(const Reservation& reservation) const
@@ -99,22 +266,37 @@ namespace hotel
 
     auto& atoms = reservation.atoms();
     return std::all_of(atoms.begin(), atoms.end(),
-                       [this](auto& atom) { return this->isFree(atom.roomId(), atom.dateRange()); });
+                       [this](auto& atom) { return this->isFree(atom.roomId(), atom.dayRange()); });
   }
 
   bool PlanningBoard::isFree(int roomId, boost::gregorian::date_period period) const
+  {
+    return isFree(roomId, DayRange::fromPeriod(period));
+  }
+
+  bool PlanningBoard::isFree(int roomId, DayRange range) const
   {
     auto roomIt = _rooms.find(roomId);
     if (roomIt == _rooms.end())
       return true;
 
-    // TODO: This can be made more efficient! log(n) instead of linear
+    // Only the first atom ending after the begin of the range can intersect it. An empty range is treated as the single
+    // night starting at its begin date (this matches the semantics of date_period::intersects).
     auto& roomAtoms = roomIt->second;
-    return std::none_of(roomAtoms.begin(), roomAtoms.end(),
-                        [&period](auto x) { return x->dateRange().intersects(period); });
+    auto it = firstAtomEndingAfter(roomAtoms, range.begin());
+    if (it == roomAtoms.end())
+      return true;
+
+    auto rangeEnd = std::max(range.end(), range.begin() + 1);
+    return it->second->dayRange().begin() >= rangeEnd;
   }
 
   int PlanningBoard::getAvailableDaysFrom(int roomId, boost::gregorian::date date) const
+  {
+    return getAvailableDaysFrom(roomId, Day::fromDate(date));
+  }
+
+  int PlanningBoard::getAvailableDaysFrom(int roomId, Day day) const
   {
     auto roomIt = _rooms.find(roomId);
     if (roomIt == _rooms.end())
@@ -123,21 +305,197 @@ namespace hotel
     // Find the first element which would influence the number of available days: i.e.
     // atom.period.end > date
     auto& roomAtoms = roomIt->second;
-    auto it = std::upper_bound(roomAtoms.begin(), roomAtoms.end(), date,
-                               [](auto date, auto& x) { return date < x->dateRange().end(); });
+    auto it = firstAtomEndingAfter(roomAtoms, day);
 
     if (it == roomAtoms.end())
       return std::numeric_limits<int>::max();
     else
-      return std::max<int>(0, ((*it)->dateRange().begin() - date).days());
+      return std::max(0, it->second->dayRange().begin() - day);
+  }
+
+  void PlanningBoard::setOccupancyBitmapEnabled(bool enabled)
+  {
+    if (enabled == isOccupancyBitmapEnabled())
+      return;
+
+    if (!enabled)
+    {
+      _occupancy = nullptr;
+      return;
+    }
+
+    _occupancy = std::make_unique<OccupancyBitmap>();
+    for (auto& roomRow : _rooms)
+      for (auto& atom : roomRow.second)
+        _occupancy->setOccupied(roomRow.first, atom.second->dayRange(), true);
+  }
+
+  bool PlanningBoard::isOccupancyBitmapEnabled() const { return _occupancy != nullptr; }
+
+  void PlanningBoard::setSnapshotTrackingEnabled(bool enabled)
+  {
+    if (enabled == isSnapshotTrackingEnabled())
+      return;
+
+    if (!enabled)
+    {
+      _snapshot = nullptr;
+      return;
+    }
+
+    auto snapshot = PlanningSnapshot();
+    _reservations.forEach([&snapshot](const Reservation* reservation) {
+      snapshot = snapshot.withReservation(*reservation);
+    });
+    _snapshot = std::make_unique<PlanningSnapshot>(std::move(snapshot));
+  }
+
+  bool PlanningBoard::isSnapshotTrackingEnabled() const { return _snapshot != nullptr; }
+
+  PlanningSnapshot PlanningBoard::snapshot() const
+  {
+    if (!_snapshot)
+      throw std::logic_error("cannot take a snapshot of the planning board, snapshot tracking is disabled");
+    return *_snapshot;
+  }
+
+  void PlanningBoard::enableOccupancyAnalytics(const HotelCollection& hotels, ThreadPool& pool)
+  {
+    _analytics = std::make_unique<OccupancyAnalytics>(hotels);
+    _analytics->rebuild(static_cast<const PlanningBoard*>(this)->reservations(), pool);
+  }
+
+  void PlanningBoard::disableOccupancyAnalytics() { _analytics = nullptr; }
+
+  bool PlanningBoard::isOccupancyAnalyticsEnabled() const { return _analytics != nullptr; }
+
+  const OccupancyAnalytics& PlanningBoard::occupancyAnalytics() const
+  {
+    if (!_analytics)
+      throw std::logic_error("occupancy analytics of the planning board are disabled");
+    return *_analytics;
+  }
+
+  std::vector<int> PlanningBoard::getFreeRooms(const std::vector<int>& roomIds,
+                                               boost::gregorian::date_period period) const
+  {
+    auto range = DayRange::fromPeriod(period);
+    if (_occupancy)
+      return _occupancy->getFreeRooms(roomIds, range);
+
+    std::vector<int> result;
+    std::copy_if(roomIds.begin(), roomIds.end(), std::back_inserter(result),
+                 [this, range](int roomId) { return isFree(roomId, range); });
+    return result;
+  }
+
+  std::vector<int> PlanningBoard::getFreeRooms(const HotelCollection& hotels, int categoryId,
+                                               boost::gregorian::date_period period) const
+  {
+    std::vector<int> roomIds;
+    for (auto& hotel : hotels.hotels())
+      for (auto& room : hotel->rooms())
+        if (room->category() != nullptr && room->category()->id() == categoryId)
+          roomIds.push_back(room->id());
+    return getFreeRooms(roomIds, period);
+  }
+
+  GroupAllocation PlanningBoard::allocateGroup(const HotelCollection& hotels, const GroupRequest& request,
+                                               ThreadPool& pool) const
+  {
+    GroupAllocation result;
+    result.period = request.period;
+    if (request.period.begin().is_special() || request.period.end().is_special() || request.period.is_null())
+    {
+      result.error = "the period of the group is empty";
+      return result;
+    }
+    auto range = DayRange::fromPeriod(request.period);
+
+    // Collect the rooms of the requested categories, together with their row in the planning
+    struct Candidate
+    {
+      int roomId;
+      int row;
+    };
+    std::vector<Candidate> candidates;
+    std::map<int, std::vector<std::size_t>> candidatesByCategory;
+    std::map<int, std::string> categoryNames;
+    int row = 0;
+    for (auto& hotel : hotels.hotels())
+      for (auto& room : hotel->rooms())
+      {
+        auto category = room->category();
+        if (category != nullptr && request.roomsPerCategory.count(category->id()) != 0)
+        {
+          candidatesByCategory[category->id()].push_back(candidates.size());
+          categoryNames[category->id()] = category->shortCode();
+          candidates.push_back(Candidate{room->id(), row});
+        }
+        ++row;
+      }
+
+    std::vector<char> isCandidateFree(candidates.size());
+    pool.parallelFor(candidates.size(),
+                     [&](std::size_t i) { isCandidateFree[i] = isFree(candidates[i].roomId, range) ? 1 : 0; });
+
+    std::ostringstream errors;
+    for (auto& requested : request.roomsPerCategory)
+    {
+      auto categoryId = requested.first;
+      auto count = requested.second;
+      if (count <= 0)
+      {
+        if (count < 0)
+          errors << "; category " << categoryId << ": cannot allocate " << count << " rooms";
+        continue;
+      }
+
+      auto& categoryCandidates = candidatesByCategory[categoryId];
+      std::vector<const Candidate*> freeRooms;
+      for (auto index : categoryCandidates)
+        if (isCandidateFree[index])
+          freeRooms.push_back(&candidates[index]);
+
+      if (categoryCandidates.empty())
+      {
+        errors << "; category " << categoryId << ": there are no rooms in this category";
+        continue;
+      }
+      if (freeRooms.size() < static_cast<std::size_t>(count))
+      {
+        errors << "; category " << categoryNames[categoryId] << " (" << categoryId << "): " << count
+               << " rooms requested, but only " << freeRooms.size() << " of " << categoryCandidates.size()
+               << " rooms are free from " << boost::gregorian::to_iso_extended_string(request.period.begin()) << " to "
+               << boost::gregorian::to_iso_extended_string(request.period.end());
+        continue;
+      }
+
+      // Pick the window of consecutive free rooms which spans the fewest rows
+      std::size_t best = 0;
+      for (std::size_t first = 1; first + count <= freeRooms.size(); ++first)
+        if (freeRooms[first + count - 1]->row - freeRooms[first]->row <
+            freeRooms[best + count - 1]->row - freeRooms[best]->row)
+          best = first;
+      for (std::size_t i = best; i < best + count; ++i)
+        result.roomIds.push_back(freeRooms[i]->roomId);
+    }
+
+    // Errors are prefixed with a separator
+    result.error = errors.str();
+    if (!result.error.empty())
+    {
+      result.error.erase(0, 2);
+      result.roomIds.clear();
+    }
+    return result;
   }
 
   std::vector<Reservation*> PlanningBoard::reservations()
   {
     std::vector<Reservation*> result;
     result.reserve(_reservations.size());
-    for (auto& reservation : _reservations)
-      result.push_back(reservation.get());
+    _reservations.forEach([&result](Reservation* reservation) { result.push_back(reservation); });
     return result;
   }
 
@@ -145,36 +503,28 @@ namespace hotel
   {
     std::vector<const Reservation*> result;
     result.reserve(_reservations.size());
-    for (auto& reservation : _reservations)
-      result.push_back(reservation.get());
+    _reservations.forEach([&result](const Reservation* reservation) { result.push_back(reservation); });
     return result;
   }
 
   std::vector<Reservation*> PlanningBoard::getReservationsInPeriod(boost::gregorian::date_period period)
   {
     std::vector<Reservation*> result;
-    for (auto& reservation : _reservations)
-      if (reservation->dateRange().intersects(period))
-        result.push_back(reservation.get());
+    forEachReservationInPeriod(period, [&result](Reservation* reservation) { result.push_back(reservation); });
     return result;
   }
 
   std::vector<const Reservation*> PlanningBoard::getReservationsInPeriod(boost::gregorian::date_period period) const
   {
     std::vector<const Reservation*> result;
-    for (auto& reservation : _reservations)
-      if (reservation->dateRange().intersects(period))
-        result.push_back(reservation.get());
+    forEachReservationInPeriod(period, [&result](const Reservation* reservation) { result.push_back(reservation); });
     return result;
   }
 
-  const Reservation *PlanningBoard::getReservationById(int id) const
+  const Reservation* PlanningBoard::getReservationById(int id) const
   {
-    auto it = std::find_if(_reservations.begin(), _reservations.end(), [id](auto& x) { return x->id() == id; });
-    if (it != _reservations.end())
-      return it->get();
-    else
-      return nullptr;
+    auto it = _reservationsById.find(id);
+    return it != _reservationsById.end() ? it->second : nullptr;
   }
 
   boost::gregorian::date_period PlanningBoard::getPlanningExtent() const
@@ -187,29 +537,112 @@ namespace hotel
     }
     else
     {
-      date from(pos_infin);
-      date to(neg_infin);
-      for (auto& roomRow : _rooms)
-      {
-        if (!roomRow.second.empty())
-        {
-          auto& atoms = roomRow.second;
-          from = std::min(from, atoms.front()->dateRange().begin());
-          to = std::max(to, atoms.back()->dateRange().end());
-        }
-      }
-      assert(!from.is_special() && !to.is_special() && from < to);
-      return date_period(from, to);
+      auto from = _extentBegins.begin()->first;
+      auto to = _extentEnds.rbegin()->first;
+      assert(from < to);
+      return DayRange(from, to).toPeriod();
     }
   }
 
   void PlanningBoard::insertAtom(const ReservationAtom* atom)
   {
-    // TODO: This can be made more efficient! Linear instead of n*log(n)
     auto& roomAtoms = _rooms[atom->roomId()];
-    roomAtoms.push_back(atom);
-    std::sort(roomAtoms.begin(), roomAtoms.end(),
-              [](auto x, auto y) { return x->dateRange().begin() < y->dateRange().begin(); });
+    roomAtoms.emplace_hint(roomAtoms.end(), atom->dayRange().begin(), atom);
+    if (_occupancy)
+      _occupancy->setOccupied(atom->roomId(), atom->dayRange(), true);
+    if (_analytics)
+      _analytics->addOccupancy(atom->roomId(), atom->dayRange(), 1);
+  }
+
+  void PlanningBoard::removeAtom(const ReservationAtom* atom)
+  {
+    auto roomIt = _rooms.find(atom->roomId());
+    if (roomIt == _rooms.end())
+      return;
+
+    auto& roomAtoms = roomIt->second;
+    auto atomIt = roomAtoms.find(atom->dayRange().begin());
+    if (atomIt != roomAtoms.end() && atomIt->second == atom)
+    {
+      roomAtoms.erase(atomIt);
+      if (_occupancy)
+        _occupancy->setOccupied(atom->roomId(), atom->dayRange(), false);
+      if (_analytics)
+        _analytics->addOccupancy(atom->roomId(), atom->dayRange(), -1);
+    }
+    if (roomAtoms.empty())
+      _rooms.erase(roomIt);
+  }
+
+  PlanningBoard::RoomAtoms::const_iterator PlanningBoard::firstAtomEndingAfter(const RoomAtoms& atoms, Day day)
+  {
+    // The last atom beginning on or before the day is the only one of those which can still end after it
+    auto it = atoms.upper_bound(day);
+    if (it != atoms.begin())
+    {
+      auto previous = std::prev(it);
+      if (previous->second->dayRange().end() > day)
+        return previous;
+    }
+    return it;
+  }
+
+  int PlanningBoard::periodIndexBucket(Day day)
+  {
+    // Rounds towards negative infinity, so that every bucket spans exactly seven days
+    auto number = day.number();
+    return (number >= 0 ? number : number - 6) / 7;
+  }
+
+  void PlanningBoard::insertIntoExtent(const Reservation* reservation)
+  {
+    ++_extentBegins[reservation->atoms().front().dayRange().begin()];
+    ++_extentEnds[reservation->atoms().back().dayRange().end()];
+  }
+
+  void PlanningBoard::removeFromExtent(const Reservation* reservation)
+  {
+    auto removeEndpoint = [](ExtentEndpoints& endpoints, Day day) {
+      auto it = endpoints.find(day);
+      assert(it != endpoints.end());
+      if (--it->second == 0)
+        endpoints.erase(it);
+    };
+    removeEndpoint(_extentBegins, reservation->atoms().front().dayRange().begin());
+    removeEndpoint(_extentEnds, reservation->atoms().back().dayRange().end());
+  }
+
+  void PlanningBoard::insertIntoPeriodIndex(Reservation* reservation)
+  {
+    auto begin = reservation->atoms().front().dayRange().begin();
+    auto end = reservation->atoms().back().dayRange().end();
+    auto lastBucket = periodIndexBucket(end - 1);
+    for (auto bucket = periodIndexBucket(begin); bucket <= lastBucket; ++bucket)
+      _periodIndex[bucket].push_back(PeriodIndexEntry{begin, end, reservation});
+  }
+
+  void PlanningBoard::removeFromPeriodIndex(const Reservation* reservation)
+  {
+    auto begin = reservation->atoms().front().dayRange().begin();
+    auto end = reservation->atoms().back().dayRange().end();
+    auto lastBucket = periodIndexBucket(end - 1);
+    for (auto bucket = periodIndexBucket(begin); bucket <= lastBucket; ++bucket)
+    {
+      auto bucketIt = _periodIndex.find(bucket);
+      if (bucketIt == _periodIndex.end())
+        continue;
+
+      auto& entries = bucketIt->second;
+      auto entryIt = std::find_if(entries.begin(), entries.end(),
+                                  [reservation](auto& entry) { return entry.reservation == reservation; });
+      if (entryIt != entries.end())
+      {
+        *entryIt = entries.back();
+        entries.pop_back();
+      }
+      if (entries.empty())
+        _periodIndex.erase(bucketIt);
+    }
   }
 
 } // namespace hotel
@@ -1,18 +1,31 @@
 #ifndef HOTEL_PLANNING_H
 #define HOTEL_PLANNING_H
 
+#include "hotel/day.h"
+#include "hotel/groupallocation.h"
+#include "hotel/occupancyanalytics.h"
+#include "hotel/occupancybitmap.h"
+#include "hotel/planningsnapshot.h"
 #include "hotel/reservation.h"
+#include "hotel/slabpool.h"
+#include "hotel/threadpool.h"
 
 #include <boost/date_time.hpp>
 
+#include <algorithm>
 #include <map>
 #include <memory>
+#include <memory_resource>
+#include <optional>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace hotel
 {
+  class HotelCollection;
+
   /**
    * @brief The PlanningBoard class holds planning information for a given set of rooms.
    *
@@ -26,6 +39,7 @@ namespace hotel
   class PlanningBoard
   {
   public:
+    PlanningBoard();
     PlanningBoard& operator=(const PlanningBoard& that);
     PlanningBoard& operator=(PlanningBoard&& that);
 
@@ -33,8 +47,24 @@ namespace hotel
      * @brief addReservation tries to add the given reservation to the planning board
      * @param reservation the reservation to add
      * @return a pointer to the added reservation on success, otherwise nullptr.
+     * @note The reservation is moved into the storage of the planning board, so the returned pointer does not point to
+     *       the given object. It stays valid until the reservation is removed from the board.
      */
     Reservation* addReservation(std::unique_ptr<Reservation> reservation);
+    /**
+     * @brief addReservations adds a whole batch of reservations to the planning board
+     *
+     * The result is the same as adding the reservations one after the other, except that reservations which cannot be
+     * added are skipped instead of throwing. The batch is validated with one sort and sweep over the atoms of each
+     * room, which makes this considerably faster than repeated calls to addReservation when loading many reservations.
+     *
+     * @param reservations the reservations to add
+     * @return for each of the given reservations, a pointer to the added reservation, or nullptr if it could not be
+     *         added (i.e. it is invalid, overlaps with another reservation or its id is already used).
+     */
+    std::vector<Reservation*> addReservations(std::vector<std::unique_ptr<Reservation>> reservations);
+    //! Same as above, but takes the reservations by value, which avoids allocating each one separately
+    std::vector<Reservation*> addReservations(std::vector<Reservation> reservations);
     /**
      * @brief removeReservation deletes the given reservation from the planning board
      * @param reservation the reservation to delete
@@ -58,6 +88,7 @@ namespace hotel
     bool canAddReservation(const Reservation& reservation) const;
 
     bool isFree(int roomId, boost::gregorian::date_period period) const;
+    bool isFree(int roomId, DayRange range) const;
 
     /**
      * @brief getAvailableDaysFrom computes the number of days in which the given room is available from the given date
@@ -66,31 +97,215 @@ namespace hotel
      *         always available max is returned.
      */
     int getAvailableDaysFrom(int roomId, boost::gregorian::date date) const;
+    int getAvailableDaysFrom(int roomId, Day day) const;
+
+    /**
+     * @brief setOccupancyBitmapEnabled enables or disables the per-night occupancy bitmap of the planning board
+     *
+     * The bitmap costs one bit per room and night and makes availability queries over many rooms (see getFreeRooms)
+     * considerably faster. It is disabled by default.
+     */
+    void setOccupancyBitmapEnabled(bool enabled);
+    bool isOccupancyBitmapEnabled() const;
+
+    /**
+     * @brief setSnapshotTrackingEnabled enables or disables snapshots of the planning board
+     *
+     * While enabled, the planning board keeps a PlanningSnapshot up to date, which costs O(log n) and a copy of the
+     * reservation for every added or removed reservation. It is disabled by default.
+     */
+    void setSnapshotTrackingEnabled(bool enabled);
+    bool isSnapshotTrackingEnabled() const;
+    /**
+     * @brief snapshot returns an immutable copy of the current state of the planning board in O(1)
+     *
+     * The snapshot can be read from any thread, while this planning board keeps being modified.
+     *
+     * @throw std::logic_error if snapshot tracking is not enabled
+     */
+    PlanningSnapshot snapshot() const;
 
+    /**
+     * @brief enableOccupancyAnalytics keeps occupancy analytics for the rooms of the given hotels up to date
+     *
+     * The analytics are rebuilt from all reservations of the planning board on the given thread pool. Afterwards, every
+     * added or removed atom costs an additional O(log n). The analytics only know the rooms the hotels had when they
+     * were enabled, so they have to be enabled again when rooms are added. They are disabled by default.
+     */
+    void enableOccupancyAnalytics(const HotelCollection& hotels, ThreadPool& pool = ThreadPool::shared());
+    void disableOccupancyAnalytics();
+    bool isOccupancyAnalyticsEnabled() const;
+    /**
+     * @brief occupancyAnalytics returns the occupied room nights per day, category and hotel
+     * @throw std::logic_error if occupancy analytics are not enabled
+     */
+    const OccupancyAnalytics& occupancyAnalytics() const;
+
+    /**
+     * @brief getFreeRooms returns the subset of the given rooms which are free during the whole period
+     * @return the free room ids, in the order in which they were given.
+     */
+    std::vector<int> getFreeRooms(const std::vector<int>& roomIds, boost::gregorian::date_period period) const;
+    std::vector<int> getFreeRooms(const HotelCollection& hotels, int categoryId,
+                                  boost::gregorian::date_period period) const;
+
+    /**
+     * @brief allocateGroup finds free rooms for all of the rooms requested by a group
+     *
+     * Within each category, the rooms are chosen as close together as possible in the order of Hotel::rooms(), i.e. on
+     * adjacent rows of the planning. The availability of the candidate rooms is evaluated on the given thread pool.
+     * The planning board itself is not modified.
+     *
+     * @return the allocated rooms, or an explanation of why the group cannot be accommodated
+     */
+    GroupAllocation allocateGroup(const HotelCollection& hotels, const GroupRequest& request,
+                                  ThreadPool& pool = ThreadPool::shared()) const;
+
+    /**
+     * @brief reservations returns all of the reservations on the planning board
+     * @note The order of the reservations is unspecified, and changes when reservations are removed.
+     */
     std::vector<Reservation*> reservations();
     std::vector<const Reservation*> reservations() const;
     std::vector<Reservation*> getReservationsInPeriod(boost::gregorian::date_period period);
     std::vector<const Reservation*> getReservationsInPeriod(boost::gregorian::date_period period) const;
 
+    /**
+     * @brief forEachReservationInPeriod calls func once for every reservation intersecting the given period
+     *
+     * The query is answered from a weekly bucketed index. Its cost depends on the number of reservations around the
+     * given period, and not on the total number of reservations. No memory is allocated.
+     *
+     * @note func must not add or remove reservations on this planning board.
+     */
+    template <class Func> void forEachReservationInPeriod(boost::gregorian::date_period period, Func&& func);
+    template <class Func> void forEachReservationInPeriod(boost::gregorian::date_period period, Func&& func) const;
+
+    /**
+     * @brief getReservationById returns the reservation with the given id in O(1)
+     * @return the reservation or nullptr, if there is no such reservation. Reservations which have not been persisted
+     *         yet (i.e. whose id is 0) cannot be looked up.
+     */
     const Reservation* getReservationById(int id) const;
 
     /**
-     * @brief getPlanningExtent Returns the date period encompassing all of the reservations
+     * @brief getPlanningExtent Returns the date period encompassing all of the reservations in O(1)
      * @return If there are no reservation, an empty period is returned, encompassing the current day.
      */
     boost::gregorian::date_period getPlanningExtent() const;
 
   private:
+    /**
+     * @brief RoomAtoms holds all of the atoms of a single room, keyed by their begin date.
+     *
+     * Atoms in the same room never overlap, thus ordering them by begin date also orders them by end date. This allows
+     * every query on a room to be answered with a single O(log n) lookup.
+     */
+    typedef std::pmr::map<Day, const ReservationAtom*> RoomAtoms;
+
     /**
      * @brief insertAtom Inserts a given reservation atom to the PlanningBoard.
      * @note This function does not verify constraints to avoid overlapping atoms.
      */
-    void insertAtom(const ReservationAtom* atom); // TODO: Make this more efficient
+    void insertAtom(const ReservationAtom* atom);
+    void removeAtom(const ReservationAtom* atom);
+
+    //! Validates the batch and moves the accepted reservations into the pool. Null entries are rejected.
+    std::vector<Reservation*> addReservationBatch(const std::vector<Reservation*>& candidates);
+    //! Removes the given reservation, which must be owned by this planning board
+    void eraseReservation(Reservation* reservation);
+    /**
+     * @brief snapshotWithReservation returns the tracked snapshot with the given reservation added to it
+     *
+     * Adding to the snapshot may throw, so this is done before the board is modified. The result is std::nullopt if
+     * snapshot tracking is disabled.
+     */
+    std::optional<PlanningSnapshot> snapshotWithReservation(const Reservation& reservation) const;
+    /**
+     * @brief insertIntoIndices adds the reservation to the period index, the extent and the id index, and replaces the
+     *        tracked snapshot by the given one (but does not insert its atoms)
+     */
+    void insertIntoIndices(Reservation* reservation, std::optional<PlanningSnapshot> snapshot);
+
+    //! Returns the first atom in the room which ends after the given day, i.e. atom.end > day
+    static RoomAtoms::const_iterator firstAtomEndingAfter(const RoomAtoms& atoms, Day day);
+
+    /**
+     * @brief PeriodIndexEntry stores the extent of a reservation in each of the weekly buckets it touches
+     *
+     * The extent is copied into the entry, so that queries do not have to look at the atoms of the reservation.
+     */
+    struct PeriodIndexEntry
+    {
+      Day begin;
+      Day end;
+      Reservation* reservation;
+    };
+    typedef std::pmr::map<int, std::pmr::vector<PeriodIndexEntry>> PeriodIndex;
+
+    /**
+     * @brief ExtentEndpoints counts how many reservations begin (or end) on each date
+     *
+     * The planning extent spans from the first begin to the last end date. Counting the endpoints allows to keep it up
+     * to date when a reservation on the boundary is removed.
+     */
+    typedef std::pmr::map<Day, int> ExtentEndpoints;
+
+    void insertIntoExtent(const Reservation* reservation);
+    void removeFromExtent(const Reservation* reservation);
+
+    static int periodIndexBucket(Day day);
+    void insertIntoPeriodIndex(Reservation* reservation);
+    void removeFromPeriodIndex(const Reservation* reservation);
+    template <class Func> void visitPeriodIndex(DayRange range, Func&& func) const;
+
+    // The nodes of all of the indices are allocated from this pool. It is declared first, so that it outlives them.
+    std::unique_ptr<std::pmr::unsynchronized_pool_resource> _indexMemory;
 
-    std::vector<std::unique_ptr<Reservation>> _reservations;
-    std::map<int, std::vector<const ReservationAtom*>> _rooms;
+    // All reservations are owned by the pool, persisted reservations are also indexed by their id
+    SlabPool<Reservation> _reservations;
+    std::pmr::unordered_map<int, Reservation*> _reservationsById;
+    std::pmr::map<int, RoomAtoms> _rooms;
+    PeriodIndex _periodIndex;
+    ExtentEndpoints _extentBegins;
+    ExtentEndpoints _extentEnds;
+    // Only maintained if enabled, see setOccupancyBitmapEnabled
+    std::unique_ptr<OccupancyBitmap> _occupancy;
+    // Only maintained if enabled, see setSnapshotTrackingEnabled
+    std::unique_ptr<PlanningSnapshot> _snapshot;
+    // Only maintained if enabled, see enableOccupancyAnalytics
+    std::unique_ptr<OccupancyAnalytics> _analytics;
   };
 
+  template <class Func>
+  void PlanningBoard::forEachReservationInPeriod(boost::gregorian::date_period period, Func&& func)
+  {
+    visitPeriodIndex(DayRange::fromPeriod(period), [&func](Reservation* reservation) { func(reservation); });
+  }
+
+  template <class Func>
+  void PlanningBoard::forEachReservationInPeriod(boost::gregorian::date_period period, Func&& func) const
+  {
+    visitPeriodIndex(DayRange::fromPeriod(period), [&func](const Reservation* reservation) { func(reservation); });
+  }
+
+  template <class Func>
+  void PlanningBoard::visitPeriodIndex(DayRange range, Func&& func) const
+  {
+    // An empty range is treated as the single night starting at its begin date
+    auto begin = range.begin();
+    auto end = std::max(range.end(), begin + 1);
+    auto lastBucket = periodIndexBucket(end - 1);
+    auto bucketsEnd = _periodIndex.upper_bound(lastBucket);
+    for (auto it = _periodIndex.lower_bound(periodIndexBucket(begin)); it != bucketsEnd; ++it)
+    {
+      // Reservations spanning multiple buckets are only reported in the first bucket in which they meet the period
+      for (auto& entry : it->second)
+        if (entry.begin < end && begin < entry.end && periodIndexBucket(std::max(entry.begin, begin)) == it->first)
+          func(entry.reservation);
+    }
+  }
+
 } // namespace hotel
 
 #endif // HOTEL_PLANNING_H
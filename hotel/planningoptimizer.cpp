@@ -0,0 +1,309 @@
+#include "hotel/planningoptimizer.h"
+
+#include "hotel/hotelcollection.h"
+#include "hotel/planning.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <random>
+#include <unordered_map>
+
+namespace hotel
+{
+  /**
+   * @brief The Worker class runs the local search on its own copy of the planning
+   *
+   * All changes of the cost are computed locally: moving an atom only changes the gaps next to it, in the room it
+   * leaves and in the room it enters, and the room changes with the atoms before and after it in the reservation.
+   */
+  class PlanningOptimizer::Worker
+  {
+  public:
+    Worker(const PlanningOptimizer& optimizer, const Options& options, unsigned seed)
+        : _optimizer(optimizer), _options(options), _rng(seed), _rooms(optimizer._roomIds.size())
+    {
+      for (int r = 0; r < static_cast<int>(optimizer._reservations.size()); ++r)
+      {
+        auto& info = optimizer._reservations[r];
+        _atomRooms.push_back(info.atomRooms);
+        for (int i = 0; i < static_cast<int>(info.atomRanges.size()); ++i)
+          _rooms[info.atomRooms[i]].emplace(info.atomRanges[i].begin(), Slot{info.atomRanges[i].end(), r, i});
+      }
+    }
+
+    void run(std::chrono::steady_clock::time_point deadline)
+    {
+      auto& movable = _optimizer._movable;
+      if (movable.empty())
+        return;
+
+      // Stop early once no move has been found for a while, the planning is then most likely a local optimum
+      std::uniform_int_distribution<std::size_t> reservationDist(0, movable.size() - 1);
+      std::size_t failures = 0;
+      for (std::size_t iteration = 0; failures < 3 * movable.size() + 100; ++iteration)
+      {
+        if (iteration % 64 == 0 && std::chrono::steady_clock::now() >= deadline)
+          break;
+
+        auto r = movable[reservationDist(_rng)];
+        auto atomCount = static_cast<int>(_atomRooms[r].size());
+        auto atom = std::uniform_int_distribution<int>(0, atomCount - 1)(_rng);
+        if ((atomCount > 1 && tryMoveReservation(r)) || tryMoveAtom(r, atom))
+          failures = 0;
+        else
+          ++failures;
+      }
+    }
+
+    int cost() const { return orphanedNights() + _options.roomChangeCost * roomChanges(); }
+
+    int orphanedNights() const
+    {
+      int result = 0;
+      for (auto& atoms : _rooms)
+        for (auto it = atoms.begin(); it != atoms.end() && std::next(it) != atoms.end(); ++it)
+          result += orphaned(it->second.end, std::next(it)->first);
+      return result;
+    }
+
+    int roomChanges() const
+    {
+      int result = 0;
+      for (auto& rooms : _atomRooms)
+        result += changes(rooms);
+      return result;
+    }
+
+    const std::vector<std::vector<int>>& atomRooms() const { return _atomRooms; }
+
+  private:
+    struct Slot
+    {
+      Day end;
+      int reservation;
+      int atom;
+    };
+    typedef std::map<Day, Slot> RoomAtoms;
+
+    int orphaned(Day from, Day to) const
+    {
+      auto gap = to - from;
+      return gap > 0 && gap < _options.minimumStay ? gap : 0;
+    }
+
+    static int changes(const std::vector<int>& rooms)
+    {
+      int result = 0;
+      for (std::size_t i = 1; i < rooms.size(); ++i)
+        result += rooms[i - 1] != rooms[i] ? 1 : 0;
+      return result;
+    }
+
+    //! Returns the change of the orphaned nights if the atom with the given range is removed from the room
+    int removalDelta(int room, DayRange range) const
+    {
+      auto& atoms = _rooms[room];
+      auto it = atoms.find(range.begin());
+      auto next = std::next(it);
+      auto hasPrevious = it != atoms.begin();
+      auto hasNext = next != atoms.end();
+      auto previousEnd = hasPrevious ? std::prev(it)->second.end : Day();
+
+      auto before = (hasPrevious ? orphaned(previousEnd, range.begin()) : 0) +
+                    (hasNext ? orphaned(range.end(), next->first) : 0);
+      auto after = hasPrevious && hasNext ? orphaned(previousEnd, next->first) : 0;
+      return after - before;
+    }
+
+    //! Computes the change of the orphaned nights if an atom with the given range is added to the room
+    //! @return false if the room is not free during the range
+    bool insertionDelta(int room, DayRange range, int& delta) const
+    {
+      auto& atoms = _rooms[room];
+      auto next = atoms.lower_bound(range.begin());
+      auto hasNext = next != atoms.end();
+      if (hasNext && next->first < range.end())
+        return false;
+      auto hasPrevious = next != atoms.begin();
+      auto previousEnd = hasPrevious ? std::prev(next)->second.end : Day();
+      if (hasPrevious && previousEnd > range.begin())
+        return false;
+
+      auto before = hasPrevious && hasNext ? orphaned(previousEnd, next->first) : 0;
+      auto after = (hasPrevious ? orphaned(previousEnd, range.begin()) : 0) +
+                   (hasNext ? orphaned(range.end(), next->first) : 0);
+      delta = after - before;
+      return true;
+    }
+
+    //! Returns the rooms of the category, starting at a random one so that workers explore different ties
+    template <class Func> void forEachRoomOfCategory(int category, Func&& func)
+    {
+      auto& rooms = _optimizer._categoryRooms[category];
+      auto offset = std::uniform_int_distribution<std::size_t>(0, rooms.size() - 1)(_rng);
+      for (std::size_t i = 0; i < rooms.size(); ++i)
+        func(rooms[(offset + i) % rooms.size()]);
+    }
+
+    //! Moves a single atom to the room of its category which lowers the cost the most, if there is one
+    bool tryMoveAtom(int r, int i)
+    {
+      auto& rooms = _atomRooms[r];
+      auto range = _optimizer._reservations[r].atomRanges[i];
+      auto currentRoom = rooms[i];
+      auto category = _optimizer._roomCategory[currentRoom];
+      if (category < 0)
+        return false;
+
+      auto changesWith = [&rooms, i](int room) {
+        auto previous = i > 0 && rooms[i - 1] != room ? 1 : 0;
+        auto next = i + 1 < static_cast<int>(rooms.size()) && rooms[i + 1] != room ? 1 : 0;
+        return previous + next;
+      };
+
+      auto removal = removalDelta(currentRoom, range) - _options.roomChangeCost * changesWith(currentRoom);
+      auto bestDelta = 0;
+      auto bestRoom = -1;
+      forEachRoomOfCategory(category, [&](int room) {
+        int insertion;
+        if (room == currentRoom || !insertionDelta(room, range, insertion))
+          return;
+        auto delta = removal + insertion + _options.roomChangeCost * changesWith(room);
+        if (delta < bestDelta)
+        {
+          bestDelta = delta;
+          bestRoom = room;
+        }
+      });
+      if (bestRoom < 0)
+        return false;
+
+      auto slot = _rooms[currentRoom].at(range.begin());
+      _rooms[currentRoom].erase(range.begin());
+      _rooms[bestRoom].emplace(range.begin(), slot);
+      rooms[i] = bestRoom;
+      return true;
+    }
+
+    //! Moves all atoms of the reservation into a single room, if that lowers the cost
+    bool tryMoveReservation(int r)
+    {
+      auto& rooms = _atomRooms[r];
+      auto& ranges = _optimizer._reservations[r].atomRanges;
+      auto category = _optimizer._roomCategory[rooms[0]];
+      if (category < 0 ||
+          std::any_of(rooms.begin(), rooms.end(), [&](int room) { return _optimizer._roomCategory[room] != category; }))
+        return false;
+
+      // Take the reservation off the planning, so that its own atoms do not block any room
+      auto delta = -_options.roomChangeCost * changes(rooms);
+      for (std::size_t i = 0; i < rooms.size(); ++i)
+      {
+        delta += removalDelta(rooms[i], ranges[i]);
+        _rooms[rooms[i]].erase(ranges[i].begin());
+      }
+
+      auto whole = DayRange(ranges.front().begin(), ranges.back().end());
+      auto bestDelta = 0;
+      auto bestRoom = -1;
+      forEachRoomOfCategory(category, [&](int room) {
+        int insertion;
+        if (insertionDelta(room, whole, insertion) && delta + insertion < bestDelta)
+        {
+          bestDelta = delta + insertion;
+          bestRoom = room;
+        }
+      });
+
+      if (bestRoom >= 0)
+        std::fill(rooms.begin(), rooms.end(), bestRoom);
+      for (std::size_t i = 0; i < rooms.size(); ++i)
+        _rooms[rooms[i]].emplace(ranges[i].begin(), Slot{ranges[i].end(), r, static_cast<int>(i)});
+      return bestRoom >= 0;
+    }
+
+    const PlanningOptimizer& _optimizer;
+    const Options& _options;
+    std::mt19937 _rng;
+    std::vector<RoomAtoms> _rooms;
+    std::vector<std::vector<int>> _atomRooms;
+  };
+
+  PlanningOptimizer::PlanningOptimizer(const HotelCollection& hotels, const PlanningBoard& planning)
+  {
+    std::unordered_map<int, int> roomIndices;
+    std::unordered_map<int, int> categoryIndices;
+    for (auto& hotel : hotels.hotels())
+      for (auto& room : hotel->rooms())
+      {
+        if (room->category() == nullptr || roomIndices.count(room->id()) != 0)
+          continue;
+        auto category = categoryIndices.emplace(room->category()->id(), static_cast<int>(_categoryRooms.size()));
+        if (category.second)
+          _categoryRooms.emplace_back();
+        roomIndices[room->id()] = static_cast<int>(_roomIds.size());
+        _categoryRooms[category.first->second].push_back(static_cast<int>(_roomIds.size()));
+        _roomIds.push_back(room->id());
+        _roomCategory.push_back(category.first->second);
+      }
+
+    for (auto reservation : planning.reservations())
+    {
+      ReservationInfo info{*reservation, {}, {}, false};
+      auto status = reservation->status();
+      info.isLocked = status == Reservation::CheckedIn || status == Reservation::CheckedOut ||
+                      status == Reservation::Archived;
+      for (auto& atom : reservation->atoms())
+      {
+        auto room = roomIndices.emplace(atom.roomId(), static_cast<int>(_roomIds.size()));
+        if (room.second)
+        {
+          _roomIds.push_back(atom.roomId());
+          _roomCategory.push_back(-1);
+        }
+        info.atomRanges.push_back(atom.dayRange());
+        info.atomRooms.push_back(room.first->second);
+      }
+      if (!info.isLocked)
+        _movable.push_back(static_cast<int>(_reservations.size()));
+      _reservations.push_back(std::move(info));
+    }
+  }
+
+  PlanningOptimizer::Result PlanningOptimizer::optimize(const Options& options, ThreadPool& pool) const
+  {
+    auto deadline = std::chrono::steady_clock::now() + options.budget;
+
+    Result result;
+    Worker initial(*this, options, options.seed);
+    result.orphanedNightsBefore = initial.orphanedNights();
+    result.roomChangesBefore = initial.roomChanges();
+
+    std::vector<std::unique_ptr<Worker>> workers(pool.threadCount() + 1);
+    pool.parallelFor(workers.size(), [&](std::size_t i) {
+      workers[i] = std::make_unique<Worker>(*this, options, options.seed + static_cast<unsigned>(i));
+      workers[i]->run(deadline);
+    });
+    auto& best = **std::min_element(workers.begin(), workers.end(),
+                                    [](auto& a, auto& b) { return a->cost() < b->cost(); });
+    result.orphanedNightsAfter = best.orphanedNights();
+    result.roomChangesAfter = best.roomChanges();
+
+    // Only reservations which end up in different rooms need to be updated
+    for (std::size_t r = 0; r < _reservations.size(); ++r)
+    {
+      auto& rooms = best.atomRooms()[r];
+      if (rooms == _reservations[r].atomRooms)
+        continue;
+
+      auto reservation = _reservations[r].reservation;
+      for (std::size_t i = 0; i < rooms.size(); ++i)
+        reservation.atoms()[i].setRoomId(_roomIds[rooms[i]]);
+      reservation.joinAdjacentAtoms();
+      result.changedReservations.push_back(std::move(reservation));
+    }
+    return result;
+  }
+
+} // namespace hotel
@@ -0,0 +1,87 @@
+#ifndef HOTEL_PLANNINGOPTIMIZER_H
+#define HOTEL_PLANNINGOPTIMIZER_H
+
+#include "hotel/day.h"
+#include "hotel/reservation.h"
+#include "hotel/threadpool.h"
+
+#include <chrono>
+#include <vector>
+
+namespace hotel
+{
+  class HotelCollection;
+  class PlanningBoard;
+
+  /**
+   * @brief The PlanningOptimizer class reassigns rooms to reduce the fragmentation of the planning
+   *
+   * The optimizer moves reservations (or single atoms of reservations) to other rooms of the same category. The dates
+   * and all other properties of the reservations stay the same. The cost of a planning is the number of orphaned
+   * nights, i.e. free nights in gaps which are too short to be sold, plus a penalty for every room change inside of a
+   * reservation.
+   *
+   * Reservations which are checked in, checked out or archived are never moved, since their guests already occupy
+   * their rooms.
+   *
+   * The optimization is a local search: each worker thread repeatedly picks a reservation and moves it (or one of its
+   * atoms) to the best room of the category, if that lowers the cost. Workers start from the same planning with
+   * different random choices, and the best planning found within the time budget wins.
+   */
+  class PlanningOptimizer
+  {
+  public:
+    struct Options
+    {
+      //! The wall clock time after which the optimization stops
+      std::chrono::milliseconds budget{100};
+      //! Free gaps shorter than this many nights count as orphaned
+      int minimumStay = 3;
+      //! The cost of a room change inside of a reservation, relative to one orphaned night
+      int roomChangeCost = 3;
+      unsigned seed = 0;
+    };
+
+    struct Result
+    {
+      //! Copies of the reservations whose rooms have changed, with their new rooms. Unchanged reservations are omitted.
+      std::vector<Reservation> changedReservations;
+      int orphanedNightsBefore = 0;
+      int orphanedNightsAfter = 0;
+      int roomChangesBefore = 0;
+      int roomChangesAfter = 0;
+    };
+
+    //! Takes a copy of the planning, so that the board may change or go away before optimize() is called
+    PlanningOptimizer(const HotelCollection& hotels, const PlanningBoard& planning);
+
+    Result optimize(const Options& options, ThreadPool& pool = ThreadPool::shared()) const;
+
+  private:
+    class Worker;
+
+    struct ReservationInfo
+    {
+      //! A copy of the reservation as it was on the planning board
+      Reservation reservation;
+      std::vector<DayRange> atomRanges;
+      //! The room index of every atom in the original planning
+      std::vector<int> atomRooms;
+      bool isLocked;
+    };
+
+    std::vector<ReservationInfo> _reservations;
+    //! Indices into _reservations of the reservations which may be moved
+    std::vector<int> _movable;
+
+    // Rooms are identified by a dense index. Rooms which appear on the planning but not in the hotels have no category
+    // (-1), and their atoms are never moved.
+    std::vector<int> _roomIds;
+    std::vector<int> _roomCategory;
+    //! For each category, the indices of its rooms
+    std::vector<std::vector<int>> _categoryRooms;
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_PLANNINGOPTIMIZER_H
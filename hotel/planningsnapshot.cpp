@@ -0,0 +1,129 @@
+#include "hotel/planningsnapshot.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
+namespace hotel
+{
+  PlanningSnapshot PlanningSnapshot::withReservation(const Reservation& reservation) const
+  {
+    if (!canAddReservation(reservation))
+      throw std::logic_error("cannot add reservation " + reservation.description() + " to the snapshot");
+    if (reservation.id() != 0 && _reservationsById.find(reservation.id()) != nullptr)
+      throw std::logic_error("cannot add reservation " + reservation.description() + ", its id is already used");
+
+    auto copy = std::make_shared<const Reservation>(reservation);
+    PlanningSnapshot result = *this;
+    for (auto& atom : copy->atoms())
+      result._atoms = result._atoms.insert(AtomKey(atom.roomId(), atom.dayRange().begin()), AtomEntry{&atom, copy});
+    if (copy->id() != 0)
+      result._reservationsById = result._reservationsById.insert(copy->id(), copy);
+    else
+      ++result._unpersistedCount;
+    result._extentBegins = addEndpoint(result._extentBegins, copy->atoms().front().dayRange().begin(), 1);
+    result._extentEnds = addEndpoint(result._extentEnds, copy->atoms().back().dayRange().end(), 1);
+    return result;
+  }
+
+  PlanningSnapshot PlanningSnapshot::withoutReservation(const Reservation& reservation) const
+  {
+    // The first atom identifies the stored copy of the reservation, and the id makes sure that it is the same one
+    const Atoms::value_type* first = nullptr;
+    if (!reservation.atoms().empty())
+    {
+      auto& firstAtom = reservation.atoms().front();
+      first = _atoms.find(AtomKey(firstAtom.roomId(), firstAtom.dayRange().begin()));
+    }
+    auto isPartOfSnapshot = first != nullptr && first->second.reservation->id() == reservation.id();
+    assert(isPartOfSnapshot);
+    if (!isPartOfSnapshot)
+      return *this;
+
+    auto stored = first->second.reservation;
+    PlanningSnapshot result = *this;
+    for (auto& atom : stored->atoms())
+      result._atoms = result._atoms.erase(AtomKey(atom.roomId(), atom.dayRange().begin()));
+    if (stored->id() != 0)
+      result._reservationsById = result._reservationsById.erase(stored->id());
+    else
+      --result._unpersistedCount;
+    result._extentBegins = addEndpoint(result._extentBegins, stored->atoms().front().dayRange().begin(), -1);
+    result._extentEnds = addEndpoint(result._extentEnds, stored->atoms().back().dayRange().end(), -1);
+    return result;
+  }
+
+  PlanningSnapshot PlanningSnapshot::withoutReservation(int reservationId) const
+  {
+    auto reservation = getReservationById(reservationId);
+    return reservation != nullptr ? withoutReservation(*reservation) : *this;
+  }
+
+  bool PlanningSnapshot::canAddReservation(const Reservation& reservation) const
+  {
+    if (!reservation.isValid())
+      return false;
+
+    auto& atoms = reservation.atoms();
+    return std::all_of(atoms.begin(), atoms.end(),
+                       [this](auto& atom) { return this->isFree(atom.roomId(), atom.dayRange()); });
+  }
+
+  bool PlanningSnapshot::isFree(int roomId, boost::gregorian::date_period period) const
+  {
+    return isFree(roomId, DayRange::fromPeriod(period));
+  }
+
+  bool PlanningSnapshot::isFree(int roomId, DayRange range) const
+  {
+    // As on the planning board, an empty range is treated as the single night starting at its begin date
+    auto key = AtomKey(roomId, range.begin());
+    auto previous = _atoms.findLastNotAfter(key);
+    if (previous != nullptr && previous->first.first == roomId &&
+        previous->second.atom->dayRange().end() > range.begin())
+      return false;
+
+    auto next = _atoms.findFirstAfter(key);
+    auto rangeEnd = std::max(range.end(), range.begin() + 1);
+    return next == nullptr || next->first.first != roomId || next->first.second >= rangeEnd;
+  }
+
+  int PlanningSnapshot::getAvailableDaysFrom(int roomId, Day day) const
+  {
+    auto key = AtomKey(roomId, day);
+    auto previous = _atoms.findLastNotAfter(key);
+    if (previous != nullptr && previous->first.first == roomId && previous->second.atom->dayRange().end() > day)
+      return 0;
+
+    auto next = _atoms.findFirstAfter(key);
+    if (next == nullptr || next->first.first != roomId)
+      return std::numeric_limits<int>::max();
+    return next->first.second - day;
+  }
+
+  const Reservation* PlanningSnapshot::getReservationById(int id) const
+  {
+    auto entry = _reservationsById.find(id);
+    return entry != nullptr ? entry->second.get() : nullptr;
+  }
+
+  boost::gregorian::date_period PlanningSnapshot::getPlanningExtent() const
+  {
+    using namespace boost::gregorian;
+    if (_extentBegins.empty())
+    {
+      auto today = day_clock::local_day();
+      return date_period(today, today);
+    }
+    return DayRange(_extentBegins.first()->first, _extentEnds.last()->first).toPeriod();
+  }
+
+  PlanningSnapshot::ExtentEndpoints PlanningSnapshot::addEndpoint(const ExtentEndpoints& endpoints, Day day, int count)
+  {
+    auto entry = endpoints.find(day);
+    auto newCount = (entry != nullptr ? entry->second : 0) + count;
+    return newCount > 0 ? endpoints.insert(day, newCount) : endpoints.erase(day);
+  }
+
+} // namespace hotel
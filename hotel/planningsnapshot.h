@@ -0,0 +1,94 @@
+#ifndef HOTEL_PLANNINGSNAPSHOT_H
+#define HOTEL_PLANNINGSNAPSHOT_H
+
+#include "hotel/day.h"
+#include "hotel/persistentmap.h"
+#include "hotel/reservation.h"
+
+#include <boost/date_time.hpp>
+
+#include <memory>
+#include <utility>
+
+namespace hotel
+{
+  /**
+   * @brief The PlanningSnapshot class is an immutable version of the planning board
+   *
+   * Adding or removing a reservation returns a new snapshot in O(log n), which shares all unchanged parts with the
+   * previous one. Copying a snapshot costs O(1). Snapshots may be handed to other threads: they are never modified and
+   * they own copies of their reservations, so they stay valid and consistent no matter what happens to the planning
+   * board they were taken from.
+   *
+   * @see PlanningBoard::snapshot
+   */
+  class PlanningSnapshot
+  {
+  public:
+    PlanningSnapshot() = default;
+
+    /**
+     * @brief withReservation returns a snapshot which additionally contains a copy of the given reservation
+     * @throw std::logic_error if the reservation is invalid, overlaps another reservation or its id is already used
+     */
+    PlanningSnapshot withReservation(const Reservation& reservation) const;
+    /**
+     * @brief withoutReservation returns a snapshot without the given reservation
+     *
+     * The reservation is identified by its id and the room and begin date of its first atom, so it does not have to be
+     * equal to the copy stored in this snapshot. It must be part of the snapshot though.
+     */
+    PlanningSnapshot withoutReservation(const Reservation& reservation) const;
+    //! Returns a snapshot without the reservation with the given id, or the same snapshot if there is none
+    PlanningSnapshot withoutReservation(int reservationId) const;
+
+    std::size_t size() const { return _reservationsById.size() + _unpersistedCount; }
+    bool empty() const { return _atoms.empty(); }
+
+    bool canAddReservation(const Reservation& reservation) const;
+    bool isFree(int roomId, boost::gregorian::date_period period) const;
+    bool isFree(int roomId, DayRange range) const;
+    //! Same as PlanningBoard::getAvailableDaysFrom
+    int getAvailableDaysFrom(int roomId, Day day) const;
+
+    //! Returns the reservation with the given id, or nullptr. The reservation lives as long as the snapshot.
+    const Reservation* getReservationById(int id) const;
+    //! Same as PlanningBoard::getPlanningExtent
+    boost::gregorian::date_period getPlanningExtent() const;
+
+    //! Calls func once for every reservation, ordered by the room and begin date of their first atom
+    template <class Func> void forEachReservation(Func&& func) const;
+
+  private:
+    struct AtomEntry
+    {
+      const ReservationAtom* atom;
+      std::shared_ptr<const Reservation> reservation;
+    };
+    // Atoms in the same room never overlap, so they are uniquely identified by their room and begin date
+    typedef std::pair<int, Day> AtomKey;
+    typedef PersistentMap<AtomKey, AtomEntry> Atoms;
+    typedef PersistentMap<Day, int> ExtentEndpoints;
+
+    static ExtentEndpoints addEndpoint(const ExtentEndpoints& endpoints, Day day, int count);
+
+    Atoms _atoms;
+    PersistentMap<int, std::shared_ptr<const Reservation>> _reservationsById;
+    // Reservations with id 0 are not in _reservationsById
+    std::size_t _unpersistedCount = 0;
+    ExtentEndpoints _extentBegins;
+    ExtentEndpoints _extentEnds;
+  };
+
+  template <class Func> void PlanningSnapshot::forEachReservation(Func&& func) const
+  {
+    _atoms.forEach([&func](const Atoms::value_type& entry) {
+      auto& reservation = *entry.second.reservation;
+      if (entry.second.atom == &reservation.atoms().front())
+        func(&reservation);
+    });
+  }
+
+} // namespace hotel
+
+#endif // HOTEL_PLANNINGSNAPSHOT_H
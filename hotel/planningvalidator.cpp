@@ -0,0 +1,145 @@
+#include "hotel/planningvalidator.h"
+
+#include "hotel/hotelcollection.h"
+
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <tuple>
+#include <unordered_map>
+
+namespace hotel
+{
+  namespace
+  {
+    std::string formatRange(DayRange range)
+    {
+      return boost::gregorian::to_iso_extended_string(range.begin().toDate()) + " to " +
+             boost::gregorian::to_iso_extended_string(range.end().toDate());
+    }
+
+    //! Checks the atoms of a single room, which are sorted by their first day
+    void sweepRoom(const AtomRecord* begin, const AtomRecord* end, bool roomExists, std::vector<PlanningIssue>& issues)
+    {
+      // The atoms which have started, but not yet ended
+      std::vector<const AtomRecord*> active;
+      for (auto atom = begin; atom != end; ++atom)
+      {
+        if (!roomExists)
+          issues.push_back(PlanningIssue{PlanningIssue::DanglingRoom, *atom, AtomRecord()});
+        if (atom->dayRange.isEmpty())
+          continue;
+
+        auto first = atom->dayRange.begin();
+        active.erase(std::remove_if(active.begin(), active.end(),
+                                    [first](const AtomRecord* other) { return other->dayRange.end() <= first; }),
+                     active.end());
+        for (auto other : active)
+          if (other->reservationId != atom->reservationId)
+            issues.push_back(PlanningIssue{PlanningIssue::Overlap, *atom, *other});
+        active.push_back(atom);
+      }
+    }
+  } // namespace
+
+  std::string PlanningIssue::toString() const
+  {
+    std::ostringstream result;
+    switch (kind)
+    {
+    case Overlap:
+      result << "reservation " << atom.reservationId << " (atom " << atom.atomId << ", " << formatRange(atom.dayRange)
+             << ") overlaps reservation " << other.reservationId << " (atom " << other.atomId << ", "
+             << formatRange(other.dayRange) << ") in room " << atom.roomId;
+      break;
+    case InvalidContinuation:
+      result << "reservation " << atom.reservationId << ": atom " << atom.atomId << " (room " << atom.roomId << ", "
+             << formatRange(atom.dayRange) << ") does not continue atom " << other.atomId << " (room " << other.roomId
+             << ", " << formatRange(other.dayRange) << ")";
+      break;
+    case EmptyRange:
+      result << "reservation " << atom.reservationId << ": atom " << atom.atomId << " (room " << atom.roomId << ", "
+             << formatRange(atom.dayRange) << ") does not span a single night";
+      break;
+    case DanglingRoom:
+      result << "reservation " << atom.reservationId << ": atom " << atom.atomId << " (" << formatRange(atom.dayRange)
+             << ") refers to room " << atom.roomId << ", which does not exist";
+      break;
+    }
+    return result.str();
+  }
+
+  PlanningValidator::PlanningValidator(const HotelCollection& hotels)
+  {
+    for (auto& hotel : hotels.hotels())
+      for (auto& room : hotel->rooms())
+        _roomIds.insert(room->id());
+  }
+
+  std::vector<PlanningIssue> PlanningValidator::validate(std::vector<AtomRecord> atoms, ThreadPool& pool) const
+  {
+    std::vector<PlanningIssue> issues;
+
+    // Within a reservation, every atom has to start on the day the atom before it ends
+    std::sort(atoms.begin(), atoms.end(), [](const AtomRecord& a, const AtomRecord& b) {
+      return std::make_tuple(a.reservationId, a.dayRange.begin(), a.atomId) <
+             std::make_tuple(b.reservationId, b.dayRange.begin(), b.atomId);
+    });
+    for (std::size_t i = 0; i < atoms.size(); ++i)
+    {
+      if (atoms[i].dayRange.isEmpty())
+        issues.push_back(PlanningIssue{PlanningIssue::EmptyRange, atoms[i], AtomRecord()});
+      if (i > 0 && atoms[i - 1].reservationId == atoms[i].reservationId &&
+          atoms[i - 1].dayRange.end() != atoms[i].dayRange.begin())
+        issues.push_back(PlanningIssue{PlanningIssue::InvalidContinuation, atoms[i], atoms[i - 1]});
+    }
+
+    // Group the atoms by room (counting sort), so that the rooms can be sorted and checked independently
+    std::unordered_map<int, std::size_t> roomSlots;
+    std::vector<std::size_t> offsets;
+    for (auto& atom : atoms)
+    {
+      auto slot = roomSlots.emplace(atom.roomId, offsets.size());
+      if (slot.second)
+        offsets.push_back(0);
+      ++offsets[slot.first->second];
+    }
+    offsets.insert(offsets.begin(), 0);
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    std::vector<AtomRecord> byRoom(atoms.size());
+    auto next = offsets;
+    for (auto& atom : atoms)
+      byRoom[next[roomSlots[atom.roomId]]++] = atom;
+
+    std::vector<std::vector<PlanningIssue>> roomIssues(roomSlots.size());
+    pool.parallelFor(roomSlots.size(), [&](std::size_t slot) {
+      auto begin = byRoom.data() + offsets[slot];
+      auto end = byRoom.data() + offsets[slot + 1];
+      std::sort(begin, end, [](const AtomRecord& a, const AtomRecord& b) {
+        return std::make_tuple(a.dayRange.begin(), a.reservationId, a.atomId) <
+               std::make_tuple(b.dayRange.begin(), b.reservationId, b.atomId);
+      });
+      sweepRoom(begin, end, _roomIds.count(begin->roomId) != 0, roomIssues[slot]);
+    });
+    for (auto& room : roomIssues)
+      issues.insert(issues.end(), room.begin(), room.end());
+
+    std::sort(issues.begin(), issues.end(), [](const PlanningIssue& a, const PlanningIssue& b) {
+      return std::make_tuple(a.kind, a.atom.reservationId, a.atom.atomId, a.other.reservationId, a.other.atomId) <
+             std::make_tuple(b.kind, b.atom.reservationId, b.atom.atomId, b.other.reservationId, b.other.atomId);
+    });
+    return issues;
+  }
+
+  std::vector<PlanningIssue> PlanningValidator::validate(const std::vector<Reservation>& reservations,
+                                                         ThreadPool& pool) const
+  {
+    std::vector<AtomRecord> atoms;
+    for (auto& reservation : reservations)
+      for (auto& atom : reservation.atoms())
+        atoms.push_back(AtomRecord{reservation.id(), atom.id(), atom.roomId(), atom.dayRange()});
+    return validate(std::move(atoms), pool);
+  }
+
+} // namespace hotel
@@ -0,0 +1,84 @@
+#ifndef HOTEL_PLANNINGVALIDATOR_H
+#define HOTEL_PLANNINGVALIDATOR_H
+
+#include "hotel/day.h"
+#include "hotel/reservation.h"
+#include "hotel/threadpool.h"
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace hotel
+{
+  class HotelCollection;
+
+  /**
+   * @brief The AtomRecord struct is a reservation atom as it is stored, detached from its reservation
+   *
+   * Unlike ReservationAtom, records may describe data which violates the invariants of Reservation, e.g. atoms which do
+   * not continue each other.
+   */
+  struct AtomRecord
+  {
+    int reservationId = 0;
+    int atomId = 0;
+    int roomId = 0;
+    DayRange dayRange;
+  };
+
+  /**
+   * @brief The PlanningIssue struct describes a single inconsistency found by PlanningValidator
+   */
+  struct PlanningIssue
+  {
+    enum Kind
+    {
+      //! The atom overlaps the other atom, which is of a different reservation in the same room
+      Overlap,
+      //! The atom does not start on the last day of the other atom, the atom before it in the same reservation
+      InvalidContinuation,
+      //! The atom does not span a single night
+      EmptyRange,
+      //! The room of the atom does not exist
+      DanglingRoom
+    };
+
+    Kind kind;
+    AtomRecord atom;
+    //! The atom the issue is with, only set for Overlap and InvalidContinuation
+    AtomRecord other;
+
+    std::string toString() const;
+  };
+
+  /**
+   * @brief The PlanningValidator class checks a whole planning for inconsistencies
+   *
+   * The planning board refuses to load inconsistent data, but nothing prevents such data from ending up in the
+   * database, e.g. when multiple clients write to it at the same time. The validator finds all inconsistencies at once.
+   *
+   * The atoms are grouped by room and sorted by their first day, and every room is then checked in a single sweep on
+   * the thread pool. The whole check takes O(n log n) time for n atoms, plus the number of overlapping pairs.
+   */
+  class PlanningValidator
+  {
+  public:
+    explicit PlanningValidator(const HotelCollection& hotels);
+
+    /**
+     * @brief validate returns all issues of the given atoms
+     *
+     * Every overlapping pair of atoms is reported once. The issues are sorted by kind, reservation id and atom id.
+     */
+    std::vector<PlanningIssue> validate(std::vector<AtomRecord> atoms, ThreadPool& pool = ThreadPool::shared()) const;
+    std::vector<PlanningIssue> validate(const std::vector<Reservation>& reservations,
+                                        ThreadPool& pool = ThreadPool::shared()) const;
+
+  private:
+    std::unordered_set<int> _roomIds;
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_PLANNINGVALIDATOR_H
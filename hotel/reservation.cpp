@@ -1,5 +1,7 @@
 #include "hotel/reservation.h"
 
+#include <algorithm>
+
 namespace hotel
 {
 
@@ -10,9 +12,14 @@ namespace hotel
   }
 
   hotel::Reservation::Reservation(const std::string& description, int roomId, boost::gregorian::date_period dateRange)
+      : Reservation(description, roomId, DayRange::fromPeriod(dateRange))
+  {
+  }
+
+  hotel::Reservation::Reservation(const std::string& description, int roomId, DayRange dayRange)
       : _status(Unknown), _description(description), _reservationOwnerPersonId(), _adults(0), _children(0), _atoms()
   {
-    _atoms.push_back(ReservationAtom(roomId, dateRange));
+    _atoms.push_back(ReservationAtom(roomId, dayRange));
   }
 
   void Reservation::setStatus(Reservation::ReservationStatus status) { _status = status; }
@@ -25,26 +32,39 @@ namespace hotel
     if (dateRange.is_null())
       throw std::logic_error("Cannot add atom because its date range is invalid");
 
-    if (_atoms.empty() || lastAtom()->dateRange().end() == dateRange.begin())
+    addAtom(room, DayRange::fromPeriod(dateRange));
+  }
+
+  void Reservation::addAtom(int room, DayRange dayRange)
+  {
+    if (dayRange.isEmpty())
+      throw std::logic_error("Cannot add atom because its date range is invalid");
+
+    if (_atoms.empty() || lastAtom()->dayRange().end() == dayRange.begin())
     {
-      _atoms.push_back(ReservationAtom(room, dateRange));
+      _atoms.push_back(ReservationAtom(room, dayRange));
     }
     else
       throw std::logic_error("Cannot add atom because the date range is not contiguous to the previous atom");
   }
 
-  void Reservation::addAtom(const ReservationAtom& atom) { addAtom(atom.roomId(), atom.dateRange()); }
+  void Reservation::addAtom(const ReservationAtom& atom) { addAtom(atom.roomId(), atom.dayRange()); }
 
   void Reservation::addContinuation(int room, boost::gregorian::date date)
+  {
+    addContinuation(room, Day::fromDate(date));
+  }
+
+  void Reservation::addContinuation(int room, Day day)
   {
     if (_atoms.empty())
       throw std::logic_error("Cannot add continuation, because reservation has no atom yet");
 
-    if (lastAtom()->dateRange().end() >= date)
+    if (lastAtom()->dayRange().end() >= day)
       throw std::logic_error(
           "Cannot create reservation continuation... The given date preceeds the end date of the last atom");
 
-    auto atom = ReservationAtom(room, boost::gregorian::date_period(lastAtom()->dateRange().end(), date));
+    auto atom = ReservationAtom(room, DayRange(lastAtom()->dayRange().end(), day));
     _atoms.push_back(atom);
   }
 
@@ -57,8 +77,10 @@ namespace hotel
     {
       if (_atoms[i - 1].roomId() == _atoms[i].roomId())
       {
-        auto joinedRange = _atoms[i - 1].dateRange().span(_atoms[i].dateRange());
-        _atoms[i - 1].setDateRange(joinedRange);
+        auto previous = _atoms[i - 1].dayRange();
+        auto current = _atoms[i].dayRange();
+        _atoms[i - 1].setDayRange(
+            DayRange(std::min(previous.begin(), current.begin()), std::max(previous.end(), current.end())));
         _atoms.erase(_atoms.begin() + i);
         i -= 1; // Revisit the same item again, as it might need to be joined again
       }
@@ -79,8 +101,8 @@ namespace hotel
   int Reservation::numberOfChildren() const { return _children; }
   std::optional<int> Reservation::reservationOwnerPersonId() const { return _reservationOwnerPersonId; }
 
-  const std::vector<ReservationAtom>& Reservation::atoms() const { return _atoms; }
-  std::vector<ReservationAtom>& Reservation::atoms() { return _atoms; }
+  const Reservation::Atoms& Reservation::atoms() const { return _atoms; }
+  Reservation::Atoms& Reservation::atoms() { return _atoms; }
 
   const ReservationAtom* Reservation::atomAtIndex(int i) const
   {
@@ -96,7 +118,14 @@ namespace hotel
     using namespace boost::gregorian;
     if (!isValid())
       return date_period(date(), date());
-    return date_period(_atoms.front().dateRange().begin(), _atoms.back().dateRange().end());
+    return dayRange().toPeriod();
+  }
+
+  DayRange Reservation::dayRange() const
+  {
+    if (!isValid())
+      return DayRange();
+    return DayRange(_atoms.front().dayRange().begin(), _atoms.back().dayRange().end());
   }
 
   bool Reservation::intersectsWith(const Reservation& other) const
@@ -114,15 +143,15 @@ namespace hotel
     if (_atoms.empty())
       return false;
 
-    if (_atoms[0].dateRange().is_null())
+    if (_atoms[0].dayRange().isEmpty())
       return false;
 
     // Check that all of the atoms are contiguous and have valid date ranges
     for (size_t i = 1; i < _atoms.size(); ++i)
     {
-      if (_atoms[i].dateRange().is_null())
+      if (_atoms[i].dayRange().isEmpty())
         return false;
-      if (_atoms[i - 1].dateRange().end() != _atoms[i].dateRange().begin())
+      if (_atoms[i - 1].dayRange().end() != _atoms[i].dayRange().begin())
         return false;
     }
 
@@ -134,7 +163,7 @@ namespace hotel
     if (_atoms.empty())
       return 0;
 
-    return (lastAtom()->dateRange().end() - firstAtom()->dateRange().begin()).days();
+    return lastAtom()->dayRange().end() - firstAtom()->dayRange().begin();
   }
 
   bool operator==(const Reservation& a, const Reservation& b)
@@ -147,18 +176,20 @@ namespace hotel
   bool operator!=(const Reservation& a, const Reservation& b) { return !(a == b); }
 
   ReservationAtom::ReservationAtom(const int room, boost::gregorian::date_period dateRange)
-      : _roomId(room), _dateRange(dateRange)
+      : _roomId(room), _dayRange(DayRange::fromPeriod(dateRange))
   {
   }
 
+  ReservationAtom::ReservationAtom(const int room, DayRange dayRange) : _roomId(room), _dayRange(dayRange) {}
+
   bool ReservationAtom::intersectsWith(const ReservationAtom& other) const
   {
-    return roomId() == other.roomId() && dateRange().intersects(other.dateRange());
+    return roomId() == other.roomId() && dayRange().intersects(other.dayRange());
   }
 
   bool operator==(const ReservationAtom& a, const ReservationAtom& b)
   {
-    return a.roomId() == b.roomId() && a.dateRange() == b.dateRange();
+    return a.roomId() == b.roomId() && a.dayRange() == b.dayRange();
   }
 
   bool operator!=(const ReservationAtom& a, const ReservationAtom& b) { return !(a == b); }
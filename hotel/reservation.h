@@ -1,8 +1,10 @@
 #ifndef HOTEL_RESERVATION_H
 #define HOTEL_RESERVATION_H
 
+#include "hotel/day.h"
 #include "hotel/persistentobject.h"
 #include "hotel/reservation.h"
+#include "hotel/smallvector.h"
 
 #include <boost/date_time.hpp>
 
@@ -14,7 +16,34 @@
 namespace hotel
 {
 
-  class ReservationAtom;
+  /**
+   * @brief The ReservationAtom class represents one single reserved room over a given date period.
+   */
+  class ReservationAtom : public PersistentObject
+  {
+  public:
+    ReservationAtom(const int room, boost::gregorian::date_period dateRange);
+    ReservationAtom(const int room, DayRange dayRange);
+    ReservationAtom(const ReservationAtom& that) = default;
+
+    int roomId() const { return _roomId; }
+    boost::gregorian::date_period dateRange() const { return _dayRange.toPeriod(); }
+    DayRange dayRange() const { return _dayRange; }
+
+    void setDateRange(boost::gregorian::date_period dateRange) { _dayRange = DayRange::fromPeriod(dateRange); }
+    void setDayRange(DayRange dayRange) { _dayRange = dayRange; }
+    void setRoomId(int id) { _roomId = id; }
+
+    //! Returns true if two items overlap
+    bool intersectsWith(const ReservationAtom& other) const;
+
+  private:
+    int _roomId;
+    DayRange _dayRange;
+  };
+
+  bool operator==(const ReservationAtom& a, const ReservationAtom& b);
+  bool operator!=(const ReservationAtom& a, const ReservationAtom& b);
 
   /**
    * @brief The Reservation class represents a single reservation over a given date period
@@ -44,8 +73,12 @@ namespace hotel
       Archived
     };
 
+    //! Nearly all reservations have one or two atoms, those are stored inline
+    typedef SmallVector<ReservationAtom, 2> Atoms;
+
     Reservation(const std::string& description);
     Reservation(const std::string& description, int roomId, boost::gregorian::date_period dateRange);
+    Reservation(const std::string& description, int roomId, DayRange dayRange);
     Reservation(const Reservation& that) = default;
     Reservation(Reservation&& that) = default;
     Reservation& operator=(const Reservation& that) = default;
@@ -58,8 +91,10 @@ namespace hotel
     void setReservationOwnerPerson(std::optional<int> personId);
 
     void addAtom(int room, boost::gregorian::date_period dateRange);
+    void addAtom(int room, DayRange dayRange);
     void addAtom(const ReservationAtom& atom);
     void addContinuation(int room, boost::gregorian::date date);
+    void addContinuation(int room, Day day);
     void joinAdjacentAtoms(); // Joins adjacent atoms on the same room
     void removeLastAtom();
     void removeAllAtoms();
@@ -70,13 +105,15 @@ namespace hotel
     int numberOfChildren() const;
     std::optional<int> reservationOwnerPersonId() const;
 
-    const std::vector<ReservationAtom>& atoms() const;
-    std::vector<ReservationAtom>& atoms();
+    const Atoms& atoms() const;
+    Atoms& atoms();
     const ReservationAtom* atomAtIndex(int i) const;
     const ReservationAtom* firstAtom() const;
     const ReservationAtom* lastAtom() const;
 
     boost::gregorian::date_period dateRange() const;
+    //! Returns the range from the begin of the first to the end of the last atom, or an empty range if invalid
+    DayRange dayRange() const;
     bool intersectsWith(const Reservation& other) const;
 
     //! @brief Returns true if the reservation contains at least one atom, and all of the periods are continuous
@@ -91,38 +128,12 @@ namespace hotel
 
     int _adults;
     int _children;
-    std::vector<ReservationAtom> _atoms;
+    Atoms _atoms;
   };
 
   bool operator==(const Reservation& a, const Reservation& b);
   bool operator!=(const Reservation& a, const Reservation& b);
 
-  /**
-   * @brief The ReservationAtom class represents one single reserved room over a given date period.
-   */
-  class ReservationAtom : public PersistentObject
-  {
-  public:
-    ReservationAtom(const int room, boost::gregorian::date_period dateRange);
-    ReservationAtom(const ReservationAtom& that) = default;
-
-    int roomId() const { return _roomId; }
-    boost::gregorian::date_period dateRange() const { return _dateRange; }
-
-    void setDateRange(boost::gregorian::date_period dateRange) { _dateRange = dateRange; }
-    void setRoomId(int id) { _roomId = id; }
-
-    //! Returns true if two items overlap
-    bool intersectsWith(const ReservationAtom& other) const;
-
-  private:
-    int _roomId;
-    boost::gregorian::date_period _dateRange;
-  };
-
-  bool operator==(const ReservationAtom& a, const ReservationAtom& b);
-  bool operator!=(const ReservationAtom& a, const ReservationAtom& b);
-
 } // namespace hotel
 
 #endif // HOTEL_RESERVATION_H
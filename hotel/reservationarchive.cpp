@@ -0,0 +1,215 @@
+#include "hotel/reservationarchive.h"
+
+#include <algorithm>
+#include <tuple>
+#include <unordered_set>
+
+namespace hotel
+{
+  void ReservationArchive::add(const std::vector<Reservation>& reservations)
+  {
+    std::vector<int> ids;
+    ids.reserve(reservations.size());
+    for (auto& reservation : reservations)
+      ids.push_back(reservation.id());
+    remove(ids);
+
+    auto oldSize = _entries.size();
+    for (auto& reservation : reservations)
+    {
+      if (reservation.atoms().empty())
+        continue;
+
+      Entry entry;
+      entry.begin = reservation.dayRange().begin();
+      entry.end = reservation.dayRange().end();
+      entry.id = reservation.id();
+      entry.revision = reservation.revision();
+      entry.firstAtom = static_cast<uint32_t>(_atoms.size());
+      entry.descriptionOffset = static_cast<uint32_t>(_descriptions.size());
+      entry.descriptionLength = static_cast<uint32_t>(reservation.description().size());
+      entry.atomCount = static_cast<uint16_t>(reservation.atoms().size());
+      entry.adults = static_cast<uint16_t>(reservation.numberOfAdults());
+      entry.children = static_cast<uint16_t>(reservation.numberOfChildren());
+      entry.status = static_cast<uint8_t>(reservation.status());
+      for (auto& atom : reservation.atoms())
+        _atoms.push_back(Atom{atom.id(), atom.roomId(), atom.dayRange().begin(), atom.dayRange().end()});
+      _descriptions += reservation.description();
+      _maxLength = std::max(_maxLength, entry.end - entry.begin);
+      _beginsById[entry.id] = entry.begin;
+      _entries.push_back(entry);
+    }
+
+    // New entries are usually few compared to the archive, so only they have to be sorted
+    auto compare = [](const Entry& a, const Entry& b) {
+      return std::make_tuple(a.begin, a.id) < std::make_tuple(b.begin, b.id);
+    };
+    auto middle = _entries.begin() + static_cast<std::ptrdiff_t>(oldSize);
+    std::sort(middle, _entries.end(), compare);
+    std::inplace_merge(_entries.begin(), middle, _entries.end(), compare);
+  }
+
+  void ReservationArchive::remove(const std::vector<int>& reservationIds)
+  {
+    if (reservationIds.empty() || _entries.empty())
+      return;
+
+    // Only go through the entries if one of the reservations is actually archived
+    std::unordered_set<int> ids;
+    for (auto id : reservationIds)
+      if (_beginsById.erase(id) != 0)
+        ids.insert(id);
+    if (ids.empty())
+      return;
+
+    auto removed = std::remove_if(_entries.begin(), _entries.end(), [&](const Entry& entry) {
+      if (ids.count(entry.id) == 0)
+        return false;
+      _unusedAtoms += entry.atomCount;
+      _unusedDescriptionBytes += entry.descriptionLength;
+      return true;
+    });
+    _entries.erase(removed, _entries.end());
+    compactIfNeeded();
+  }
+
+  void ReservationArchive::clear()
+  {
+    _entries.clear();
+    _beginsById.clear();
+    _atoms.clear();
+    _descriptions.clear();
+    _unusedAtoms = 0;
+    _unusedDescriptionBytes = 0;
+    _maxLength = 0;
+  }
+
+  std::size_t ReservationArchive::size() const { return _entries.size(); }
+
+  bool ReservationArchive::contains(int reservationId) const { return _beginsById.count(reservationId) != 0; }
+
+  std::optional<Reservation> ReservationArchive::getReservation(int reservationId) const
+  {
+    auto it = findEntry(reservationId);
+    return it != _entries.end() ? std::optional<Reservation>(materialize(*it)) : std::nullopt;
+  }
+
+  std::vector<Reservation> ReservationArchive::getReservationsInRange(DayRange range) const
+  {
+    std::vector<Reservation> result;
+    if (range.isEmpty())
+      return result;
+
+    // No reservation beginning before range.begin() - _maxLength can reach into the range
+    auto first = std::lower_bound(_entries.begin(), _entries.end(), range.begin() - _maxLength,
+                                  [](const Entry& entry, Day day) { return entry.begin < day; });
+    auto last = std::lower_bound(first, _entries.end(), range.end(),
+                                 [](const Entry& entry, Day day) { return entry.begin < day; });
+    for (auto it = first; it != last; ++it)
+      if (it->end > range.begin())
+        result.push_back(materialize(*it));
+    return result;
+  }
+
+  void ReservationArchive::markLoaded(DayRange range)
+  {
+    if (range.isEmpty())
+      return;
+
+    auto begin = range.begin();
+    auto end = range.end();
+
+    // Merge with all ranges which overlap or touch the new one
+    auto it = _loaded.upper_bound(begin);
+    if (it != _loaded.begin() && std::prev(it)->second >= begin)
+      --it;
+    while (it != _loaded.end() && it->first <= end)
+    {
+      begin = std::min(begin, it->first);
+      end = std::max(end, it->second);
+      it = _loaded.erase(it);
+    }
+    _loaded.emplace(begin, end);
+  }
+
+  std::vector<DayRange> ReservationArchive::missingRanges(DayRange range) const
+  {
+    std::vector<DayRange> result;
+    if (range.isEmpty())
+      return result;
+
+    auto day = range.begin();
+    auto it = _loaded.upper_bound(day);
+    if (it != _loaded.begin())
+      --it;
+    for (; it != _loaded.end() && it->first < range.end(); ++it)
+    {
+      if (it->second <= day)
+        continue;
+      if (it->first > day)
+        result.push_back(DayRange(day, it->first));
+      day = it->second;
+    }
+    if (day < range.end())
+      result.push_back(DayRange(day, range.end()));
+    return result;
+  }
+
+  std::vector<ReservationArchive::Entry>::const_iterator ReservationArchive::findEntry(int reservationId) const
+  {
+    auto begin = _beginsById.find(reservationId);
+    if (begin == _beginsById.end())
+      return _entries.end();
+
+    auto key = std::make_tuple(begin->second, reservationId);
+    auto it = std::lower_bound(_entries.begin(), _entries.end(), key, [](const Entry& entry, const auto& key) {
+      return std::make_tuple(entry.begin, entry.id) < key;
+    });
+    return it != _entries.end() && it->id == reservationId ? it : _entries.end();
+  }
+
+  Reservation ReservationArchive::materialize(const Entry& entry) const
+  {
+    auto atom = _atoms.begin() + entry.firstAtom;
+    Reservation reservation(_descriptions.substr(entry.descriptionOffset, entry.descriptionLength), atom->roomId,
+                            DayRange(atom->begin, atom->end));
+    for (++atom; atom != _atoms.begin() + entry.firstAtom + entry.atomCount; ++atom)
+      reservation.addContinuation(atom->roomId, atom->end);
+
+    reservation.setId(entry.id);
+    reservation.setRevision(entry.revision);
+    reservation.setStatus(static_cast<Reservation::ReservationStatus>(entry.status));
+    reservation.setNumberOfAdults(entry.adults);
+    reservation.setNumberOfChildren(entry.children);
+    for (uint16_t i = 0; i < entry.atomCount; ++i)
+      reservation.atoms()[i].setId(_atoms[entry.firstAtom + i].id);
+    return reservation;
+  }
+
+  void ReservationArchive::compactIfNeeded()
+  {
+    if (_unusedAtoms <= _atoms.size() / 2 && _unusedDescriptionBytes <= _descriptions.size() / 2)
+      return;
+
+    std::vector<Atom> atoms;
+    std::string descriptions;
+    atoms.reserve(_atoms.size() - _unusedAtoms);
+    descriptions.reserve(_descriptions.size() - _unusedDescriptionBytes);
+    _maxLength = 0;
+    for (auto& entry : _entries)
+    {
+      auto firstAtom = _atoms.begin() + entry.firstAtom;
+      entry.firstAtom = static_cast<uint32_t>(atoms.size());
+      atoms.insert(atoms.end(), firstAtom, firstAtom + entry.atomCount);
+      auto descriptionOffset = static_cast<uint32_t>(descriptions.size());
+      descriptions.append(_descriptions, entry.descriptionOffset, entry.descriptionLength);
+      entry.descriptionOffset = descriptionOffset;
+      _maxLength = std::max(_maxLength, entry.end - entry.begin);
+    }
+    _atoms = std::move(atoms);
+    _descriptions = std::move(descriptions);
+    _unusedAtoms = 0;
+    _unusedDescriptionBytes = 0;
+  }
+
+} // namespace hotel
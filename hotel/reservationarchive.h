@@ -0,0 +1,94 @@
+#ifndef HOTEL_RESERVATIONARCHIVE_H
+#define HOTEL_RESERVATIONARCHIVE_H
+
+#include "hotel/day.h"
+#include "hotel/reservation.h"
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hotel
+{
+  /**
+   * @brief The ReservationArchive class holds archived reservations in a compact, read-mostly form
+   *
+   * Archived reservations are only looked at when browsing the history, so they are not kept in the PlanningBoard.
+   * Instead, every reservation is stored as a small fixed size entry, its atoms are stored in one shared array, and all
+   * descriptions share a single buffer. The entries are sorted by their first day, so that the reservations of a range
+   * of days are found with a binary search. Reservations are only turned back into Reservation objects on request.
+   *
+   * The archive also remembers which ranges of days have been loaded from the storage, so that the history can be
+   * loaded lazily (see missingRanges).
+   */
+  class ReservationArchive
+  {
+  public:
+    //! Adds the given reservations, replacing the archived reservations with the same ids
+    void add(const std::vector<Reservation>& reservations);
+    void remove(const std::vector<int>& reservationIds);
+    //! Removes all reservations. The loaded ranges are kept, e.g. for when all data has been erased from the storage.
+    void clear();
+
+    std::size_t size() const;
+    bool contains(int reservationId) const;
+    std::optional<Reservation> getReservation(int reservationId) const;
+    //! Returns the reservations which have at least one night in the given range, sorted by their first day
+    std::vector<Reservation> getReservationsInRange(DayRange range) const;
+
+    //! Remembers that all archived reservations intersecting the range have been loaded
+    void markLoaded(DayRange range);
+    //! Returns the parts of the given range which have not been loaded yet, sorted by their first day
+    std::vector<DayRange> missingRanges(DayRange range) const;
+
+  private:
+    struct Entry
+    {
+      Day begin;
+      Day end;
+      int id;
+      int revision;
+      uint32_t firstAtom;
+      uint32_t descriptionOffset;
+      uint32_t descriptionLength;
+      uint16_t atomCount;
+      uint16_t adults;
+      uint16_t children;
+      uint8_t status;
+    };
+
+    struct Atom
+    {
+      int id;
+      int roomId;
+      Day begin;
+      Day end;
+    };
+
+    //! Returns the entry with the given id, or _entries.end()
+    std::vector<Entry>::const_iterator findEntry(int reservationId) const;
+    Reservation materialize(const Entry& entry) const;
+    //! Drops the atoms and descriptions of removed entries once they take up more space than the live ones
+    void compactIfNeeded();
+
+    // Sorted by (begin, id)
+    std::vector<Entry> _entries;
+    //! The first day of every entry by id, which locates the entry with a binary search
+    std::unordered_map<int, Day> _beginsById;
+    std::vector<Atom> _atoms;
+    std::string _descriptions;
+    std::size_t _unusedAtoms = 0;
+    std::size_t _unusedDescriptionBytes = 0;
+    //! The length of the longest reservation, which bounds how far back a reservation intersecting a range can begin
+    int _maxLength = 0;
+
+    //! The disjoint loaded ranges, stored as begin -> end
+    std::map<Day, Day> _loaded;
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_RESERVATIONARCHIVE_H
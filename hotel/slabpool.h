@@ -0,0 +1,151 @@
+#ifndef HOTEL_SLABPOOL_H
+#define HOTEL_SLABPOOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace hotel
+{
+  /**
+   * @brief The SlabPool class owns objects of type T, which are stored in large contiguous slabs
+   *
+   * Slabs grow geometrically up to MaxSlabSize objects, so storing a million objects takes a few dozen allocations
+   * instead of a million. Objects never move: pointers stay valid until the object is destroyed. Destroyed slots are
+   * reused by later objects.
+   */
+  template <class T> class SlabPool
+  {
+  public:
+    SlabPool() = default;
+    SlabPool(const SlabPool& that) = delete;
+    SlabPool(SlabPool&& that) noexcept { swap(that); }
+    ~SlabPool() { clear(); }
+
+    SlabPool& operator=(const SlabPool& that) = delete;
+    SlabPool& operator=(SlabPool&& that) noexcept
+    {
+      if (this != &that)
+      {
+        clear();
+        swap(that);
+      }
+      return *this;
+    }
+
+    //! Constructs a new object inside of the pool
+    template <class... Args> T* create(Args&&... args)
+    {
+      auto slot = allocateSlot();
+      auto object = new (&slot->storage) T(std::forward<Args>(args)...);
+      slot->live = true;
+      ++_size;
+      return object;
+    }
+
+    //! Destroys an object which has been created by this pool
+    void destroy(T* object)
+    {
+      auto slot = reinterpret_cast<Slot*>(object);
+      object->~T();
+      slot->live = false;
+      _freeSlots.push_back(slot);
+      --_size;
+    }
+
+    //! Returns true if the given pointer points to a live object of this pool
+    bool contains(const T* object) const
+    {
+      // std::less gives a total order, even for pointers into different slabs
+      auto address = reinterpret_cast<const char*>(object);
+      std::less<const char*> less;
+      for (auto& slab : _slabs)
+      {
+        auto first = reinterpret_cast<const char*>(slab.slots.get());
+        auto last = reinterpret_cast<const char*>(slab.slots.get() + slab.used);
+        if (!less(address, first) && less(address, last))
+        {
+          auto offset = static_cast<std::size_t>(address - first);
+          return offset % sizeof(Slot) == 0 && slab.slots[offset / sizeof(Slot)].live;
+        }
+      }
+      return false;
+    }
+
+    std::size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    //! Calls func for every live object, in an unspecified order
+    template <class Func> void forEach(Func&& func) const
+    {
+      for (auto& slab : _slabs)
+        for (std::size_t i = 0; i < slab.used; ++i)
+          if (slab.slots[i].live)
+            func(reinterpret_cast<T*>(&slab.slots[i].storage));
+    }
+
+    //! Destroys all objects and releases all memory
+    void clear()
+    {
+      forEach([](T* object) { object->~T(); });
+      _slabs.clear();
+      _freeSlots.clear();
+      _size = 0;
+    }
+
+  private:
+    static constexpr std::size_t MinSlabSize = 64;
+    static constexpr std::size_t MaxSlabSize = 65536;
+
+    // The storage is the first member, so that a pointer to the object is also a pointer to its slot
+    struct Slot
+    {
+      std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+      bool live;
+    };
+
+    struct Slab
+    {
+      std::unique_ptr<Slot[]> slots;
+      std::size_t capacity;
+      std::size_t used;
+    };
+
+    Slot* allocateSlot()
+    {
+      if (!_freeSlots.empty())
+      {
+        auto slot = _freeSlots.back();
+        _freeSlots.pop_back();
+        return slot;
+      }
+
+      if (_slabs.empty() || _slabs.back().used == _slabs.back().capacity)
+      {
+        auto capacity = _slabs.empty() ? MinSlabSize : std::min(2 * _slabs.back().capacity, MaxSlabSize);
+        _slabs.push_back(Slab{std::unique_ptr<Slot[]>(new Slot[capacity]()), capacity, 0});
+      }
+      auto& slab = _slabs.back();
+      return &slab.slots[slab.used++];
+    }
+
+    void swap(SlabPool& that)
+    {
+      std::swap(_slabs, that._slabs);
+      std::swap(_freeSlots, that._freeSlots);
+      std::swap(_size, that._size);
+    }
+
+    std::vector<Slab> _slabs;
+    std::vector<Slot*> _freeSlots;
+    std::size_t _size = 0;
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_SLABPOOL_H
@@ -0,0 +1,198 @@
+#ifndef HOTEL_SMALLVECTOR_H
+#define HOTEL_SMALLVECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace hotel
+{
+  /**
+   * @brief The SmallVector class is a vector which stores up to N elements inline, without any heap allocation
+   *
+   * Only when more than N elements are added, the elements are moved to the heap. The interface is a subset of the one
+   * of std::vector. As with std::vector, adding or removing elements invalidates iterators and pointers to elements.
+   */
+  template <class T, std::size_t N> class SmallVector
+  {
+  public:
+    typedef T value_type;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    SmallVector() : _data(inlineData()), _size(0), _capacity(N) {}
+    SmallVector(const SmallVector& that) : SmallVector() { copyFrom(that); }
+    SmallVector(SmallVector&& that) noexcept(std::is_nothrow_move_constructible<T>::value) : SmallVector()
+    {
+      moveFrom(that);
+    }
+    ~SmallVector() { release(); }
+
+    SmallVector& operator=(const SmallVector& that)
+    {
+      if (this != &that)
+      {
+        clear();
+        copyFrom(that);
+      }
+      return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& that) noexcept(std::is_nothrow_move_constructible<T>::value)
+    {
+      if (this != &that)
+      {
+        release();
+        _data = inlineData();
+        _capacity = N;
+        moveFrom(that);
+      }
+      return *this;
+    }
+
+    iterator begin() { return _data; }
+    iterator end() { return _data + _size; }
+    const_iterator begin() const { return _data; }
+    const_iterator end() const { return _data + _size; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    size_type size() const { return _size; }
+    size_type capacity() const { return _capacity; }
+    bool empty() const { return _size == 0; }
+    //! Returns true as long as the elements are stored inline
+    bool isInline() const { return _data == inlineData(); }
+
+    T* data() { return _data; }
+    const T* data() const { return _data; }
+    T& operator[](size_type i) { return _data[i]; }
+    const T& operator[](size_type i) const { return _data[i]; }
+    T& front() { return _data[0]; }
+    const T& front() const { return _data[0]; }
+    T& back() { return _data[_size - 1]; }
+    const T& back() const { return _data[_size - 1]; }
+
+    void reserve(size_type capacity)
+    {
+      if (capacity <= _capacity)
+        return;
+
+      auto newData = static_cast<T*>(::operator new(capacity * sizeof(T)));
+      std::uninitialized_move(begin(), end(), newData);
+      std::destroy(begin(), end());
+      if (!isInline())
+        ::operator delete(_data);
+      _data = newData;
+      _capacity = capacity;
+    }
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    template <class... Args> T& emplace_back(Args&&... args)
+    {
+      if (_size == _capacity)
+      {
+        // The arguments might refer to an element of this vector, so the new element is created before reallocating
+        T value(std::forward<Args>(args)...);
+        reserve(2 * _capacity);
+        new (_data + _size) T(std::move(value));
+      }
+      else
+      {
+        new (_data + _size) T(std::forward<Args>(args)...);
+      }
+      return _data[_size++];
+    }
+
+    void pop_back()
+    {
+      --_size;
+      _data[_size].~T();
+    }
+
+    iterator erase(const_iterator position)
+    {
+      auto it = begin() + (position - begin());
+      std::move(it + 1, end(), it);
+      pop_back();
+      return it;
+    }
+
+    void clear()
+    {
+      std::destroy(begin(), end());
+      _size = 0;
+    }
+
+  private:
+    T* inlineData() { return reinterpret_cast<T*>(&_inline); }
+    const T* inlineData() const { return reinterpret_cast<const T*>(&_inline); }
+
+    void copyFrom(const SmallVector& that)
+    {
+      reserve(that._size);
+      std::uninitialized_copy(that.begin(), that.end(), _data);
+      _size = that._size;
+    }
+
+    // Expects this vector to be empty and inline
+    void moveFrom(SmallVector& that)
+    {
+      if (that.isInline())
+      {
+        std::uninitialized_move(that.begin(), that.end(), _data);
+        _size = that._size;
+        that.clear();
+      }
+      else
+      {
+        _data = that._data;
+        _size = that._size;
+        _capacity = that._capacity;
+        that._data = that.inlineData();
+        that._size = 0;
+        that._capacity = N;
+      }
+    }
+
+    void release()
+    {
+      clear();
+      if (!isInline())
+        ::operator delete(_data);
+    }
+
+    std::aligned_storage_t<sizeof(T) * N, alignof(T)> _inline;
+    T* _data;
+    size_type _size;
+    size_type _capacity;
+  };
+
+  template <class T, std::size_t N> bool operator==(const SmallVector<T, N>& a, const SmallVector<T, N>& b)
+  {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+  }
+
+  template <class T, std::size_t N> bool operator!=(const SmallVector<T, N>& a, const SmallVector<T, N>& b)
+  {
+    return !(a == b);
+  }
+
+} // namespace hotel
+
+#endif // HOTEL_SMALLVECTOR_H
@@ -0,0 +1,82 @@
+#include "hotel/threadpool.h"
+
+namespace hotel
+{
+  ThreadPool::ThreadPool(unsigned threadCount)
+  {
+    for (unsigned i = 0; i < threadCount; ++i)
+      _threads.emplace_back([this]() { this->threadMain(); });
+  }
+
+  ThreadPool::~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_jobsMutex);
+      _quitFlag = true;
+    }
+    _jobsAvailable.notify_all();
+    for (auto& thread : _threads)
+      thread.join();
+  }
+
+  ThreadPool& ThreadPool::shared()
+  {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+  }
+
+  void ThreadPool::spawn(std::function<void()> job)
+  {
+    {
+      std::lock_guard<std::mutex> lock(_jobsMutex);
+      _jobs.push(std::move(job));
+    }
+    _jobsAvailable.notify_one();
+  }
+
+  void ThreadPool::threadMain()
+  {
+    while (true)
+    {
+      std::function<void()> job;
+      {
+        std::unique_lock<std::mutex> lock(_jobsMutex);
+        _jobsAvailable.wait(lock, [this]() { return _quitFlag || !_jobs.empty(); });
+        if (_quitFlag)
+          return;
+        job = std::move(_jobs.front());
+        _jobs.pop();
+      }
+      job();
+    }
+  }
+
+  void ThreadPool::runChunks(Loop& loop)
+  {
+    while (true)
+    {
+      auto chunk = loop.nextChunk++;
+      if (chunk >= loop.chunkCount)
+        return;
+
+      std::exception_ptr error;
+      try
+      {
+        auto end = std::min(loop.count, (chunk + 1) * loop.chunkSize);
+        for (auto i = chunk * loop.chunkSize; i < end; ++i)
+          loop.body(i);
+      }
+      catch (...)
+      {
+        error = std::current_exception();
+      }
+
+      std::lock_guard<std::mutex> lock(loop.mutex);
+      if (error && !loop.error)
+        loop.error = error;
+      if (++loop.finishedChunks == loop.chunkCount)
+        loop.done.notify_all();
+    }
+  }
+
+} // namespace hotel
@@ -0,0 +1,114 @@
+#ifndef HOTEL_THREADPOOL_H
+#define HOTEL_THREADPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace hotel
+{
+  /**
+   * @brief The ThreadPool class runs data parallel loops on a fixed set of worker threads
+   *
+   * The pool is meant for short, CPU bound computations on the planning, such as evaluating many candidate rooms at
+   * once. The thread calling parallelFor takes part in the work, so loops also make progress if all workers are busy
+   * (e.g. when parallelFor is called from within a worker).
+   */
+  class ThreadPool
+  {
+  public:
+    //! Creates a pool with the given number of worker threads. A pool without workers runs everything inline.
+    explicit ThreadPool(unsigned threadCount);
+    ThreadPool(const ThreadPool& that) = delete;
+    ThreadPool& operator=(const ThreadPool& that) = delete;
+    ~ThreadPool();
+
+    //! Returns a pool shared by the whole application, with one worker less than there are hardware threads
+    static ThreadPool& shared();
+
+    unsigned threadCount() const { return static_cast<unsigned>(_threads.size()); }
+
+    /**
+     * @brief parallelFor calls func(i) for every i in [0, count) and returns once all calls have returned
+     *
+     * The calls are made from the worker threads and the calling thread, in an unspecified order.
+     *
+     * @throw rethrows the first exception thrown by func, after all other calls have finished
+     */
+    template <class Func> void parallelFor(std::size_t count, Func&& func);
+
+  private:
+    struct Loop;
+
+    void spawn(std::function<void()> job);
+    void threadMain();
+    //! Runs chunks of the loop until none are left
+    static void runChunks(Loop& loop);
+
+    std::vector<std::thread> _threads;
+    std::mutex _jobsMutex;
+    std::condition_variable _jobsAvailable;
+    std::queue<std::function<void()>> _jobs;
+    bool _quitFlag = false;
+  };
+
+  /**
+   * @brief The Loop struct holds the state of a single parallelFor call
+   *
+   * It is shared with the jobs of the loop, since jobs which only start after the loop has completed still access it.
+   */
+  struct ThreadPool::Loop
+  {
+    std::function<void(std::size_t)> body;
+    std::size_t count;
+    std::size_t chunkSize;
+    std::size_t chunkCount;
+    std::atomic<std::size_t> nextChunk{0};
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t finishedChunks = 0;
+    std::exception_ptr error;
+  };
+
+  template <class Func> void ThreadPool::parallelFor(std::size_t count, Func&& func)
+  {
+    if (count == 0)
+      return;
+
+    if (_threads.empty() || count == 1)
+    {
+      for (std::size_t i = 0; i < count; ++i)
+        func(i);
+      return;
+    }
+
+    // A few chunks per thread balance the load without paying for synchronization on every index
+    auto loop = std::make_shared<Loop>();
+    loop->body = [&func](std::size_t i) { func(i); };
+    loop->count = count;
+    loop->chunkSize = std::max<std::size_t>(1, count / (4 * (_threads.size() + 1)));
+    loop->chunkCount = (count + loop->chunkSize - 1) / loop->chunkSize;
+
+    auto helpers = std::min(_threads.size(), loop->chunkCount - 1);
+    for (std::size_t i = 0; i < helpers; ++i)
+      spawn([loop]() { runChunks(*loop); });
+    runChunks(*loop);
+
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->done.wait(lock, [&loop]() { return loop->finishedChunks == loop->chunkCount; });
+    if (loop->error)
+      std::rethrow_exception(loop->error);
+  }
+
+} // namespace hotel
+
+#endif // HOTEL_THREADPOOL_H
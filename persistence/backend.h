@@ -82,6 +82,8 @@ namespace persistence
     friend class persistence::UniqueDataStreamHandle;
 
     virtual void removeStream(std::shared_ptr<persistence::DataStream> stream) = 0;
+    virtual void changeStreamOptions(std::shared_ptr<persistence::DataStream> stream,
+                                     const nlohmann::json& options) = 0;
   };
 } // namespace persistence
 
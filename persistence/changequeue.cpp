@@ -39,13 +39,47 @@ namespace persistence
     if (!list.streamChanges.empty())
     {
       std::unique_lock<std::mutex> lock(_streamChangesMutex);
-      std::move(list.streamChanges.begin(), list.streamChanges.end(), std::back_inserter(_changeList.streamChanges));
+      bool hasAvailableChanges = false;
+      for (auto& change : list.streamChanges)
+      {
+        auto held = _heldChanges.find(change.streamId);
+        if (held != _heldChanges.end())
+        {
+          held->second.push_back(std::move(change.change));
+        }
+        else
+        {
+          _changeList.streamChanges.push_back(std::move(change));
+          hasAvailableChanges = true;
+        }
+      }
       lock.unlock();
-      _streamChangesAvailableSignal();
+      if (hasAvailableChanges)
+        _streamChangesAvailableSignal();
     }
   }
 
   void ChangeQueue::addStreamChange(int streamId, DataStreamChange change)
+  {
+    std::unique_lock<std::mutex> lock(_streamChangesMutex);
+    auto held = _heldChanges.find(streamId);
+    if (held != _heldChanges.end())
+    {
+      held->second.push_back(std::move(change));
+      return;
+    }
+    _changeList.streamChanges.push_back({streamId, std::move(change)});
+    lock.unlock();
+    _streamChangesAvailableSignal();
+  }
+
+  void ChangeQueue::holdStream(int streamId)
+  {
+    std::lock_guard<std::mutex> lock(_streamChangesMutex);
+    _heldChanges[streamId];
+  }
+
+  void ChangeQueue::addSnapshotChange(int streamId, DataStreamChange change)
   {
     std::unique_lock<std::mutex> lock(_streamChangesMutex);
     _changeList.streamChanges.push_back({streamId, std::move(change)});
@@ -53,6 +87,21 @@ namespace persistence
     _streamChangesAvailableSignal();
   }
 
+  void ChangeQueue::releaseStream(int streamId)
+  {
+    std::unique_lock<std::mutex> lock(_streamChangesMutex);
+    auto held = _heldChanges.find(streamId);
+    if (held == _heldChanges.end())
+      return;
+    auto changes = std::move(held->second);
+    _heldChanges.erase(held);
+    for (auto& change : changes)
+      _changeList.streamChanges.push_back({streamId, std::move(change)});
+    lock.unlock();
+    if (!changes.empty())
+      _streamChangesAvailableSignal();
+  }
+
   boost::signals2::connection ChangeQueue::connectToStreamChangesAvailableSignal(boost::signals2::slot<void()> slot)
   {
     return _streamChangesAvailableSignal.connect(slot);
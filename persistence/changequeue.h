@@ -11,6 +11,7 @@
 
 #include "boost/signals2.hpp"
 
+#include <map>
 #include <vector>
 #include <mutex>
 #include <queue>
@@ -67,6 +68,18 @@ namespace persistence
     void addChanges(ChangeList list);
     void addStreamChange(int streamId, DataStreamChange change);
 
+    /**
+     * @brief holdStream holds back all changes to the stream which are added from now on, until releaseStream is called
+     *
+     * This allows a stream to be initialized from a snapshot on another thread, while the changes which were made after
+     * the snapshot are already collected for it. The data of the snapshot is added with addSnapshotChange.
+     */
+    void holdStream(int streamId);
+    //! Adds a change to a held stream, which is applied before all of the changes which are held back
+    void addSnapshotChange(int streamId, DataStreamChange change);
+    //! Makes the changes which have been held back for the stream available, and no longer holds back its changes
+    void releaseStream(int streamId);
+
     boost::signals2::connection connectToStreamChangesAvailableSignal(boost::signals2::slot<void()> slot);
 
   private:
@@ -75,6 +88,7 @@ namespace persistence
     std::mutex _streamChangesMutex;
     std::mutex _completedTasksMutex;
     ChangeList _changeList;
+    std::map<int, std::vector<DataStreamChange>> _heldChanges;
 
     boost::signals2::signal<void()> _streamChangesAvailableSignal;
   };
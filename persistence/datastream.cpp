@@ -29,6 +29,12 @@ namespace persistence
     reset();
   }
 
+  void UniqueDataStreamHandle::changeOptions(const nlohmann::json& options)
+  {
+    if (_dataStream)
+      _backend->changeStreamOptions(_dataStream, options);
+  }
+
   void UniqueDataStreamHandle::reset()
   {
     if (_dataStream)
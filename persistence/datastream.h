@@ -20,7 +20,18 @@ namespace persistence
    */
   enum class StreamableType { NullStream, Hotel, Reservation };
 
-  struct DataStreamItemsAdded { StreamableItems newItems; };
+  /**
+   * @brief The DataStreamItemsAdded struct holds items which have been added to a stream
+   *
+   * The items cannot be modified, so that the same initial data can be sent to many streams without copying it.
+   */
+  struct DataStreamItemsAdded
+  {
+    DataStreamItemsAdded(StreamableItems items) : newItems(std::make_shared<const StreamableItems>(std::move(items))) {}
+    DataStreamItemsAdded(std::shared_ptr<const StreamableItems> items) : newItems(std::move(items)) {}
+
+    std::shared_ptr<const StreamableItems> newItems;
+  };
   struct DataStreamItemsUpdated { StreamableItems updatedItems; };
   struct DataStreamItemsRemoved { std::vector<int> removedItems; };
   struct DataStreamInitialized {};
@@ -60,6 +71,12 @@ namespace persistence
 
     const std::string& streamEndpoint() const { return _endpoint; }
     const nlohmann::json& streamOptions() const { return _options; }
+    /**
+     * @brief Replaces the options of the stream
+     * @note Once the stream has been handed to a backend, only the backend may call this method, from the thread on
+     *       which the stream is served. Use UniqueDataStreamHandle::changeOptions instead.
+     */
+    void setStreamOptions(const nlohmann::json& options) { _options = options; }
     //! Returns true if there is still an observer listening on this stream
     bool isValid() const { return _observer != nullptr; }
     //! Returns true if the initial data for the observer has already been set
@@ -79,7 +96,7 @@ namespace persistence
     static StreamableType GetStreamTypeFor();
 
   private:
-    void applyChange(const DataStreamItemsAdded& op) { _observer->addItems(op.newItems); }
+    void applyChange(const DataStreamItemsAdded& op) { _observer->addItems(*op.newItems); }
     void applyChange(const DataStreamItemsUpdated& op) { _observer->updateItems(op.updatedItems); }
     void applyChange(const DataStreamItemsRemoved& op) { _observer->removeItems(op.removedItems); }
     void applyChange([[maybe_unused]] const DataStreamInitialized& op) { _isInitialized = true; _observer->initialized(); }
@@ -117,6 +134,14 @@ namespace persistence
 
     DataStream* stream() { return _dataStream.get(); }
 
+    /**
+     * @brief Changes the options of the stream without closing it
+     *
+     * The observer is not reset. Instead, the service brings it up to date with the new options, e.g. by removing
+     * the items which no longer match and by adding the items which match now.
+     */
+    void changeOptions(const nlohmann::json& options);
+
     void reset();
 
   private:
@@ -25,6 +25,7 @@ namespace persistence
     virtual ~DataStreamObserver() {}
 
     virtual void addItems(const StreamableItems& items) = 0;
+    //! Updated items which are not known to the observer yet must be added, e.g. when they enter a window of days
     virtual void updateItems(const StreamableItems& items) = 0;
     virtual void removeItems(const std::vector<int>& ids) = 0;
     virtual void clear() = 0;
@@ -69,6 +70,8 @@ namespace persistence
         });
         if (it != _dataItems.end())
           *it = updatedItem;
+        else
+          _dataItems.push_back(updatedItem);
       }
     }
     virtual void removeItems(const std::vector<int>& ids) override
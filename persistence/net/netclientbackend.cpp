@@ -110,6 +110,17 @@ namespace persistence
       submit(obj.dump());
     }
 
+    void NetClientBackend::changeStreamOptions(std::shared_ptr<DataStream> stream, const nlohmann::json& options)
+    {
+      stream->setStreamOptions(options);
+
+      nlohmann::json obj;
+      obj["op"] = "change_stream_options";
+      obj["id"] = stream->streamId();
+      obj["options"] = options;
+      submit(obj.dump());
+    }
+
     void NetClientBackend::socketConnected(boost::system::error_code ec)
     {
       std::lock_guard<std::mutex> lock(_communicationMutex);
@@ -227,6 +238,10 @@ namespace persistence
         std::vector<int> ids = obj["items"];
         _changeQueue.addStreamChange(id, DataStreamItemsRemoved{std::move(ids)});
       }
+      else if (operation == "stream_clear")
+      {
+        _changeQueue.addStreamChange(obj["id"], DataStreamCleared{});
+      }
       else if (operation == "task_results")
       {
         int id;
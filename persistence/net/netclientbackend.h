@@ -37,6 +37,8 @@ namespace persistence
 
     protected:
       virtual void removeStream(std::shared_ptr<persistence::DataStream> stream) override;
+      virtual void changeStreamOptions(std::shared_ptr<persistence::DataStream> stream,
+                                       const nlohmann::json& options) override;
 
     private:
       void start();
@@ -1,5 +1,7 @@
 #include "persistence/op/operations.h"
 
+#include <stdexcept>
+
 namespace persistence
 {
   namespace op
@@ -16,5 +18,24 @@ namespace persistence
       }, ptr);
     }
 
+    Operations storeGroupAllocation(const hotel::GroupAllocation& allocation, const std::string& description)
+    {
+      if (!allocation.succeeded())
+        throw std::invalid_argument("cannot store failed group allocation: " + allocation.error);
+
+      Operations operations;
+      for (auto& reservation : allocation.toReservations(description))
+        operations.push_back(StoreNew{std::make_unique<hotel::Reservation>(std::move(reservation))});
+      return operations;
+    }
+
+    Operations updateReservations(std::vector<hotel::Reservation> reservations)
+    {
+      Operations operations;
+      for (auto& reservation : reservations)
+        operations.push_back(Update{std::make_unique<hotel::Reservation>(std::move(reservation))});
+      return operations;
+    }
+
   } // namespace op
 } // namespace persistence
@@ -1,6 +1,7 @@
 #ifndef PERSISTENCE_OP_OPERATIONS_H
 #define PERSISTENCE_OP_OPERATIONS_H
 
+#include "hotel/groupallocation.h"
 #include "hotel/hotel.h"
 #include "hotel/person.h"
 #include "hotel/reservation.h"
@@ -40,6 +41,23 @@ namespace persistence
             Operation;
     typedef std::vector<Operation> Operations;
 
+    /**
+     * @brief storeGroupAllocation creates a StoreNew operation for every room of the given allocation
+     *
+     * The operations should be queued together, so that either all or none of the reservations are stored.
+     *
+     * @throw std::invalid_argument if the allocation did not succeed
+     */
+    Operations storeGroupAllocation(const hotel::GroupAllocation& allocation, const std::string& description);
+
+    /**
+     * @brief updateReservations creates an Update operation for every given reservation
+     *
+     * This applies e.g. the changed reservations of hotel::PlanningOptimizer::Result. The operations should be queued
+     * together, so that the planning is never stored half way through the change.
+     */
+    Operations updateReservations(std::vector<hotel::Reservation> reservations);
+
   } // namespace op
 } // namespace persistence
 
@@ -2,12 +2,317 @@
 
 #include "persistence/changequeue.h"
 
+#include <boost/date_time/gregorian/gregorian.hpp>
+
+#include <algorithm>
 #include <cassert>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace persistence
 {
   namespace detail
   {
+    namespace
+    {
+      //! Reads the range given by the options "from" and "to" as ISO dates, returns an empty range if they are invalid
+      hotel::DayRange streamRange(const nlohmann::json& options)
+      {
+        if (!options.is_object() || !options.contains("from") || !options.contains("to"))
+        {
+          std::cerr << "Reservation streams over a range of days need the options \"from\" and \"to\"" << std::endl;
+          return hotel::DayRange();
+        }
+
+        try
+        {
+          auto from = boost::gregorian::from_simple_string(options["from"].get<std::string>());
+          auto to = boost::gregorian::from_simple_string(options["to"].get<std::string>());
+          return hotel::DayRange(hotel::Day::fromDate(from), hotel::Day::fromDate(to));
+        }
+        catch (const std::exception& e)
+        {
+          std::cerr << "Invalid range for reservation stream: " << e.what() << std::endl;
+          return hotel::DayRange();
+        }
+      }
+
+      /**
+       * @brief The ReservationWindow struct is the part of the planning streamed by a "reservation.by_period" stream
+       */
+      struct ReservationWindow
+      {
+        explicit ReservationWindow(const nlohmann::json& options) : range(streamRange(options))
+        {
+          if (!options.is_object() || !options.contains("rooms"))
+            return;
+          try
+          {
+            rooms = options["rooms"].get<std::vector<int>>();
+          }
+          catch (const std::exception& e)
+          {
+            std::cerr << "Invalid rooms for reservation stream: " << e.what() << std::endl;
+            range = hotel::DayRange();
+          }
+        }
+
+        bool containsRoom(int roomId) const
+        {
+          return !rooms || std::find(rooms->begin(), rooms->end(), roomId) != rooms->end();
+        }
+
+        //! Returns true if the reservation is in the planning and has a night of the window in one of its rooms
+        bool contains(const hotel::Reservation& reservation) const
+        {
+          if (reservation.status() == hotel::Reservation::Archived)
+            return false;
+          return std::any_of(reservation.atoms().begin(), reservation.atoms().end(), [this](const auto& atom) {
+            return atom.dayRange().intersects(range) && containsRoom(atom.roomId());
+          });
+        }
+
+        std::vector<hotel::Reservation> load(sqlite::SqliteStorage& storage) const
+        {
+          if (range.isEmpty())
+            return {};
+          return rooms ? storage.loadReservationsInRooms(*rooms, range)
+                       : storage.loadInPeriod<hotel::Reservation>(range);
+        }
+
+        hotel::DayRange range;
+        //! The rooms to which the window is restricted, all rooms if not set
+        std::optional<std::vector<int>> rooms;
+      };
+
+      //! Returns the chunk size for the initialization of the stream, given by the option "chunk_size"
+      std::size_t chunkSize(const DataStream& stream)
+      {
+        auto& options = stream.streamOptions();
+        if (!options.is_object() || !options.contains("chunk_size") || !options["chunk_size"].is_number_integer() ||
+            options["chunk_size"].get<int64_t>() <= 0)
+          return DataStreamManager::defaultChunkSize;
+        return options["chunk_size"].get<std::size_t>();
+      }
+
+      //! Returns the items with an id up to lastId
+      StreamableItems itemsUpTo(const StreamableItems& items, int lastId)
+      {
+        return std::visit(
+            [lastId](const auto& items) -> StreamableItems {
+              typename std::remove_const<typename std::remove_reference<decltype(items)>::type>::type filteredItems;
+              std::copy_if(items.begin(), items.end(), std::back_inserter(filteredItems),
+                           [lastId](const auto& item) { return item.id() <= lastId; });
+              return filteredItems;
+            },
+            items);
+      }
+
+      bool isEmpty(const StreamableItems& items)
+      {
+        return std::visit([](const auto& items) { return items.empty(); }, items);
+      }
+
+      //! Returns the ids of the items, in the order of the items
+      std::vector<int> itemIds(const StreamableItems& items)
+      {
+        std::vector<int> ids;
+        std::visit(
+            [&ids](const auto& items) {
+              for (auto& item : items)
+                ids.push_back(item.id());
+            },
+            items);
+        return ids;
+      }
+
+      /**
+       * @brief The HeldItemIds class keeps track of the items which the observers of some streams hold
+       *
+       * Handlers of streams which only send some of the items use it to only send removals for the items the observer
+       * holds. Streams initialized from a snapshot receive changes before their initial data has been sent, until then
+       * every item may be held. The initial data is sent on the reader threads, so the ids are guarded by a mutex.
+       */
+      class HeldItemIds
+      {
+      public:
+        //! Starts to keep track of the stream, keeps the ids if the stream is known already
+        void open(int streamId)
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _streams.try_emplace(streamId);
+        }
+
+        void close(int streamId)
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _streams.erase(streamId);
+        }
+
+        void initialChangeSent(int streamId, const DataStreamChange& change)
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          auto it = _streams.find(streamId);
+          if (it == _streams.end())
+            return;
+          auto& stream = it->second;
+          if (auto added = std::get_if<DataStreamItemsAdded>(&change))
+          {
+            // The items which have been removed since the snapshot are taken from the observer after the initial data
+            if (!stream.isCleared)
+              for (auto id : itemIds(*added->newItems))
+                if (stream.removedIds.count(id) == 0)
+                  stream.ids.insert(id);
+          }
+          else if (std::holds_alternative<DataStreamInitialized>(change))
+          {
+            stream.isInitialized = true;
+            stream.isCleared = false;
+            stream.removedIds.clear();
+          }
+        }
+
+        void insert(int streamId, const std::vector<int>& ids)
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          auto it = _streams.find(streamId);
+          if (it != _streams.end())
+            it->second.ids.insert(ids.begin(), ids.end());
+        }
+
+        //! Forgets the items and returns those of them which the observer may hold
+        std::vector<int> erase(int streamId, const std::vector<int>& ids)
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          auto it = _streams.find(streamId);
+          if (it == _streams.end())
+            return ids;
+          auto& stream = it->second;
+          std::vector<int> heldIds;
+          for (auto id : ids)
+          {
+            if (stream.ids.erase(id) != 0 || !stream.isInitialized)
+              heldIds.push_back(id);
+            if (!stream.isInitialized)
+              stream.removedIds.insert(id);
+          }
+          return heldIds;
+        }
+
+        void clear(int streamId)
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          auto it = _streams.find(streamId);
+          if (it == _streams.end())
+            return;
+          it->second.ids.clear();
+          if (!it->second.isInitialized)
+            it->second.isCleared = true;
+        }
+
+        std::unordered_set<int> ids(int streamId) const
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          auto it = _streams.find(streamId);
+          return it != _streams.end() ? it->second.ids : std::unordered_set<int>();
+        }
+
+        //! Replaces the items held by the observer, once it has been brought up to date with new options
+        void assign(int streamId, std::unordered_set<int> ids)
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          auto it = _streams.find(streamId);
+          if (it != _streams.end())
+            it->second.ids = std::move(ids);
+        }
+
+      private:
+        struct Stream
+        {
+          std::unordered_set<int> ids;
+          //! Set once the initial data has been sent, before that the observer may hold any item
+          bool isInitialized = false;
+          //! The items which have been removed, and whether the stream has been cleared, before it was initialized
+          std::unordered_set<int> removedIds;
+          bool isCleared = false;
+        };
+
+        mutable std::mutex _mutex;
+        std::unordered_map<int, Stream> _streams;
+      };
+
+      //! Returns how many chunks of items have been loaded into the changes
+      std::size_t loadedChunks(const std::vector<DataStreamDifferential>& changes)
+      {
+        return static_cast<std::size_t>(std::count_if(changes.begin(), changes.end(), [](const auto& change) {
+          return std::holds_alternative<DataStreamItemsAdded>(change.change);
+        }));
+      }
+
+      //! Returns true if both streams are initialized with the same data
+      bool hasSameInitialData(const DataStream& a, const DataStream& b)
+      {
+        return a.streamType() == b.streamType() && a.streamEndpoint() == b.streamEndpoint() &&
+               a.streamOptions() == b.streamOptions();
+      }
+
+      //! Sends the initial data loaded for the first of the streams to all of them, sharing the added items
+      template <class AddChange>
+      void sendInitialData(const std::vector<DataStreamDifferential>& changes,
+                           const std::vector<std::shared_ptr<DataStream>>& streams, DataStreamHandler* handler,
+                           AddChange addChange)
+      {
+        for (auto& change : changes)
+          for (auto& stream : streams)
+          {
+            if (handler != nullptr)
+              handler->initialChangeSent(*stream, change.change);
+            addChange(stream->streamId(), change.change);
+          }
+      }
+    } // namespace
+
+    bool DataStreamHandler::initializeChunk(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                                            sqlite::SqliteStorage& storage, [[maybe_unused]] int& lastId,
+                                            [[maybe_unused]] std::size_t chunkSize)
+    {
+      initialize(stream, changeQueue, storage);
+      return true;
+    }
+
+    bool DataStreamHandler::initializeFromMirror([[maybe_unused]] DataStream& stream,
+                                                 [[maybe_unused]] std::vector<DataStreamDifferential>& changeQueue,
+                                                 [[maybe_unused]] const sqlite::SqliteMirror& mirror,
+                                                 [[maybe_unused]] std::size_t chunkSize)
+    {
+      return false;
+    }
+
+    std::optional<int> DataStreamHandler::itemId([[maybe_unused]] const DataStream& stream) const
+    {
+      return std::nullopt;
+    }
+
+    bool DataStreamHandler::indexStream([[maybe_unused]] const DataStream& stream) { return true; }
+
+    void DataStreamHandler::unindexStream([[maybe_unused]] const DataStream& stream) {}
+
+    void DataStreamHandler::initialChangeSent([[maybe_unused]] const DataStream& stream,
+                                              [[maybe_unused]] const DataStreamChange& change)
+    {
+    }
+
+    void DataStreamHandler::closeStream([[maybe_unused]] const DataStream& stream) {}
+
+    void DataStreamHandler::changeOptions(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                                          sqlite::SqliteStorage& storage, const nlohmann::json& options)
+    {
+      stream.setStreamOptions(options);
+      clear(stream, changeQueue);
+      initialize(stream, changeQueue, storage);
+    }
+
     class DefaultDataStreamHandler : public DataStreamHandler
     {
     public:
@@ -26,6 +331,36 @@ namespace persistence
         }
       }
 
+      virtual bool initializeChunk(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                                   sqlite::SqliteStorage& storage, int& lastId, std::size_t chunkSize) override
+      {
+        switch (stream.streamType())
+        {
+        case StreamableType::NullStream:
+          return true;
+        case StreamableType::Hotel:
+          return initializeChunkTyped<hotel::Hotel>(stream, changeQueue, storage, lastId, chunkSize);
+        case StreamableType::Reservation:
+          return initializeChunkTyped<hotel::Reservation>(stream, changeQueue, storage, lastId, chunkSize);
+        }
+        return true;
+      }
+
+      virtual bool initializeFromMirror(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                                        const sqlite::SqliteMirror& mirror, std::size_t chunkSize) override
+      {
+        switch (stream.streamType())
+        {
+        case StreamableType::NullStream:
+          return true;
+        case StreamableType::Hotel:
+          return initializeFromMirrorTyped<hotel::Hotel>(stream, changeQueue, mirror, chunkSize);
+        case StreamableType::Reservation:
+          return initializeFromMirrorTyped<hotel::Reservation>(stream, changeQueue, mirror, chunkSize);
+        }
+        return true;
+      }
+
       virtual void addItems(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
                             const StreamableItems& items) override
       {
@@ -57,6 +392,34 @@ namespace persistence
         auto items = storage.loadAll<T>();
         changeQueue.push_back({stream.streamId(), DataStreamItemsAdded{std::move(items)}});
       }
+
+      template <class T>
+      bool initializeChunkTyped(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                                sqlite::SqliteStorage& storage, int& lastId, std::size_t chunkSize)
+      {
+        auto items = storage.loadChunk<T>(lastId, chunkSize);
+        bool isComplete = items.size() < chunkSize;
+        if (!items.empty())
+        {
+          lastId = items.back().id();
+          changeQueue.push_back({stream.streamId(), DataStreamItemsAdded{std::move(items)}});
+        }
+        return isComplete;
+      }
+
+      template <class T>
+      bool initializeFromMirrorTyped(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                                     const sqlite::SqliteMirror& mirror, std::size_t chunkSize)
+      {
+        int lastId = 0;
+        for (auto items = mirror.loadChunk<T>(lastId, chunkSize); !items.empty();
+             items = mirror.loadChunk<T>(lastId, chunkSize))
+        {
+          lastId = items.back().id();
+          changeQueue.push_back({stream.streamId(), DataStreamItemsAdded{std::move(items)}});
+        }
+        return true;
+      }
     };
 
     class SingleIdDataStreamHandler : public DataStreamHandler
@@ -80,8 +443,7 @@ namespace persistence
       virtual void addItems(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
                             const StreamableItems& items) override
       {
-        int id = stream.streamOptions()["id"];
-        auto filteredItems = filter(items, id);
+        auto filteredItems = filter(items, _ids.at(&stream));
         bool isEmpty = std::visit([](const auto& items) { return items.empty(); }, filteredItems);
         if (!isEmpty)
           changeQueue.push_back({stream.streamId(), DataStreamItemsAdded{filteredItems}});
@@ -90,8 +452,7 @@ namespace persistence
       virtual void updateItems(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
                                const StreamableItems& items) override
       {
-        int id = stream.streamOptions()["id"];
-        auto filteredItems = filter(items, id);
+        auto filteredItems = filter(items, _ids.at(&stream));
         bool isEmpty = std::visit([](const auto& items) { return items.empty(); }, filteredItems);
         if (!isEmpty)
           changeQueue.push_back({stream.streamId(), DataStreamItemsUpdated{filteredItems}});
@@ -100,7 +461,7 @@ namespace persistence
       virtual void removeItems(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
                                const std::vector<int> ids) override
       {
-        int id = stream.streamOptions()["id"];
+        int id = _ids.at(&stream);
         if (std::any_of(ids.begin(), ids.end(), [id](int item) { return item == id; }))
           changeQueue.push_back({stream.streamId(), DataStreamItemsRemoved{{id}}});
       }
@@ -110,6 +471,57 @@ namespace persistence
         changeQueue.push_back({stream.streamId(), DataStreamCleared{}});
       }
 
+      virtual bool initializeFromMirror(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                                        const sqlite::SqliteMirror& mirror,
+                                        [[maybe_unused]] std::size_t chunkSize) override
+      {
+        auto id = itemId(stream);
+        if (!id)
+          return false;
+        switch (stream.streamType())
+        {
+        case StreamableType::NullStream:
+          return false;
+        case StreamableType::Hotel:
+          if (auto hotel = mirror.loadById<hotel::Hotel>(*id))
+            changeQueue.push_back({stream.streamId(), DataStreamItemsAdded{std::vector<hotel::Hotel>{*hotel}}});
+          return true;
+        case StreamableType::Reservation:
+        {
+          // Archived reservations are not mirrored, and are loaded from the storage instead
+          auto reservation = mirror.loadById<hotel::Reservation>(*id);
+          if (!reservation)
+            return false;
+          changeQueue.push_back(
+              {stream.streamId(), DataStreamItemsAdded{std::vector<hotel::Reservation>{*reservation}}});
+          return true;
+        }
+        }
+        return false;
+      }
+
+      virtual std::optional<int> itemId(const DataStream& stream) const override
+      {
+        auto& options = stream.streamOptions();
+        if (!options.is_object() || !options.contains("id") || !options["id"].is_number_integer())
+          return std::nullopt;
+        return options["id"].get<int>();
+      }
+
+      virtual bool indexStream(const DataStream& stream) override
+      {
+        auto id = itemId(stream);
+        if (!id)
+        {
+          std::cerr << "Streams of a single item need the option \"id\"" << std::endl;
+          return false;
+        }
+        _ids.insert_or_assign(&stream, *id);
+        return true;
+      }
+
+      virtual void unindexStream(const DataStream& stream) override { _ids.erase(&stream); }
+
     private:
       StreamableItems filter(const StreamableItems& items, int id)
       {
@@ -127,14 +539,309 @@ namespace persistence
       void initializeTyped(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
                            sqlite::SqliteStorage& storage)
       {
-        auto id = stream.streamOptions()["id"];
-        auto item = storage.loadById<T>(id);
+        auto id = itemId(stream);
+        if (!id)
+          return;
+        auto item = storage.loadById<T>(*id);
         if (item != std::nullopt)
         {
           std::vector<T> items({*item});
           changeQueue.push_back({stream.streamId(), DataStreamItemsAdded{std::move(items)}});
         }
       }
+
+      //! The id of each indexed stream, so that the options are not read for every change
+      std::unordered_map<const DataStream*, int> _ids;
+    };
+
+    /**
+     * @brief The PlanningReservationsStreamHandler class streams all reservations which are not archived
+     */
+    class PlanningReservationsStreamHandler : public DefaultDataStreamHandler
+    {
+    public:
+      virtual ~PlanningReservationsStreamHandler() = default;
+
+      virtual void addItems(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                            const StreamableItems& items) override
+      {
+        std::vector<hotel::Reservation> planned;
+        for (auto& reservation : std::get<std::vector<hotel::Reservation>>(items))
+          if (reservation.status() != hotel::Reservation::Archived)
+            planned.push_back(reservation);
+        if (!planned.empty())
+          changeQueue.push_back({stream.streamId(), DataStreamItemsAdded{std::move(planned)}});
+      }
+
+      virtual void updateItems(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                               const StreamableItems& items) override
+      {
+        std::vector<hotel::Reservation> planned;
+        std::vector<int> archivedIds;
+        for (auto& reservation : std::get<std::vector<hotel::Reservation>>(items))
+        {
+          if (reservation.status() != hotel::Reservation::Archived)
+            planned.push_back(reservation);
+          else
+            archivedIds.push_back(reservation.id());
+        }
+        if (!planned.empty())
+          changeQueue.push_back({stream.streamId(), DataStreamItemsUpdated{std::move(planned)}});
+        if (!archivedIds.empty())
+          changeQueue.push_back({stream.streamId(), DataStreamItemsRemoved{std::move(archivedIds)}});
+      }
+    };
+
+    /**
+     * @brief The ArchivedReservationsStreamHandler class streams the archived reservations intersecting a range of days
+     *
+     * The range is given by the options "from" and "to" as ISO dates.
+     */
+    class ArchivedReservationsStreamHandler : public DataStreamHandler
+    {
+    public:
+      virtual ~ArchivedReservationsStreamHandler() = default;
+
+      virtual void initialize(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                              sqlite::SqliteStorage& storage) override
+      {
+        auto range = streamRange(stream.streamOptions());
+        if (!range.isEmpty())
+          changeQueue.push_back({stream.streamId(), DataStreamItemsAdded{storage.loadArchivedReservations(range)}});
+      }
+
+      virtual void addItems(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                            const StreamableItems& items) override
+      {
+        auto range = _ranges.at(&stream);
+        std::vector<hotel::Reservation> archived;
+        std::vector<int> archivedIds;
+        for (auto& reservation : std::get<std::vector<hotel::Reservation>>(items))
+          if (reservation.status() == hotel::Reservation::Archived && reservation.dayRange().intersects(range))
+          {
+            archived.push_back(reservation);
+            archivedIds.push_back(reservation.id());
+          }
+        if (archived.empty())
+          return;
+        _heldIds.insert(stream.streamId(), archivedIds);
+        changeQueue.push_back({stream.streamId(), DataStreamItemsAdded{std::move(archived)}});
+      }
+
+      virtual void updateItems(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                               const StreamableItems& items) override
+      {
+        // Reservations which are no longer archived, or which were moved out of the range, leave the stream
+        auto range = _ranges.at(&stream);
+        std::vector<hotel::Reservation> archived;
+        std::vector<int> archivedIds;
+        std::vector<int> removedIds;
+        for (auto& reservation : std::get<std::vector<hotel::Reservation>>(items))
+        {
+          if (reservation.status() == hotel::Reservation::Archived && reservation.dayRange().intersects(range))
+          {
+            archived.push_back(reservation);
+            archivedIds.push_back(reservation.id());
+          }
+          else
+            removedIds.push_back(reservation.id());
+        }
+        if (!archived.empty())
+        {
+          _heldIds.insert(stream.streamId(), archivedIds);
+          changeQueue.push_back({stream.streamId(), DataStreamItemsUpdated{std::move(archived)}});
+        }
+        removeItems(stream, changeQueue, removedIds);
+      }
+
+      virtual void removeItems(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                               const std::vector<int> ids) override
+      {
+        auto heldIds = _heldIds.erase(stream.streamId(), ids);
+        if (!heldIds.empty())
+          changeQueue.push_back({stream.streamId(), DataStreamItemsRemoved{std::move(heldIds)}});
+      }
+
+      virtual void clear(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue) override
+      {
+        _heldIds.clear(stream.streamId());
+        changeQueue.push_back({stream.streamId(), DataStreamCleared{}});
+      }
+
+      virtual void changeOptions(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                                 sqlite::SqliteStorage& storage, const nlohmann::json& options) override
+      {
+        // Only the reservations which enter or leave the stream are sent, e.g. when the range grows
+        stream.setStreamOptions(options);
+        auto range = streamRange(options);
+        auto previousIds = _heldIds.ids(stream.streamId());
+        std::unordered_set<int> currentIds;
+        std::vector<hotel::Reservation> added;
+        if (!range.isEmpty())
+          for (auto& reservation : storage.loadArchivedReservations(range))
+          {
+            currentIds.insert(reservation.id());
+            if (previousIds.count(reservation.id()) == 0)
+              added.push_back(std::move(reservation));
+          }
+
+        std::vector<int> removedIds;
+        std::copy_if(previousIds.begin(), previousIds.end(), std::back_inserter(removedIds),
+                     [&currentIds](int id) { return currentIds.count(id) == 0; });
+        std::sort(removedIds.begin(), removedIds.end());
+        if (!removedIds.empty())
+          changeQueue.push_back({stream.streamId(), DataStreamItemsRemoved{std::move(removedIds)}});
+        if (!added.empty())
+          changeQueue.push_back({stream.streamId(), DataStreamItemsAdded{std::move(added)}});
+        _heldIds.assign(stream.streamId(), std::move(currentIds));
+      }
+
+      virtual bool indexStream(const DataStream& stream) override
+      {
+        _ranges.insert_or_assign(&stream, streamRange(stream.streamOptions()));
+        _heldIds.open(stream.streamId());
+        return true;
+      }
+
+      virtual void unindexStream(const DataStream& stream) override { _ranges.erase(&stream); }
+
+      virtual void initialChangeSent(const DataStream& stream, const DataStreamChange& change) override
+      {
+        _heldIds.initialChangeSent(stream.streamId(), change);
+      }
+
+      virtual void closeStream(const DataStream& stream) override { _heldIds.close(stream.streamId()); }
+
+    private:
+      //! The range of each indexed stream, so that the options are not parsed for every change
+      std::unordered_map<const DataStream*, hotel::DayRange> _ranges;
+      //! The reservations sent to each stream, so that removals are only sent for reservations the observer holds
+      HeldItemIds _heldIds;
+    };
+
+    /**
+     * @brief The PeriodReservationsStreamHandler class streams the reservations which have a night in a window of days
+     *
+     * The window is given by the options "from" and "to" as ISO dates, and is optionally restricted to the room ids
+     * listed in "rooms". Reservations which are updated into the window are reported as updates, reservations which
+     * leave it are removed. Moving the window only sends the reservations which enter or leave it.
+     */
+    class PeriodReservationsStreamHandler : public DataStreamHandler
+    {
+    public:
+      virtual ~PeriodReservationsStreamHandler() = default;
+
+      virtual void initialize(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                              sqlite::SqliteStorage& storage) override
+      {
+        auto reservations = ReservationWindow(stream.streamOptions()).load(storage);
+        if (!reservations.empty())
+          changeQueue.push_back({stream.streamId(), DataStreamItemsAdded{std::move(reservations)}});
+      }
+
+      virtual void addItems(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                            const StreamableItems& items) override
+      {
+        auto& window = _windows.at(&stream);
+        std::vector<hotel::Reservation> added;
+        std::vector<int> addedIds;
+        for (auto& reservation : std::get<std::vector<hotel::Reservation>>(items))
+          if (window.contains(reservation))
+          {
+            added.push_back(reservation);
+            addedIds.push_back(reservation.id());
+          }
+        if (added.empty())
+          return;
+        _heldIds.insert(stream.streamId(), addedIds);
+        changeQueue.push_back({stream.streamId(), DataStreamItemsAdded{std::move(added)}});
+      }
+
+      virtual void updateItems(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                               const StreamableItems& items) override
+      {
+        auto& window = _windows.at(&stream);
+        std::vector<hotel::Reservation> updated;
+        std::vector<int> updatedIds;
+        std::vector<int> removedIds;
+        for (auto& reservation : std::get<std::vector<hotel::Reservation>>(items))
+        {
+          if (window.contains(reservation))
+          {
+            updated.push_back(reservation);
+            updatedIds.push_back(reservation.id());
+          }
+          else
+            removedIds.push_back(reservation.id());
+        }
+        if (!updated.empty())
+        {
+          _heldIds.insert(stream.streamId(), updatedIds);
+          changeQueue.push_back({stream.streamId(), DataStreamItemsUpdated{std::move(updated)}});
+        }
+        removeItems(stream, changeQueue, removedIds);
+      }
+
+      virtual void removeItems(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                               const std::vector<int> ids) override
+      {
+        auto heldIds = _heldIds.erase(stream.streamId(), ids);
+        if (!heldIds.empty())
+          changeQueue.push_back({stream.streamId(), DataStreamItemsRemoved{std::move(heldIds)}});
+      }
+
+      virtual void clear(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue) override
+      {
+        _heldIds.clear(stream.streamId());
+        changeQueue.push_back({stream.streamId(), DataStreamCleared{}});
+      }
+
+      virtual void changeOptions(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                                 sqlite::SqliteStorage& storage, const nlohmann::json& options) override
+      {
+        stream.setStreamOptions(options);
+        auto previousIds = _heldIds.ids(stream.streamId());
+        std::unordered_set<int> currentIds;
+        std::vector<hotel::Reservation> added;
+        for (auto& reservation : ReservationWindow(options).load(storage))
+        {
+          currentIds.insert(reservation.id());
+          if (previousIds.count(reservation.id()) == 0)
+            added.push_back(std::move(reservation));
+        }
+
+        std::vector<int> removedIds;
+        std::copy_if(previousIds.begin(), previousIds.end(), std::back_inserter(removedIds),
+                     [&currentIds](int id) { return currentIds.count(id) == 0; });
+        std::sort(removedIds.begin(), removedIds.end());
+        if (!removedIds.empty())
+          changeQueue.push_back({stream.streamId(), DataStreamItemsRemoved{std::move(removedIds)}});
+        if (!added.empty())
+          changeQueue.push_back({stream.streamId(), DataStreamItemsAdded{std::move(added)}});
+        _heldIds.assign(stream.streamId(), std::move(currentIds));
+      }
+
+      virtual bool indexStream(const DataStream& stream) override
+      {
+        _windows.insert_or_assign(&stream, ReservationWindow(stream.streamOptions()));
+        _heldIds.open(stream.streamId());
+        return true;
+      }
+
+      virtual void unindexStream(const DataStream& stream) override { _windows.erase(&stream); }
+
+      virtual void initialChangeSent(const DataStream& stream, const DataStreamChange& change) override
+      {
+        _heldIds.initialChangeSent(stream.streamId(), change);
+      }
+
+      virtual void closeStream(const DataStream& stream) override { _heldIds.close(stream.streamId()); }
+
+    private:
+      //! The window of each indexed stream, so that the options are not parsed for every change
+      std::unordered_map<const DataStream*, ReservationWindow> _windows;
+      //! The reservations sent to each stream, so that removals are only sent for reservations the observer holds
+      HeldItemIds _heldIds;
     };
 
     DataStreamManager::DataStreamManager()
@@ -142,15 +849,21 @@ namespace persistence
       _streamHandlers[HandlerKey{StreamableType::NullStream, ""}] = std::make_unique<DefaultDataStreamHandler>();
       _streamHandlers[HandlerKey{StreamableType::Hotel, ""}] = std::make_unique<DefaultDataStreamHandler>();
       _streamHandlers[HandlerKey{StreamableType::Hotel, "hotel.by_id"}] = std::make_unique<SingleIdDataStreamHandler>();
-      _streamHandlers[HandlerKey{StreamableType::Reservation, ""}] = std::make_unique<DefaultDataStreamHandler>();
+      _streamHandlers[HandlerKey{StreamableType::Reservation, ""}] =
+          std::make_unique<PlanningReservationsStreamHandler>();
       _streamHandlers[HandlerKey{StreamableType::Reservation, "reservation.by_id"}] =
           std::make_unique<SingleIdDataStreamHandler>();
+      _streamHandlers[HandlerKey{StreamableType::Reservation, "reservation.archived"}] =
+          std::make_unique<ArchivedReservationsStreamHandler>();
+      _streamHandlers[HandlerKey{StreamableType::Reservation, "reservation.by_period"}] =
+          std::make_unique<PeriodReservationsStreamHandler>();
     }
 
     void DataStreamManager::addNewStream(const std::shared_ptr<DataStream>& stream)
     {
       std::lock_guard<std::mutex> lock(_streamMutex);
       _uninitializedStreams.push_back(stream);
+      _hasNewStreams = true;
     }
 
     void DataStreamManager::removeStream(const std::shared_ptr<DataStream>& stream)
@@ -158,32 +871,252 @@ namespace persistence
       std::lock_guard<std::mutex> lock(_streamMutex);
       _uninitializedStreams.erase(std::remove(_uninitializedStreams.begin(), _uninitializedStreams.end(), stream),
                                   _uninitializedStreams.end());
-      _activeStreams.erase(std::remove(_activeStreams.begin(), _activeStreams.end(), stream), _activeStreams.end());
+      auto it = std::find(_activeStreams.begin(), _activeStreams.end(), stream);
+      if (it != _activeStreams.end())
+      {
+        unindexStream(*stream);
+        if (auto handler = findHandler(*stream))
+          handler->closeStream(*stream);
+        _activeStreams.erase(it);
+      }
+    }
+
+    void DataStreamManager::changeStreamOptions(const std::shared_ptr<DataStream>& stream,
+                                                const nlohmann::json& options)
+    {
+      std::lock_guard<std::mutex> lock(_streamMutex);
+      _pendingOptionChanges.emplace_back(stream, options);
     }
 
-    void DataStreamManager::initialize(ChangeQueue& changeQueue, sqlite::SqliteStorage& storage)
+    void DataStreamManager::initialize(ChangeQueue& changeQueue, sqlite::SqliteStorage& storage,
+                                       sqlite::SqliteReaderPool* readers, const sqlite::SqliteMirror* mirror)
     {
-      // Copy the uninitialized streams to the active list while holding the lock.
+      if (mirror != nullptr)
+        initializeFromMirror(changeQueue, *mirror);
+      if (readers != nullptr && readers->readerCount() > 0)
+        return initializeFromSnapshots(changeQueue, *readers);
+
+      // Copy the uninitialized streams to the active list while holding the lock, and forget the removed streams.
       // The actual initialization is done while not holding the lock, since it may take a long time.
       std::vector<std::shared_ptr<DataStream>> uninitializedStreams;
       std::unique_lock<std::mutex> lock(_streamMutex);
       std::swap(uninitializedStreams, _uninitializedStreams);
-      std::copy(uninitializedStreams.begin(), uninitializedStreams.end(), std::back_inserter(_activeStreams));
+      for (auto& uninitializedStream : uninitializedStreams)
+        activateStream(uninitializedStream);
+      _initializingStreams.erase(std::remove_if(_initializingStreams.begin(), _initializingStreams.end(),
+                                                [this](const auto& initializing) {
+                                                  return std::find(_activeStreams.begin(), _activeStreams.end(),
+                                                                   initializing.first) == _activeStreams.end();
+                                                }),
+                                 _initializingStreams.end());
       lock.unlock();
 
       for (auto& uninitializedStream : uninitializedStreams)
+        _initializingStreams.emplace_back(std::move(uninitializedStream), 0);
+
+      // Streams which need the same chunk are sent the chunk loaded for the first of them
+      std::vector<std::pair<std::shared_ptr<DataStream>, int>> stillInitializing;
+      std::vector<bool> isSent(_initializingStreams.size(), false);
+      for (std::size_t i = 0; i < _initializingStreams.size(); ++i)
       {
-        auto streamPtr = uninitializedStream.get();
-        auto streamHandler = findHandler(*streamPtr);
+        if (isSent[i])
+          continue;
+        auto& [stream, lastId] = _initializingStreams[i];
+        std::vector<std::shared_ptr<DataStream>> streams = {stream};
+        for (std::size_t j = i + 1; j < _initializingStreams.size(); ++j)
+        {
+          auto& [other, otherLastId] = _initializingStreams[j];
+          if (!isSent[j] && otherLastId == lastId && hasSameInitialData(*stream, *other))
+          {
+            streams.push_back(other);
+            isSent[j] = true;
+          }
+        }
+
+        auto streamHandler = findHandler(*stream);
         std::vector<DataStreamDifferential> changes;
+        int nextId = lastId;
+        bool isComplete = true;
         if (streamHandler)
-          streamHandler->initialize(*streamPtr, changes, storage);
+          isComplete = streamHandler->initializeChunk(*stream, changes, storage, nextId, chunkSize(*stream));
         else
           std::cerr << "Cannot initialize stream, because there is no handler registered" << std::endl;
-        changes.push_back({streamPtr->streamId(), DataStreamInitialized{}});
+        _savedInitialLoads += (streams.size() - 1) * loadedChunks(changes);
+        if (isComplete)
+          changes.push_back({stream->streamId(), DataStreamInitialized{}});
+        sendInitialData(changes, streams, streamHandler,
+                        [&changeQueue](int streamId, const DataStreamChange& change) {
+                          changeQueue.addStreamChange(streamId, change);
+                        });
+
+        if (!isComplete)
+          for (auto& initializingStream : streams)
+            stillInitializing.emplace_back(std::move(initializingStream), nextId);
+      }
+      _initializingStreams = std::move(stillInitializing);
+    }
+
+    void DataStreamManager::initializeFromSnapshots(ChangeQueue& changeQueue, sqlite::SqliteReaderPool& readers)
+    {
+      std::lock_guard<std::mutex> lock(_streamMutex);
+      while (!_uninitializedStreams.empty())
+      {
+        auto stream = _uninitializedStreams.front();
+        auto streamHandler = findHandler(*stream);
+        if (streamHandler == nullptr)
+        {
+          std::cerr << "Cannot initialize stream, because there is no handler registered" << std::endl;
+          changeQueue.addStreamChange(stream->streamId(), DataStreamInitialized{});
+          activateStream(stream);
+          _uninitializedStreams.erase(_uninitializedStreams.begin());
+          continue;
+        }
+
+        // All streams waiting for the same data are initialized from the same snapshot
+        std::vector<std::shared_ptr<DataStream>> streams;
+        std::copy_if(_uninitializedStreams.begin(), _uninitializedStreams.end(), std::back_inserter(streams),
+                     [&stream](const auto& other) { return hasSameInitialData(*stream, *other); });
+
+        // Only this thread starts jobs, so an idle reader stays idle until the job is started below
+        if (!readers.hasIdleReader())
+          break;
+
+        // The streams receive changes as soon as they are active, these must only be applied after the snapshot. The
+        // streams are activated before the job starts, so that their handler knows them once the snapshot is sent.
+        for (auto& sharingStream : streams)
+        {
+          changeQueue.holdStream(sharingStream->streamId());
+          _snapshotStreams.push_back(sharingStream);
+          activateStream(sharingStream);
+          _uninitializedStreams.erase(
+              std::find(_uninitializedStreams.begin(), _uninitializedStreams.end(), sharingStream));
+        }
+        auto job = [this, &changeQueue, streams, streamHandler](sqlite::SqliteStorage& snapshot) {
+          auto& stream = *streams.front();
+          int lastId = 0;
+          bool isComplete = false;
+          while (!isComplete)
+          {
+            std::vector<DataStreamDifferential> changes;
+            isComplete = streamHandler->initializeChunk(stream, changes, snapshot, lastId, chunkSize(stream));
+            _savedInitialLoads += (streams.size() - 1) * loadedChunks(changes);
+            sendInitialData(changes, streams, streamHandler,
+                            [&changeQueue](int streamId, const DataStreamChange& change) {
+                              changeQueue.addSnapshotChange(streamId, change);
+                            });
+          }
+          for (auto& sharingStream : streams)
+          {
+            streamHandler->initialChangeSent(*sharingStream, DataStreamInitialized{});
+            changeQueue.addSnapshotChange(sharingStream->streamId(), DataStreamInitialized{});
+            changeQueue.releaseStream(sharingStream->streamId());
+          }
+
+          // Option changes which had to wait for the initialization can be applied now
+          std::lock_guard<std::mutex> lock(_streamMutex);
+          auto isShared = [&streams](const std::shared_ptr<DataStream>& other) {
+            return std::find(streams.begin(), streams.end(), other) != streams.end();
+          };
+          _snapshotStreams.erase(std::remove_if(_snapshotStreams.begin(), _snapshotStreams.end(), isShared),
+                                 _snapshotStreams.end());
+          auto deferred = std::stable_partition(_deferredOptionChanges.begin(), _deferredOptionChanges.end(),
+                                                [&isShared](const auto& change) { return !isShared(change.first); });
+          std::move(deferred, _deferredOptionChanges.end(), std::back_inserter(_pendingOptionChanges));
+          _deferredOptionChanges.erase(deferred, _deferredOptionChanges.end());
+        };
+        [[maybe_unused]] bool isStarted = readers.tryRun(std::move(job));
+        assert(isStarted);
+      }
+    }
+
+    void DataStreamManager::initializeFromMirror(ChangeQueue& changeQueue, const sqlite::SqliteMirror& mirror)
+    {
+      // The mirror is only written to by the worker thread, so the streams are up to date as soon as they are active
+      std::lock_guard<std::mutex> lock(_streamMutex);
+      _hasNewStreams = false;
+      std::vector<std::shared_ptr<DataStream>> remainingStreams;
+      while (!_uninitializedStreams.empty())
+      {
+        auto stream = _uninitializedStreams.front();
+        auto isShared = [&stream](const auto& other) { return hasSameInitialData(*stream, *other); };
+        std::vector<std::shared_ptr<DataStream>> streams;
+        std::copy_if(_uninitializedStreams.begin(), _uninitializedStreams.end(), std::back_inserter(streams), isShared);
+        _uninitializedStreams.erase(
+            std::remove_if(_uninitializedStreams.begin(), _uninitializedStreams.end(), isShared),
+            _uninitializedStreams.end());
+
+        auto streamHandler = findHandler(*stream);
+        std::vector<DataStreamDifferential> changes;
+        bool isMirrored = streamHandler != nullptr &&
+                          streamHandler->initializeFromMirror(*stream, changes, mirror, chunkSize(*stream));
+        if (!isMirrored)
+        {
+          std::move(streams.begin(), streams.end(), std::back_inserter(remainingStreams));
+          continue;
+        }
+
+        _savedInitialLoads += (streams.size() - 1) * loadedChunks(changes);
+        changes.push_back({stream->streamId(), DataStreamInitialized{}});
+        for (auto& sharingStream : streams)
+          activateStream(sharingStream);
+        sendInitialData(changes, streams, streamHandler,
+                        [&changeQueue](int streamId, const DataStreamChange& change) {
+                          changeQueue.addStreamChange(streamId, change);
+                        });
+      }
+      _uninitializedStreams = std::move(remainingStreams);
+    }
+
+    void DataStreamManager::applyOptionChanges(ChangeQueue& changeQueue, sqlite::SqliteStorage& storage)
+    {
+      // Streams which have not been initialized yet simply start out with the new options, removed streams are skipped
+      // and streams which are being initialized by a reader have to wait until it is done
+      std::vector<std::pair<std::shared_ptr<DataStream>, nlohmann::json>> optionChanges;
+      std::unique_lock<std::mutex> lock(_streamMutex);
+      for (auto& optionChange : _pendingOptionChanges)
+      {
+        auto contains = [&optionChange](const std::vector<std::shared_ptr<DataStream>>& streams) {
+          return std::find(streams.begin(), streams.end(), optionChange.first) != streams.end();
+        };
+        if (contains(_uninitializedStreams))
+          optionChange.first->setStreamOptions(optionChange.second);
+        else if (contains(_snapshotStreams))
+          _deferredOptionChanges.push_back(std::move(optionChange));
+        else if (contains(_activeStreams))
+          optionChanges.push_back(std::move(optionChange));
+      }
+      _pendingOptionChanges.clear();
+      // The index depends on the options, the changes are only fanned out on this thread after the streams are indexed
+      for (auto& optionChange : optionChanges)
+        unindexStream(*optionChange.first);
+      lock.unlock();
+
+      for (auto& [stream, options] : optionChanges)
+      {
+        // A stream which is still being initialized starts over with the new options
+        auto initializing = std::find_if(_initializingStreams.begin(), _initializingStreams.end(),
+                                         [&stream](const auto& initializing) { return initializing.first == stream; });
+        if (initializing != _initializingStreams.end())
+        {
+          stream->setStreamOptions(options);
+          initializing->second = 0;
+          changeQueue.addStreamChange(stream->streamId(), DataStreamCleared{});
+          continue;
+        }
+
+        auto streamHandler = findHandler(*stream);
+        if (streamHandler == nullptr)
+          continue;
+        std::vector<DataStreamDifferential> changes;
+        streamHandler->changeOptions(*stream, changes, storage, options);
         for (auto& change : changes)
           changeQueue.addStreamChange(change.streamId, std::move(change.change));
       }
+
+      lock.lock();
+      for (auto& optionChange : optionChanges)
+        if (std::find(_activeStreams.begin(), _activeStreams.end(), optionChange.first) != _activeStreams.end())
+          indexStream(*optionChange.first);
     }
 
     template <class T, class Func> void DataStreamManager::foreachStream(Func func)
@@ -194,36 +1127,72 @@ namespace persistence
     template <class Func> void DataStreamManager::foreachStream(StreamableType type, Func func)
     {
       std::unique_lock<std::mutex> lock(_streamMutex);
-      for (auto& activeStream : _activeStreams)
+      for (auto& [stream, handler] : _streamsByType[type])
+        func(*stream, *handler);
+      for (auto& [id, indexedStream] : _streamsByItemId[type])
+        func(*indexedStream.first, *indexedStream.second);
+    }
+
+    template <class Func>
+    void DataStreamManager::foreachStream(StreamableType type, const std::vector<int>& itemIds, Func func)
+    {
+      std::unique_lock<std::mutex> lock(_streamMutex);
+      for (auto& [stream, handler] : _streamsByType[type])
+        func(*stream, *handler);
+
+      auto& streamsByItemId = _streamsByItemId[type];
+      if (streamsByItemId.empty())
+        return;
+      std::vector<int> ids(itemIds);
+      std::sort(ids.begin(), ids.end());
+      ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+      for (auto id : ids)
       {
-        auto handler = findHandler(*activeStream);
-        assert(handler != nullptr);
-        if (activeStream->streamType() == type && handler != nullptr)
-          func(*activeStream, *handler);
+        auto [begin, end] = streamsByItemId.equal_range(id);
+        for (auto it = begin; it != end; ++it)
+          func(*it->second.first, *it->second.second);
       }
     }
 
     void DataStreamManager::addItems(std::vector<DataStreamDifferential>& changeQueue, StreamableType type,
                                      const StreamableItems items)
     {
-      foreachStream(type, [&changeQueue, &items](DataStream& stream, DataStreamHandler& handler) {
-        handler.addItems(stream, changeQueue, items);
+      foreachStream(type, itemIds(items), [this, &changeQueue, &items](DataStream& stream, DataStreamHandler& handler) {
+        auto lastId = initializedUpTo(stream);
+        if (!lastId)
+          handler.addItems(stream, changeQueue, items);
+        else if (auto initializedItems = itemsUpTo(items, *lastId); !isEmpty(initializedItems))
+          handler.addItems(stream, changeQueue, initializedItems);
       });
     }
 
     void DataStreamManager::updateItems(std::vector<DataStreamDifferential>& changeQueue, StreamableType type,
                                         const StreamableItems items)
     {
-      foreachStream(type, [&changeQueue, &items](DataStream& stream, DataStreamHandler& handler) {
-        handler.updateItems(stream, changeQueue, items);
+      foreachStream(type, itemIds(items), [this, &changeQueue, &items](DataStream& stream, DataStreamHandler& handler) {
+        auto lastId = initializedUpTo(stream);
+        if (!lastId)
+          handler.updateItems(stream, changeQueue, items);
+        else if (auto initializedItems = itemsUpTo(items, *lastId); !isEmpty(initializedItems))
+          handler.updateItems(stream, changeQueue, initializedItems);
       });
     }
 
     void DataStreamManager::removeItems(std::vector<DataStreamDifferential>& changeQueue, StreamableType type,
                                         std::vector<int> ids)
     {
-      foreachStream(type, [&changeQueue, &ids](DataStream& stream, DataStreamHandler& handler) {
-        handler.removeItems(stream, changeQueue, ids);
+      foreachStream(type, ids, [this, &changeQueue, &ids](DataStream& stream, DataStreamHandler& handler) {
+        auto lastId = initializedUpTo(stream);
+        if (!lastId)
+        {
+          handler.removeItems(stream, changeQueue, ids);
+          return;
+        }
+
+        std::vector<int> initializedIds;
+        std::copy_if(ids.begin(), ids.end(), std::back_inserter(initializedIds), [&](int id) { return id <= *lastId; });
+        if (!initializedIds.empty())
+          handler.removeItems(stream, changeQueue, initializedIds);
       });
     }
 
@@ -233,20 +1202,71 @@ namespace persistence
           type, [&changeQueue](DataStream& stream, DataStreamHandler& handler) { handler.clear(stream, changeQueue); });
     }
 
+    std::optional<int> DataStreamManager::initializedUpTo(const DataStream& stream) const
+    {
+      auto it = std::find_if(_initializingStreams.begin(), _initializingStreams.end(),
+                             [&stream](const auto& initializing) { return initializing.first.get() == &stream; });
+      return it != _initializingStreams.end() ? std::optional<int>(it->second) : std::nullopt;
+    }
+
     DataStreamHandler* DataStreamManager::findHandler(const DataStream& stream)
     {
       auto it = _streamHandlers.find({stream.streamType(), stream.streamEndpoint()});
       return (it != _streamHandlers.end()) ? it->second.get() : nullptr;
     }
 
+    void DataStreamManager::activateStream(const std::shared_ptr<DataStream>& stream)
+    {
+      _activeStreams.push_back(stream);
+      indexStream(*stream);
+    }
+
+    void DataStreamManager::indexStream(DataStream& stream)
+    {
+      auto handler = findHandler(stream);
+      if (handler == nullptr)
+        return;
+      if (!handler->indexStream(stream))
+        return;
+      if (auto id = handler->itemId(stream))
+        _streamsByItemId[stream.streamType()].emplace(*id, IndexedStream{&stream, handler});
+      else
+        _streamsByType[stream.streamType()].emplace_back(&stream, handler);
+    }
+
+    void DataStreamManager::unindexStream(const DataStream& stream)
+    {
+      // Streams are removed from the main thread, while the worker thread may be changing their options. The options
+      // must thus not be read here.
+      if (auto handler = findHandler(stream))
+        handler->unindexStream(stream);
+      auto isStream = [&stream](const IndexedStream& indexedStream) { return indexedStream.first == &stream; };
+      auto& streams = _streamsByType[stream.streamType()];
+      streams.erase(std::remove_if(streams.begin(), streams.end(), isStream), streams.end());
+
+      auto& streamsByItemId = _streamsByItemId[stream.streamType()];
+      auto it = std::find_if(streamsByItemId.begin(), streamsByItemId.end(),
+                             [&isStream](const auto& indexedStream) { return isStream(indexedStream.second); });
+      if (it != streamsByItemId.end())
+        streamsByItemId.erase(it);
+    }
+
   } // namespace detail
 
   namespace sqlite
   {
-    SqliteBackend::SqliteBackend(const std::string& databasePath)
-        : _storage(databasePath), _nextOperationId(1), _nextStreamId(1), _backendThread(), _quitBackendThread(false),
-          _workAvailableCondition(), _queueMutex(), _operationsQueue()
+    SqliteBackend::SqliteBackend(const std::string& databasePath, std::optional<int> archiveHorizonDays,
+                                 unsigned readerCount, bool mirrorInMemory)
+        : _storage(databasePath), _mirror(mirrorInMemory ? std::make_unique<SqliteMirror>() : nullptr),
+          _archiveHorizonDays(archiveHorizonDays), _nextOperationId(1), _nextStreamId(1),
+          _backendThread(), _quitBackendThread(false), _workAvailableCondition(), _queueMutex(), _operationsQueue()
     {
+      // Other connections to an in-memory database would open databases of their own
+      if (readerCount > 0 && databasePath != ":memory:")
+        _readers = std::make_unique<SqliteReaderPool>(databasePath, readerCount, [this]() {
+          std::lock_guard<std::mutex> lock(_queueMutex);
+          _workAvailableCondition.notify_one();
+        });
       start();
     }
 
@@ -305,63 +1325,119 @@ namespace persistence
 
     void SqliteBackend::removeStream(std::shared_ptr<DataStream> stream) { _dataStreams.removeStream(stream); }
 
+    void SqliteBackend::changeStreamOptions(std::shared_ptr<DataStream> stream, const nlohmann::json& options)
+    {
+      std::unique_lock<std::mutex> lock(_queueMutex);
+      _dataStreams.changeStreamOptions(stream, options);
+      lock.unlock();
+
+      _workAvailableCondition.notify_one();
+    }
+
     void SqliteBackend::threadMain()
     {
+      // Move archived reservations out of the planning before the first stream is initialized
+      std::optional<hotel::Day> archiveHorizon;
+      if (_archiveHorizonDays)
+        archiveHorizon = hotel::Day::fromDate(boost::gregorian::day_clock::local_day()) - *_archiveHorizonDays;
+      _storage.beginTransaction();
+      _storage.archiveReservations(archiveHorizon);
+      _storage.commitTransaction();
+      if (_mirror)
+        _mirror->load(_storage);
+
       while (!_quitBackendThread)
       {
         // Get the tasks we are going to process (This is the only part which is guarded by the mutex)
         std::unique_lock<std::mutex> lock(_queueMutex);
         std::vector<QueuedOperation> newTasks;
         std::swap(newTasks, _operationsQueue);
-        const bool hasUninitializedStreams = _dataStreams.hasUninitializedStreams();
+        const bool hasUninitializedStreams =
+            _dataStreams.hasUninitializedStreams() && (_readers == nullptr || _readers->hasIdleReader());
+        const bool hasPendingOptionChanges = _dataStreams.hasPendingOptionChanges();
+        const bool isInitializingStreams = _dataStreams.isInitializingStreams();
+        const bool hasNewStreams = _mirror != nullptr && _dataStreams.hasNewStreams();
         // Sleep until there is work to do
-        if (!_quitBackendThread && newTasks.empty() && !hasUninitializedStreams)
+        if (!_quitBackendThread && newTasks.empty() && !hasUninitializedStreams && !hasPendingOptionChanges &&
+            !isInitializingStreams && !hasNewStreams)
           _workAvailableCondition.wait(lock);
         lock.unlock();
 
-        // Initialize new data streams
-        _dataStreams.initialize(_changeQueue, _storage);
+        // Send the next chunk of the initial data of the streams and apply changed stream options
+        _dataStreams.initialize(_changeQueue, _storage, _readers.get(), _mirror.get());
+        _dataStreams.applyOptionChanges(_changeQueue, _storage);
 
-        // Process tasks
-        for (auto& operationsMessage : newTasks)
+        if (!newTasks.empty())
+          executeBatches(newTasks);
+      }
+    }
+
+    void SqliteBackend::executeBatches(std::vector<QueuedOperation>& batches)
+    {
+      // All batches are committed at once, so that a burst of small batches only has to be written to disk once. Each
+      // batch is executed in a savepoint of its own, so that a failed batch is rolled back without the others.
+      _storage.beginTransaction();
+      if (_mirror)
+        _mirror->beginTransaction();
+
+      std::vector<ChangeList> committedChanges;
+      std::vector<std::vector<TaskResult>> batchResults;
+      for (auto& batch : batches)
+      {
+        _storage.savepoint("batch");
+        if (_mirror)
+          _mirror->savepoint();
+        ChangeList transactionChanges;
+        std::vector<persistence::TaskResult> results;
+        bool rollback = false;
+        for (auto& operation : batch.first)
         {
-          _storage.beginTransaction();
-          ChangeList transactionChanges;
-          std::vector<persistence::TaskResult> results;
-          bool rollback = false;
-          for (auto& operation : operationsMessage.first)
+          auto result =
+              std::visit([this, &transactionChanges](
+                             auto& op) { return this->executeOperation(op, transactionChanges.streamChanges); },
+                         operation);
+          bool succeeded = result.status != TaskResultStatus::Error;
+          results.push_back(std::move(result));
+
+          if (!succeeded)
           {
-            auto result =
-                std::visit([this, &transactionChanges](
-                               auto& op) { return this->executeOperation(op, transactionChanges.streamChanges); },
-                           operation);
-            bool succeeded = result.status != TaskResultStatus::Error;
-            results.push_back(std::move(result));
-
-            if (!succeeded)
-            {
-              rollback = true;
-              break;
-            }
+            rollback = true;
+            break;
           }
+        }
 
-          if (rollback)
-          {
-            _storage.rollbackTransaction();
-          }
-          else
-          {
-            _storage.commitTransaction();
-            _changeQueue.addChanges(std::move(transactionChanges));
-          }
-          operationsMessage.second.resolve(std::move(results));
+        if (rollback)
+        {
+          _storage.rollbackToSavepoint("batch");
+          if (_mirror)
+            _mirror->rollbackToSavepoint();
+        }
+        else
+        {
+          _storage.releaseSavepoint("batch");
+          if (_mirror)
+            _mirror->releaseSavepoint();
+          committedChanges.push_back(std::move(transactionChanges));
         }
+        batchResults.push_back(std::move(results));
       }
+
+      _storage.commitTransaction();
+      if (_mirror)
+        _mirror->commitTransaction();
+
+      // Nothing may be observed before it has been committed
+      for (auto& changes : committedChanges)
+        _changeQueue.addChanges(std::move(changes));
+      for (std::size_t i = 0; i < batches.size(); ++i)
+        batches[i].second.resolve(std::move(batchResults[i]));
     }
 
     TaskResult SqliteBackend::executeOperation(op::EraseAllData&, std::vector<DataStreamDifferential>& streamChanges)
     {
       _storage.deleteAll();
+      if (_mirror)
+        _mirror->deleteAll();
 
       _dataStreams.clear(streamChanges, StreamableType::Reservation);
       _dataStreams.clear(streamChanges, StreamableType::Hotel);
@@ -384,6 +1460,8 @@ namespace persistence
     TaskResult SqliteBackend::executeStoreNew(hotel::Hotel& hotel, std::vector<DataStreamDifferential>& streamChanges)
     {
       _storage.storeNewHotel(hotel);
+      if (_mirror)
+        _mirror->storeNew(hotel);
       _dataStreams.addItems(streamChanges, StreamableType::Hotel, std::vector<hotel::Hotel>{{hotel}});
       return TaskResult{TaskResultStatus::Successful, {{"id", hotel.id()}}};
     }
@@ -392,6 +1470,8 @@ namespace persistence
                                               std::vector<DataStreamDifferential>& streamChanges)
     {
       _storage.storeNewReservationAndAtoms(reservation);
+      if (_mirror)
+        _mirror->storeNew(reservation);
       _dataStreams.addItems(streamChanges, StreamableType::Reservation, std::vector<hotel::Reservation>{{reservation}});
       return TaskResult{TaskResultStatus::Successful, {{"id", reservation.id()}}};
     }
@@ -406,6 +1486,10 @@ namespace persistence
 
     TaskResult SqliteBackend::executeOperation(op::Update& op, std::vector<DataStreamDifferential>& streamChanges)
     {
+      auto reservation = std::get_if<std::unique_ptr<hotel::Reservation>>(&op.updatedItem);
+      bool wasArchived =
+          reservation != nullptr && *reservation != nullptr && _storage.isReservationArchived((*reservation)->id());
+
       auto result = std::visit(
           [this](const auto& item) {
             if (item == nullptr)
@@ -422,6 +1506,18 @@ namespace persistence
       if (result.status == TaskResultStatus::Error)
         return result;
 
+      // A reservation which was moved into or out of the archive changes streams
+      if (reservation != nullptr && *reservation != nullptr &&
+          wasArchived != _storage.isReservationArchived((*reservation)->id()))
+      {
+        if (_mirror)
+          _mirror->update(**reservation);
+        _dataStreams.removeItems(streamChanges, StreamableType::Reservation, {(*reservation)->id()});
+        _dataStreams.addItems(streamChanges, StreamableType::Reservation,
+                              std::vector<hotel::Reservation>{{**reservation}});
+        return result;
+      }
+
       // TODO: This should be implementable using
       std::visit(
           [this, &streamChanges](const auto& updatedItem) { return this->executeUpdate(*updatedItem, streamChanges); },
@@ -432,12 +1528,16 @@ namespace persistence
 
     void SqliteBackend::executeUpdate(const hotel::Hotel& hotel, std::vector<DataStreamDifferential>& streamChanges)
     {
+      if (_mirror)
+        _mirror->update(hotel);
       _dataStreams.updateItems(streamChanges, StreamableType::Hotel, std::vector<hotel::Hotel>{{hotel}});
     }
 
     void SqliteBackend::executeUpdate(const hotel::Reservation& reservation,
                                       std::vector<DataStreamDifferential>& streamChanges)
     {
+      if (_mirror)
+        _mirror->update(reservation);
       _dataStreams.updateItems(streamChanges, StreamableType::Reservation,
                                std::vector<hotel::Reservation>{{reservation}});
     }
@@ -456,6 +1556,8 @@ namespace persistence
       if (op.type == persistence::op::StreamableType::Reservation)
       {
         _storage.deleteReservationById(op.id);
+        if (_mirror)
+          _mirror->deleteReservationById(op.id);
         _dataStreams.removeItems(streamChanges, StreamableType::Reservation, {op.id});
       }
       else
@@ -1,6 +1,8 @@
 #ifndef PERSISTENCE_SQLITE_SQLITEBACKEND_H
 #define PERSISTENCE_SQLITE_SQLITEBACKEND_H
 
+#include "persistence/sqlite/sqlitemirror.h"
+#include "persistence/sqlite/sqlitereaderpool.h"
 #include "persistence/sqlite/sqlitestorage.h"
 
 #include "persistence/backend.h"
@@ -18,11 +20,13 @@
 #include <atomic>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <condition_variable>
 #include <thread>
 #include <string>
 #include <queue>
 #include <functional>
+#include <unordered_map>
 
 namespace persistence
 {
@@ -34,10 +38,70 @@ namespace persistence
     public:
       virtual ~DataStreamHandler() = default;
       virtual void initialize(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue, sqlite::SqliteStorage& storage) = 0;
+
+      /**
+       * @brief Sends the next chunk of at most chunkSize items of the initial data of the stream
+       * @param lastId The id of the last item which has been sent so far, 0 at first. Is set to the last id sent.
+       * @return true once all of the initial data has been sent
+       *
+       * The default implementation sends all of the initial data at once, see initialize.
+       */
+      virtual bool initializeChunk(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                                   sqlite::SqliteStorage& storage, int& lastId, std::size_t chunkSize);
+
+      /**
+       * @brief Sends all of the initial data of the stream from the in-memory mirror, in chunks of at most chunkSize
+       * @return false if the mirror does not hold the data of the stream, in which case nothing is sent
+       *
+       * The default implementation returns false.
+       */
+      virtual bool initializeFromMirror(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                                        const sqlite::SqliteMirror& mirror, std::size_t chunkSize);
+
       virtual void addItems(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue, const StreamableItems& items) = 0;
       virtual void updateItems(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue, const StreamableItems& items) = 0;
       virtual void removeItems(DataStream& stream, std::vector<DataStreamDifferential>& ChangeQueue, const std::vector<int> ids) = 0;
       virtual void clear(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue) = 0;
+
+      /**
+       * @brief Returns the id of the only item the stream is interested in, if there is such an item
+       *
+       * Such streams are indexed by the id, so that they are only notified of the changes to their item. The default
+       * implementation returns std::nullopt, so that the stream is notified of all changes to items of its type.
+       */
+      virtual std::optional<int> itemId(const DataStream& stream) const;
+
+      /**
+       * @brief Called when the stream is added to or removed from the index of the DataStreamManager
+       *
+       * Streams are indexed when they become active, and are indexed again after their options have changed. Handlers
+       * can derive what they need from the options here, instead of on every change. The stream mutex of the manager
+       * is held, and unindexStream must not read the options. indexStream returns false if the stream cannot receive
+       * changes, e.g. because its options are invalid, and the stream is then left out of the index. The default
+       * implementations do nothing, and indexStream returns true.
+       */
+      virtual bool indexStream(const DataStream& stream);
+      virtual void unindexStream(const DataStream& stream);
+
+      /**
+       * @brief Called for each change of the initial data which has been sent to the stream
+       *
+       * Streams with the same initial data are only initialized once, the changes are then sent to each of them. This
+       * is called for each of the streams, on the thread initializing them, up to and including DataStreamInitialized.
+       * Handlers can follow which items the observer holds here. The default implementation does nothing.
+       */
+      virtual void initialChangeSent(const DataStream& stream, const DataStreamChange& change);
+
+      //! Called once an active stream has been removed, the default implementation does nothing
+      virtual void closeStream(const DataStream& stream);
+
+      /**
+       * @brief Replaces the options of an initialized stream and brings the observer up to date
+       *
+       * The default implementation clears the stream and initializes it again with the new options.
+       */
+      virtual void changeOptions(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                                 sqlite::SqliteStorage& storage, const nlohmann::json& options);
     };
 
     class DataStreamManager
@@ -55,11 +119,51 @@ namespace persistence
       void removeStream(const std::shared_ptr<DataStream>& stream);
 
       /**
-       * @brief Initializes all new streams
-       * This function has to be called after collectNewStreams()
+       * @brief Schedules a change of the options of the given stream
+       * @note changeStreamOptions must be synchronized!
+       * @see applyOptionChanges
+       */
+      void changeStreamOptions(const std::shared_ptr<DataStream>& stream, const nlohmann::json& options);
+
+      /**
+       * @brief Sends the initial data of the new streams
+       *
+       * With readers, each new stream is initialized on an idle reader, from a snapshot of the database taken during
+       * this call. The changes made after the snapshot are held back by the change queue until the snapshot has been
+       * sent. Streams for which no reader is idle are initialized by a later call.
+       *
+       * Without readers, each call sends the next chunk of the initial data of each stream which is still being
+       * initialized, so that the worker thread can execute pending operations between the chunks.
+       *
+       * With a mirror, the streams which it can serve are initialized from memory, all at once, before the other cases.
+       *
+       * In all cases, the initial data is sent in chunks of the size given by the stream option "chunk_size",
+       * defaultChunkSize by default. Streams which are waiting for the same initial data, i.e. streams of the same type
+       * with the same endpoint and options, share it: each chunk is only loaded once and its items are not copied.
+       *
        * @note initialize() can only be called on the worker thread!
        */
-      void initialize(ChangeQueue& changeQueue, sqlite::SqliteStorage& storage);
+      void initialize(ChangeQueue& changeQueue, sqlite::SqliteStorage& storage,
+                      sqlite::SqliteReaderPool* readers = nullptr, const sqlite::SqliteMirror* mirror = nullptr);
+
+      //! Returns true if some streams have not yet received all of their initial data
+      bool isInitializingStreams() const { return !_initializingStreams.empty(); }
+      /**
+       * @brief savedInitialLoads returns how many chunk loads identical streams have been spared, see initialize
+       *
+       * Every chunk of items which is loaded for one stream, from the storage or the mirror, and is then sent to n
+       * other identical streams as well counts as n saved loads. Chunks which turn out to be empty are not counted.
+       */
+      std::size_t savedInitialLoads() const { return _savedInitialLoads; }
+
+      static constexpr std::size_t defaultChunkSize = 1000;
+
+      /**
+       * @brief Applies all scheduled option changes
+       * This function has to be called after initialize(), so that the changed streams are active.
+       * @note applyOptionChanges() can only be called on the worker thread!
+       */
+      void applyOptionChanges(ChangeQueue& changeQueue, sqlite::SqliteStorage& storage);
 
       /**
        * @brief Calls func for each data stream in the active queue
@@ -70,26 +174,79 @@ namespace persistence
       template <class Func>
       void foreachStream(StreamableType type, Func func);
 
+      /**
+       * @brief Calls func for each active data stream of the type which is interested in some of the items
+       *
+       * Only the streams which are interested in all items of the type, and the streams indexed by one of the ids, are
+       * visited. See DataStreamHandler::itemId.
+       */
+      template <class Func>
+      void foreachStream(StreamableType type, const std::vector<int>& itemIds, Func func);
+
       bool hasUninitializedStreams() const
       {
         std::lock_guard<std::mutex> lock(_streamMutex);
         return !_uninitializedStreams.empty();
       }
 
+      //! Returns true if streams have been added since streams were last initialized from a mirror
+      bool hasNewStreams() const
+      {
+        std::lock_guard<std::mutex> lock(_streamMutex);
+        return _hasNewStreams;
+      }
+
+      bool hasPendingOptionChanges() const
+      {
+        std::lock_guard<std::mutex> lock(_streamMutex);
+        return !_pendingOptionChanges.empty();
+      }
+
       virtual void addItems(std::vector<DataStreamDifferential>& changeQueue, StreamableType type, const StreamableItems items);
       virtual void updateItems(std::vector<DataStreamDifferential>& changeQueue, StreamableType type, const StreamableItems items);
       virtual void removeItems(std::vector<DataStreamDifferential>& changeQueue, StreamableType type, std::vector<int> ids);
       virtual void clear(std::vector<DataStreamDifferential>& changeQueue, StreamableType type);
 
     private:
+      void initializeFromSnapshots(ChangeQueue& changeQueue, sqlite::SqliteReaderPool& readers);
+      void initializeFromMirror(ChangeQueue& changeQueue, const sqlite::SqliteMirror& mirror);
       DataStreamHandler* findHandler(const DataStream& stream);
+      //! Makes the stream active, the stream mutex has to be held
+      void activateStream(const std::shared_ptr<DataStream>& stream);
+      //! Adds the active stream to the index used for the fan-out of changes, the stream mutex has to be held
+      void indexStream(DataStream& stream);
+      //! Removes the stream from the index, the stream mutex has to be held
+      void unindexStream(const DataStream& stream);
+      /**
+       * @brief Returns the id of the last item sent to a stream which is still being initialized
+       *
+       * Changes to items after this id must not be sent, since these items will be part of a later chunk.
+       */
+      std::optional<int> initializedUpTo(const DataStream& stream) const;
 
       typedef std::tuple<StreamableType, std::string> HandlerKey;
       std::map<HandlerKey, std::unique_ptr<DataStreamHandler>> _streamHandlers;
 
       mutable std::mutex _streamMutex;
       std::vector<std::shared_ptr<DataStream>> _uninitializedStreams;
+      bool _hasNewStreams = false;
       std::vector<std::shared_ptr<DataStream>> _activeStreams;
+
+      // The active streams which have a handler, indexed by type and by the id of the item they are interested in. The
+      // handlers are resolved once, when the stream is indexed.
+      typedef std::pair<DataStream*, DataStreamHandler*> IndexedStream;
+      std::map<StreamableType, std::vector<IndexedStream>> _streamsByType;
+      std::map<StreamableType, std::unordered_multimap<int, IndexedStream>> _streamsByItemId;
+
+      std::vector<std::pair<std::shared_ptr<DataStream>, nlohmann::json>> _pendingOptionChanges;
+      // Streams which are being initialized by a reader, and the option changes which have to wait for them
+      std::vector<std::shared_ptr<DataStream>> _snapshotStreams;
+      std::vector<std::pair<std::shared_ptr<DataStream>, nlohmann::json>> _deferredOptionChanges;
+
+      // Streams which still receive their initial data, together with the last id sent. Only used by the worker thread.
+      std::vector<std::pair<std::shared_ptr<DataStream>, int>> _initializingStreams;
+      // Incremented by the readers as well
+      std::atomic<std::size_t> _savedInitialLoads{0};
     };
   }
 
@@ -99,11 +256,30 @@ namespace persistence
      * @brief The SqliteBackend class is the sqlite data backend for the application
      *
      * This particular backend will create its own worker thread, on which all data operations will be executed.
+     *
+     * New streams are initialized concurrently by a pool of readerCount read only connections, so that neither writes
+     * nor other streams have to wait for them. Without readers, streams are initialized on the worker thread.
+     *
+     * If mirrorInMemory is set, the hotels and the planning are also kept in memory (see SqliteMirror), and the streams
+     * of hotels and of the planning, including the "by_id" streams, are initialized from there. The mirror is only
+     * correct as long as the backend is the only writer to the database.
+     *
+     * When the backend starts, archived reservations are moved out of the planning (see
+     * SqliteStorage::archiveReservations). If archiveHorizonDays is given, reservations which ended at least that many
+     * days ago are archived as well. Archived reservations are not part of the default reservation stream, they are
+     * only available through the "reservation.archived" endpoint, which takes the options {"from": ..., "to": ...} as
+     * ISO dates and streams the archived reservations intersecting that range.
+     *
+     * Views which only show a few months should use the "reservation.by_period" endpoint instead of the default
+     * reservation stream. It takes the same options, optionally restricted to the rooms listed in "rooms", and only
+     * streams the reservations which have a night in that window. The window can be moved with
+     * UniqueDataStreamHandle::changeOptions.
      */
     class SqliteBackend final : public Backend
     {
     public:
-      SqliteBackend(const std::string& databasePath);
+      SqliteBackend(const std::string& databasePath, std::optional<int> archiveHorizonDays = std::nullopt,
+                    unsigned readerCount = 4, bool mirrorInMemory = false);
       virtual ~SqliteBackend();
 
       virtual fas::Future<std::vector<TaskResult>> queueOperations(op::Operations operations) override;
@@ -114,13 +290,22 @@ namespace persistence
 
       ChangeQueue& changeQueue() override { return _changeQueue; }
 
+      //! Returns how many chunk loads identical streams have been spared, see DataStreamManager::savedInitialLoads
+      std::size_t savedInitialLoads() const { return _dataStreams.savedInitialLoads(); }
+
     protected:
       virtual void removeStream(std::shared_ptr<persistence::DataStream> stream) override;
+      virtual void changeStreamOptions(std::shared_ptr<persistence::DataStream> stream,
+                                       const nlohmann::json& options) override;
 
     private:
+      typedef std::pair<op::Operations, fas::Promise<std::vector<TaskResult>>> QueuedOperation;
+
       void start();
       void stopAndJoin();
       void threadMain();
+      //! Executes all batches of operations in one transaction, and rolls back the failed batches
+      void executeBatches(std::vector<QueuedOperation>& batches);
 
       TaskResult executeOperation(op::EraseAllData&, std::vector<DataStreamDifferential>& streamChanges);
       TaskResult executeOperation(op::StoreNew& op, std::vector<DataStreamDifferential>& streamChanges);
@@ -136,6 +321,9 @@ namespace persistence
       void executeUpdate(const hotel::Person& person, std::vector<DataStreamDifferential>& streamChanges);
 
       SqliteStorage _storage;
+      // Only used by the worker thread
+      std::unique_ptr<SqliteMirror> _mirror;
+      std::optional<int> _archiveHorizonDays;
       ChangeQueue _changeQueue;
 
       int _nextOperationId;
@@ -146,10 +334,12 @@ namespace persistence
       std::condition_variable _workAvailableCondition;
 
       std::mutex _queueMutex;
-      typedef std::pair<op::Operations, fas::Promise<std::vector<TaskResult>>> QueuedOperation;
       std::vector<QueuedOperation> _operationsQueue;
 
       detail::DataStreamManager _dataStreams;
+
+      // Declared last, so that the running jobs, which use the members above, finish first
+      std::unique_ptr<SqliteReaderPool> _readers;
     };
 
   } // namespace sqlite
@@ -0,0 +1,183 @@
+#include "persistence/sqlite/sqlitemirror.h"
+
+namespace persistence
+{
+  namespace sqlite
+  {
+    namespace
+    {
+      template <typename T>
+      std::optional<T> findById(const std::map<int, T>& items, int id)
+      {
+        auto it = items.find(id);
+        return it != items.end() ? std::optional<T>(it->second) : std::nullopt;
+      }
+
+      template <typename T>
+      std::vector<T> chunk(const std::map<int, T>& items, int afterId, std::size_t count)
+      {
+        std::vector<T> result;
+        for (auto it = items.upper_bound(afterId); it != items.end() && result.size() < count; ++it)
+          result.push_back(it->second);
+        return result;
+      }
+
+      template <typename T>
+      void restoreItems(std::map<int, T>& items, std::map<int, std::optional<T>>& previousItems)
+      {
+        for (auto& [id, previousItem] : previousItems)
+        {
+          if (previousItem)
+            items.insert_or_assign(id, std::move(*previousItem));
+          else
+            items.erase(id);
+        }
+      }
+    } // namespace
+
+    void SqliteMirror::rememberHotel(int id)
+    {
+      // Only the innermost savepoint has to remember the item, see releaseSavepoint
+      if (!_previousItems.empty() && _previousItems.back().hotels.count(id) == 0)
+        _previousItems.back().hotels.emplace(id, findById(_hotels, id));
+    }
+
+    void SqliteMirror::rememberReservation(int id)
+    {
+      if (!_previousItems.empty() && _previousItems.back().reservations.count(id) == 0)
+        _previousItems.back().reservations.emplace(id, findById(_reservations, id));
+    }
+
+    void SqliteMirror::restore(PreviousItems& previousItems)
+    {
+      restoreItems(_hotels, previousItems.hotels);
+      restoreItems(_reservations, previousItems.reservations);
+    }
+
+    void SqliteMirror::load(SqliteStorage& storage)
+    {
+      _hotels.clear();
+      _reservations.clear();
+      for (auto& hotel : storage.loadAll<hotel::Hotel>())
+      {
+        auto id = hotel.id();
+        _hotels.emplace(id, std::move(hotel));
+      }
+      for (auto& reservation : storage.loadAll<hotel::Reservation>())
+      {
+        auto id = reservation.id();
+        _reservations.emplace(id, std::move(reservation));
+      }
+    }
+
+    template <>
+    std::optional<hotel::Hotel> SqliteMirror::loadById(int id) const
+    {
+      return findById(_hotels, id);
+    }
+
+    template <>
+    std::optional<hotel::Reservation> SqliteMirror::loadById(int id) const
+    {
+      return findById(_reservations, id);
+    }
+
+    template <>
+    std::vector<hotel::Hotel> SqliteMirror::loadChunk(int afterId, std::size_t count) const
+    {
+      return chunk(_hotels, afterId, count);
+    }
+
+    template <>
+    std::vector<hotel::Reservation> SqliteMirror::loadChunk(int afterId, std::size_t count) const
+    {
+      return chunk(_reservations, afterId, count);
+    }
+
+    void SqliteMirror::storeNew(const hotel::Hotel& hotel)
+    {
+      rememberHotel(hotel.id());
+      _hotels.insert_or_assign(hotel.id(), hotel);
+    }
+
+    void SqliteMirror::storeNew(const hotel::Reservation& reservation)
+    {
+      if (reservation.status() == hotel::Reservation::Archived)
+        return;
+      rememberReservation(reservation.id());
+      _reservations.insert_or_assign(reservation.id(), reservation);
+    }
+
+    void SqliteMirror::update(const hotel::Hotel& hotel)
+    {
+      auto it = _hotels.find(hotel.id());
+      if (it == _hotels.end())
+        return;
+      rememberHotel(hotel.id());
+      it->second.setName(hotel.name());
+      it->second.setRevision(hotel.revision());
+    }
+
+    void SqliteMirror::update(const hotel::Reservation& reservation)
+    {
+      rememberReservation(reservation.id());
+      if (reservation.status() == hotel::Reservation::Archived)
+        _reservations.erase(reservation.id());
+      else
+        _reservations.insert_or_assign(reservation.id(), reservation);
+    }
+
+    void SqliteMirror::deleteReservationById(int id)
+    {
+      rememberReservation(id);
+      _reservations.erase(id);
+    }
+
+    void SqliteMirror::deleteAll()
+    {
+      for (auto& item : _hotels)
+        rememberHotel(item.first);
+      for (auto& item : _reservations)
+        rememberReservation(item.first);
+      _hotels.clear();
+      _reservations.clear();
+    }
+
+    void SqliteMirror::beginTransaction() { _previousItems.assign(1, PreviousItems()); }
+
+    void SqliteMirror::commitTransaction() { _previousItems.clear(); }
+
+    void SqliteMirror::rollbackTransaction()
+    {
+      for (auto it = _previousItems.rbegin(); it != _previousItems.rend(); ++it)
+        restore(*it);
+      _previousItems.clear();
+    }
+
+    void SqliteMirror::savepoint()
+    {
+      if (!_previousItems.empty())
+        _previousItems.emplace_back();
+    }
+
+    void SqliteMirror::releaseSavepoint()
+    {
+      if (_previousItems.size() < 2)
+        return;
+      // Items which the enclosing level already remembers keep their older state
+      auto released = std::move(_previousItems.back());
+      _previousItems.pop_back();
+      _previousItems.back().hotels.merge(released.hotels);
+      _previousItems.back().reservations.merge(released.reservations);
+    }
+
+    void SqliteMirror::rollbackToSavepoint()
+    {
+      if (_previousItems.size() < 2)
+        return;
+      restore(_previousItems.back());
+      _previousItems.pop_back();
+    }
+
+  } // namespace sqlite
+} // namespace persistence
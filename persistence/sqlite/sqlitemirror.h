@@ -0,0 +1,86 @@
+#ifndef PERSISTENCE_SQLITE_SQLITEMIRROR_H
+#define PERSISTENCE_SQLITE_SQLITEMIRROR_H
+
+#include "persistence/sqlite/sqlitestorage.h"
+
+#include "hotel/hotel.h"
+#include "hotel/reservation.h"
+
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace persistence
+{
+  namespace sqlite
+  {
+    /**
+     * @brief The SqliteMirror class holds a copy of the hotels and of the planning of a SqliteStorage in memory
+     *
+     * The mirror is loaded once, and is then written to along with the storage, so it only stays in sync as long as
+     * there is no other writer. Archived reservations are not mirrored, just as they are not part of the planning.
+     *
+     * Writes which are made between beginTransaction and rollbackTransaction are undone, like those to the storage. The
+     * same goes for savepoints within a transaction, see SqliteStorage::savepoint.
+     */
+    class SqliteMirror
+    {
+    public:
+      //! Replaces the contents of the mirror with the hotels and the planning in the storage
+      void load(SqliteStorage& storage);
+
+      template <typename T>
+      std::optional<T> loadById(int id) const;
+
+      //! Returns up to count items with an id greater than afterId, sorted by id, see SqliteStorage::loadChunk
+      template <typename T>
+      std::vector<T> loadChunk(int afterId, std::size_t count) const;
+
+      void storeNew(const hotel::Hotel& hotel);
+      //! Stores a new reservation, which is ignored if it is archived
+      void storeNew(const hotel::Reservation& reservation);
+      //! Updates the name and the revision of the hotel, which is all that SqliteStorage::update stores of a hotel
+      void update(const hotel::Hotel& hotel);
+      //! Updates the reservation, which leaves the mirror if it is archived and enters it if it is no longer archived
+      void update(const hotel::Reservation& reservation);
+      void deleteReservationById(int id);
+      void deleteAll();
+
+      void beginTransaction();
+      void commitTransaction();
+      void rollbackTransaction();
+
+      void savepoint();
+      void releaseSavepoint();
+      //! Undoes all writes since the last savepoint, and releases it
+      void rollbackToSavepoint();
+
+    private:
+      /**
+       * @brief The PreviousItems struct holds the state of the items written since the transaction or savepoint began
+       *
+       * Items which did not exist are mapped to std::nullopt.
+       */
+      struct PreviousItems
+      {
+        std::map<int, std::optional<hotel::Hotel>> hotels;
+        std::map<int, std::optional<hotel::Reservation>> reservations;
+      };
+
+      //! Remember the current state of the item, so that it can be restored if the transaction is rolled back
+      void rememberHotel(int id);
+      void rememberReservation(int id);
+      void restore(PreviousItems& previousItems);
+
+      std::map<int, hotel::Hotel> _hotels;
+      std::map<int, hotel::Reservation> _reservations;
+
+      // One entry for the transaction, and one for each savepoint. Empty outside of transactions.
+      std::vector<PreviousItems> _previousItems;
+    };
+
+  } // namespace sqlite
+} // namespace persistence
+
+#endif // PERSISTENCE_SQLITE_SQLITEMIRROR_H
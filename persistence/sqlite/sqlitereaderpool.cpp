@@ -0,0 +1,85 @@
+#include "persistence/sqlite/sqlitereaderpool.h"
+
+#include <algorithm>
+
+namespace persistence
+{
+  namespace sqlite
+  {
+    SqliteReaderPool::SqliteReaderPool(const std::string& databasePath, unsigned readerCount,
+                                       std::function<void()> readerAvailable)
+        : _readerAvailable(std::move(readerAvailable))
+    {
+      for (unsigned i = 0; i < readerCount; ++i)
+      {
+        _readers.push_back(std::make_unique<Reader>());
+        _readers.back()->storage = std::make_unique<SqliteStorage>(databasePath, SqliteStorage::OpenMode::ReadOnly);
+      }
+      for (auto& reader : _readers)
+        reader->thread = std::thread([this, readerPtr = reader.get()]() { threadMain(*readerPtr); });
+    }
+
+    SqliteReaderPool::~SqliteReaderPool()
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _quitFlag = true;
+      lock.unlock();
+      _jobAvailable.notify_all();
+
+      for (auto& reader : _readers)
+        reader->thread.join();
+    }
+
+    bool SqliteReaderPool::hasIdleReader() const
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return std::any_of(_readers.begin(), _readers.end(), [](auto& reader) { return !reader->isBusy; });
+    }
+
+    bool SqliteReaderPool::tryRun(Job job)
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      auto it = std::find_if(_readers.begin(), _readers.end(), [](auto& reader) { return !reader->isBusy; });
+      if (it == _readers.end())
+        return false;
+      auto& reader = **it;
+      reader.isBusy = true;
+      lock.unlock();
+
+      // The snapshot of a read transaction is only taken by its first read. The reader thread does not touch the
+      // storage until it has a job, so this can safely be done on the calling thread.
+      reader.storage->beginTransaction();
+      reader.storage->schemaVersion();
+
+      lock.lock();
+      reader.job = std::move(job);
+      lock.unlock();
+      _jobAvailable.notify_all();
+      return true;
+    }
+
+    void SqliteReaderPool::threadMain(Reader& reader)
+    {
+      while (true)
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _jobAvailable.wait(lock, [this, &reader]() { return _quitFlag || reader.job != nullptr; });
+        if (reader.job == nullptr)
+          return;
+        auto job = std::move(reader.job);
+        reader.job = nullptr;
+        lock.unlock();
+
+        job(*reader.storage);
+        reader.storage->commitTransaction();
+
+        lock.lock();
+        reader.isBusy = false;
+        lock.unlock();
+        if (_readerAvailable)
+          _readerAvailable();
+      }
+    }
+
+  } // namespace sqlite
+} // namespace persistence
@@ -0,0 +1,71 @@
+#ifndef PERSISTENCE_SQLITE_SQLITEREADERPOOL_H
+#define PERSISTENCE_SQLITE_SQLITEREADERPOOL_H
+
+#include "persistence/sqlite/sqlitestorage.h"
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace persistence
+{
+  namespace sqlite
+  {
+    /**
+     * @brief The SqliteReaderPool class holds read only connections to a database, each served by a thread of its own
+     *
+     * The database has to be in WAL mode (see SqliteStorage), so that every reader sees a consistent snapshot of the
+     * database while it is being written to. The snapshot of a job is taken when the job is started with tryRun, not
+     * when the reader thread gets to run it. This way, the writer knows exactly which of its changes are part of the
+     * snapshot.
+     */
+    class SqliteReaderPool
+    {
+    public:
+      typedef std::function<void(SqliteStorage&)> Job;
+
+      /**
+       * @param readerAvailable Is called from the reader thread whenever a reader has finished its job
+       */
+      SqliteReaderPool(const std::string& databasePath, unsigned readerCount, std::function<void()> readerAvailable);
+      SqliteReaderPool(const SqliteReaderPool& that) = delete;
+      SqliteReaderPool& operator=(const SqliteReaderPool& that) = delete;
+      //! Waits for the running jobs to finish
+      ~SqliteReaderPool();
+
+      unsigned readerCount() const { return static_cast<unsigned>(_readers.size()); }
+      bool hasIdleReader() const;
+
+      /**
+       * @brief Takes a snapshot of the database on an idle reader, and runs the job on it in the reader thread
+       * @return false if all readers are busy, in which case the job is not run
+       */
+      bool tryRun(Job job);
+
+    private:
+      struct Reader
+      {
+        std::unique_ptr<SqliteStorage> storage;
+        Job job;
+        bool isBusy = false;
+        std::thread thread;
+      };
+
+      void threadMain(Reader& reader);
+
+      std::vector<std::unique_ptr<Reader>> _readers;
+      std::function<void()> _readerAvailable;
+
+      mutable std::mutex _mutex;
+      std::condition_variable _jobAvailable;
+      bool _quitFlag = false;
+    };
+
+  } // namespace sqlite
+} // namespace persistence
+
+#endif // PERSISTENCE_SQLITE_SQLITEREADERPOOL_H
@@ -69,6 +69,8 @@ namespace persistence
       bindArgument(pos, boost::gregorian::to_iso_string(date));
     }
 
+    void SqliteStatement::bindArgument(int pos, hotel::Day day) { sqlite3_bind_int64(_statement, pos, day.number()); }
+
     void SqliteStatement::readArg(int pos, std::string& val)
     {
       auto text = (const char*)sqlite3_column_text(_statement, pos);
@@ -85,5 +87,12 @@ namespace persistence
       date = boost::gregorian::from_undelimited_string(val);
     }
 
+    void SqliteStatement::readArg(int pos, hotel::Day& day)
+    {
+      if (sqlite3_column_type(_statement, pos) != SQLITE_INTEGER)
+        throw std::runtime_error("Cannot read day from column " + std::to_string(pos));
+      day = hotel::Day(sqlite3_column_int(_statement, pos));
+    }
+
   } // namespace sqlite
 } // namespace persistence
@@ -1,6 +1,8 @@
 #ifndef PERSISTENCE_SQLITE_SQLITESTATEMENT_H
 #define PERSISTENCE_SQLITE_SQLITESTATEMENT_H
 
+#include "hotel/day.h"
+
 #include <boost/date_time.hpp>
 #include <sqlite3.h>
 
@@ -66,10 +68,12 @@ namespace persistence
       void bindArgument(int pos, const std::string& text);
       void bindArgument(int pos, int64_t value);
       void bindArgument(int pos, boost::gregorian::date date);
+      void bindArgument(int pos, hotel::Day day);
 
       void readArg(int pos, std::string& val);
       void readArg(int pos, int& val);
       void readArg(int pos, boost::gregorian::date& date);
+      void readArg(int pos, hotel::Day& day);
 
       template <int Pos> void readRowInternal() {}
       template <int Pos = 0, typename T, typename... Args> void readRowInternal(T& val, Args&... others)
@@ -2,6 +2,7 @@
 
 #include "hotel/person.h"
 
+#include <algorithm>
 #include <iostream>
 
 namespace persistence
@@ -11,10 +12,149 @@ namespace persistence
 
     namespace
     {
-      void executeSQL(sqlite3* db, const std::string& sql)
+      //! The reservations to move between the planning and the archive are marked in a table of each connection
+      const char* createMarkedReservationTable =
+          "CREATE TEMP TABLE IF NOT EXISTS t_marked_reservation (id INTEGER NOT NULL PRIMARY KEY);";
+
+      bool executeSQL(sqlite3* db, const std::string& sql)
+      {
+        char* error = nullptr;
+        if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &error) == SQLITE_OK)
+          return true;
+
+        std::cerr << "Cannot execute query: " << sql << ": " << (error ? error : "") << std::endl;
+        sqlite3_free(error);
+        return false;
+      }
+
+      //! Converts a YYYYMMDD text column to the day number of hotel::Day, i.e. the number of days since 1970-01-01
+      std::string textToDayNumber(const std::string& column)
+      {
+        return "CAST(julianday(substr(" + column + ", 1, 4) || '-' || substr(" + column + ", 5, 2) || '-' || substr(" +
+               column + ", 7, 2)) - julianday('1970-01-01') AS INTEGER)";
+      }
+
+      //! Rebuilds an atom table with the dates stored as day numbers, since the type of a column cannot be changed
+      std::string convertAtomDates(const std::string& table, const std::string& idColumn)
+      {
+        return "CREATE TABLE " + table + "_v2 (" + idColumn + ", "
+               "reservation_id INTEGER NOT NULL," // Foreign key
+               "room_id INTEGER NOT NULL,"        // Foreign key
+               "date_from INTEGER NOT NULL,"
+               "date_to INTEGER NOT NULL);"
+               "INSERT INTO " + table + "_v2 (id, reservation_id, room_id, date_from, date_to) "
+               "SELECT id, reservation_id, room_id, " + textToDayNumber("date_from") + ", " +
+               textToDayNumber("date_to") + " FROM " + table + ";"
+               "DROP TABLE " + table + ";"
+               "ALTER TABLE " + table + "_v2 RENAME TO " + table + ";";
+      }
+
+      /**
+       * @brief schemaMigrations returns the SQL scripts which upgrade the schema, one per version
+       *
+       * The script at index i upgrades the schema from version i to version i + 1. Released scripts must never be
+       * changed, the schema is changed by appending a new script.
+       */
+      const std::vector<std::string>& schemaMigrations()
       {
-        if (!SqliteStatement(db, sql).execute())
-          std::cerr << "Cannot execute query: " << sql;
+        static const std::vector<std::string> migrations = {
+            // Version 1: The schema before it was versioned, with dates stored as YYYYMMDD text. Databases without a
+            // version are at this version, or are empty, which is why the tables are only created if they are missing.
+            "CREATE TABLE IF NOT EXISTS h_hotel ("
+            "id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+            "revision INTEGER NOT NULL DEFAULT 1, "
+            "name TEXT NOT NULL);"
+            "CREATE TABLE IF NOT EXISTS h_room_category ("
+            "id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+            "hotel_id INTEGER NOT NULL," // Foreign key
+            "short_code TEXT NOT NULL,"
+            "name TEXT NOT NULL);"
+            "CREATE TABLE IF NOT EXISTS h_room ("
+            "id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+            "hotel_id INTEGER NOT NULL,"    // Foreign key
+            "category_id INTEGER NOT NULL," // Foreign key
+            "name TEXT NOT NULL);"
+            "CREATE TABLE IF NOT EXISTS h_reservation ("
+            "id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+            "revision INTEGER NOT NULL DEFAULT 1, "
+            "description TEXT NOT NULL, "
+            "status TEXT NOT NULL,"
+            "adults INTEGER NOT NULL,"
+            "children INTEGER NOT NULL);"
+            "CREATE TABLE IF NOT EXISTS h_reservation_atom ("
+            "id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+            "reservation_id INTEGER NOT NULL," // Foreign key
+            "room_id INTEGER NOT NULL,"        // Foreign key
+            "date_from TEXT NOT NULL,"
+            "date_to TEXT NOT NULL);"
+            // Archived reservations are moved to separate tables, keeping their ids
+            "CREATE TABLE IF NOT EXISTS h_reservation_archive ("
+            "id INTEGER NOT NULL PRIMARY KEY, "
+            "revision INTEGER NOT NULL DEFAULT 1, "
+            "description TEXT NOT NULL, "
+            "status TEXT NOT NULL,"
+            "adults INTEGER NOT NULL,"
+            "children INTEGER NOT NULL);"
+            "CREATE TABLE IF NOT EXISTS h_reservation_atom_archive ("
+            "id INTEGER NOT NULL PRIMARY KEY, "
+            "reservation_id INTEGER NOT NULL," // Foreign key
+            "room_id INTEGER NOT NULL,"        // Foreign key
+            "date_from TEXT NOT NULL,"
+            "date_to TEXT NOT NULL);"
+            "CREATE INDEX IF NOT EXISTS h_reservation_atom_archive_date_from "
+            "ON h_reservation_atom_archive (date_from);"
+            "CREATE INDEX IF NOT EXISTS h_reservation_atom_archive_reservation_id "
+            "ON h_reservation_atom_archive (reservation_id);",
+
+            // Version 2: Dates are stored as day numbers, and the foreign keys are indexed. The AUTOINCREMENT counter of
+            // the atoms is carried over, so that the ids of deleted or archived atoms are not handed out again.
+            "CREATE TEMP TABLE t_sequence AS SELECT name, seq FROM sqlite_sequence;" +
+                convertAtomDates("h_reservation_atom", "id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT") +
+                "DELETE FROM sqlite_sequence WHERE name = 'h_reservation_atom';"
+                "INSERT INTO sqlite_sequence (name, seq) SELECT name, seq FROM t_sequence "
+                "WHERE name = 'h_reservation_atom';"
+                "DROP TABLE t_sequence;" +
+                convertAtomDates("h_reservation_atom_archive", "id INTEGER NOT NULL PRIMARY KEY") +
+                "CREATE INDEX h_reservation_atom_reservation_id ON h_reservation_atom (reservation_id, date_from);"
+                "CREATE INDEX h_reservation_atom_room_id ON h_reservation_atom (room_id, date_from, date_to);"
+                "CREATE INDEX h_reservation_atom_archive_reservation_id "
+                "ON h_reservation_atom_archive (reservation_id, date_from);"
+                "CREATE INDEX h_reservation_atom_archive_date_from ON h_reservation_atom_archive (date_from);"
+                "CREATE INDEX h_room_hotel_id ON h_room (hotel_id);"
+                "CREATE INDEX h_room_category_hotel_id ON h_room_category (hotel_id);",
+
+            // Version 3: An R*Tree over the rooms and dates of the atoms, for queries by period. The triggers keep it
+            // consistent with h_reservation_atom within the same transaction, including when atoms are archived.
+            "CREATE VIRTUAL TABLE h_reservation_atom_rtree USING rtree_i32(id, room_from, room_to, date_from, date_to);"
+            "INSERT INTO h_reservation_atom_rtree (id, room_from, room_to, date_from, date_to) "
+            "SELECT id, room_id, room_id, date_from, date_to FROM h_reservation_atom;"
+            "CREATE TRIGGER h_reservation_atom_rtree_insert AFTER INSERT ON h_reservation_atom BEGIN "
+            "INSERT INTO h_reservation_atom_rtree (id, room_from, room_to, date_from, date_to) "
+            "VALUES (new.id, new.room_id, new.room_id, new.date_from, new.date_to); END;"
+            "CREATE TRIGGER h_reservation_atom_rtree_update AFTER UPDATE ON h_reservation_atom BEGIN "
+            "DELETE FROM h_reservation_atom_rtree WHERE id = old.id;"
+            "INSERT INTO h_reservation_atom_rtree (id, room_from, room_to, date_from, date_to) "
+            "VALUES (new.id, new.room_id, new.room_id, new.date_from, new.date_to); END;"
+            "CREATE TRIGGER h_reservation_atom_rtree_delete AFTER DELETE ON h_reservation_atom BEGIN "
+            "DELETE FROM h_reservation_atom_rtree WHERE id = old.id; END;",
+
+            // Version 4: The same R*Tree over the archived atoms. Queries by period would otherwise only be able to use
+            // the index on date_from, and scan all of the archive before the end of the period.
+            "CREATE VIRTUAL TABLE h_reservation_atom_archive_rtree USING rtree_i32(id, room_from, room_to, date_from, "
+            "date_to);"
+            "INSERT INTO h_reservation_atom_archive_rtree (id, room_from, room_to, date_from, date_to) "
+            "SELECT id, room_id, room_id, date_from, date_to FROM h_reservation_atom_archive;"
+            "CREATE TRIGGER h_reservation_atom_archive_rtree_insert AFTER INSERT ON h_reservation_atom_archive BEGIN "
+            "INSERT INTO h_reservation_atom_archive_rtree (id, room_from, room_to, date_from, date_to) "
+            "VALUES (new.id, new.room_id, new.room_id, new.date_from, new.date_to); END;"
+            "CREATE TRIGGER h_reservation_atom_archive_rtree_update AFTER UPDATE ON h_reservation_atom_archive BEGIN "
+            "DELETE FROM h_reservation_atom_archive_rtree WHERE id = old.id;"
+            "INSERT INTO h_reservation_atom_archive_rtree (id, room_from, room_to, date_from, date_to) "
+            "VALUES (new.id, new.room_id, new.room_id, new.date_from, new.date_to); END;"
+            "CREATE TRIGGER h_reservation_atom_archive_rtree_delete AFTER DELETE ON h_reservation_atom_archive BEGIN "
+            "DELETE FROM h_reservation_atom_archive_rtree WHERE id = old.id; END;",
+        };
+        return migrations;
       }
 
       std::string serializeReservationStatus(hotel::Reservation::ReservationStatus status)
@@ -62,11 +202,74 @@ namespace persistence
         std::cerr << "Unknown reservation status: " << str;
         return Status::Unknown;
       }
+
+      //! Reads the rows of a query returning reservations joined with their atoms, ordered by reservation and date
+      std::vector<hotel::Reservation> readReservations(SqliteStatement& reservationsQuery)
+      {
+        std::vector<hotel::Reservation> result;
+        std::unique_ptr<hotel::Reservation> current = nullptr;
+        while (reservationsQuery.hasResultRow())
+        {
+          int reservationId;
+          int reservationRevision;
+          std::string description;
+          std::string reservationStatus;
+          int adults;
+          int children;
+          int atomId;
+          int roomId;
+          hotel::Day dateFrom;
+          hotel::Day dateTo;
+          reservationsQuery.readRow(reservationId, reservationRevision, description, reservationStatus, adults,
+                                    children, atomId, roomId, dateFrom, dateTo);
+
+          if (current == nullptr || current->id() != reservationId)
+          {
+            if (current)
+            {
+              result.push_back(std::move(*current));
+              current = nullptr;
+            }
+            current = std::make_unique<hotel::Reservation>(description, roomId, hotel::DayRange(dateFrom, dateTo));
+            current->setId(reservationId);
+            current->setRevision(reservationRevision);
+            current->setStatus(parseReservationStatus(reservationStatus));
+            current->setNumberOfAdults(adults);
+            current->setNumberOfChildren(children);
+          }
+          else
+          {
+            current->addContinuation(roomId, dateTo);
+          }
+          (*current->atoms().rbegin()).setId(atomId);
+        }
+        if (current)
+          result.push_back(std::move(*current));
+
+        return result;
+      }
+
+      //! Reads the rows of a query returning reservation id, atom id, room id and dates of atoms
+      std::vector<hotel::AtomRecord> readAtomRecords(SqliteStatement& atomsQuery)
+      {
+        std::vector<hotel::AtomRecord> result;
+        while (atomsQuery.hasResultRow())
+        {
+          hotel::AtomRecord atom;
+          hotel::Day dateFrom;
+          hotel::Day dateTo;
+          atomsQuery.readRow(atom.reservationId, atom.atomId, atom.roomId, dateFrom, dateTo);
+          atom.dayRange = hotel::DayRange(dateFrom, dateTo);
+          result.push_back(atom);
+        }
+        return result;
+      }
     }
 
-    SqliteStorage::SqliteStorage(const std::string& file) : _db(nullptr)
+    SqliteStorage::SqliteStorage(const std::string& file, OpenMode mode) : _db(nullptr)
     {
-      if (sqlite3_open(file.c_str(), &_db))
+      auto flags = mode == OpenMode::ReadOnly ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+      if (sqlite3_open_v2(file.c_str(), &_db, flags, nullptr))
       {
         std::cerr << "Cannot open sqlite database: " << file << std::endl;
         sqlite3_close(_db);
@@ -75,12 +278,26 @@ namespace persistence
 
       if (_db != nullptr)
       {
-        createSchema();
+        if (mode == OpenMode::ReadWrite)
+        {
+          // With a write-ahead log, readers on other connections see a consistent snapshot while the database is written
+          executeSQL(_db, "PRAGMA journal_mode=WAL;");
+          createSchema();
+        }
+        else
+        {
+          executeSQL(_db, createMarkedReservationTable);
+        }
         prepareQueries();
       }
     }
 
-    SqliteStorage::~SqliteStorage() { sqlite3_close(_db); }
+    SqliteStorage::~SqliteStorage()
+    {
+      // The connection cannot be closed while it still has prepared statements
+      _statements.clear();
+      sqlite3_close(_db);
+    }
 
     void SqliteStorage::deleteAll()
     {
@@ -88,11 +305,16 @@ namespace persistence
         return;
 
       _statements.clear();
+      executeSQL(_db, "DROP TABLE IF EXISTS h_reservation_atom_archive_rtree;");
+      executeSQL(_db, "DROP TABLE IF EXISTS h_reservation_atom_archive;");
+      executeSQL(_db, "DROP TABLE IF EXISTS h_reservation_archive;");
+      executeSQL(_db, "DROP TABLE IF EXISTS h_reservation_atom_rtree;");
       executeSQL(_db, "DROP TABLE IF EXISTS h_reservation_atom;");
       executeSQL(_db, "DROP TABLE IF EXISTS h_reservation;");
       executeSQL(_db, "DROP TABLE IF EXISTS h_room;");
       executeSQL(_db, "DROP TABLE IF EXISTS h_room_category;");
       executeSQL(_db, "DROP TABLE IF EXISTS h_hotel;");
+      executeSQL(_db, "DROP TABLE IF EXISTS h_schema_version;");
 
       createSchema();
       prepareQueries();
@@ -100,18 +322,34 @@ namespace persistence
 
     void SqliteStorage::deleteReservationById(int id)
     {
-      query("reservation.delete").execute(id, id);
+      query("reservation.delete_atoms").execute(id);
+      query("reservation.delete").execute(id);
+      query("reservation_atom_archive.delete").execute(id);
+      query("reservation_archive.delete").execute(id);
     }
 
 
     template<>
     std::vector<hotel::Hotel> SqliteStorage::loadAll()
+    {
+      auto& hotelsQuery = query("hotel.all");
+      hotelsQuery.execute();
+      return readHotels(hotelsQuery);
+    }
+
+    template<>
+    std::vector<hotel::Hotel> SqliteStorage::loadChunk(int afterId, std::size_t count)
+    {
+      auto& hotelsQuery = query("hotel.chunk");
+      hotelsQuery.execute(afterId, static_cast<int64_t>(count));
+      return readHotels(hotelsQuery);
+    }
+
+    std::vector<hotel::Hotel> SqliteStorage::readHotels(SqliteStatement& hotelsQuery)
     {
       std::vector<hotel::Hotel> results;
 
       // Read hotels
-      auto& hotelsQuery = query("hotel.all");
-      hotelsQuery.execute();
       while (hotelsQuery.hasResultRow())
       {
         int id;
@@ -165,53 +403,69 @@ namespace persistence
     template<>
     std::vector<hotel::Reservation> SqliteStorage::loadAll()
     {
-      std::vector<hotel::Reservation> result;
-
       auto& reservationsQuery = query("reservation_and_atoms.all");
       reservationsQuery.execute();
-      std::unique_ptr<hotel::Reservation> current = nullptr;
-      while (reservationsQuery.hasResultRow())
-      {
-        int reservationId;
-        int reservationRevision;
-        std::string description;
-        std::string reservationStatus;
-        int adults;
-        int children;
-        int atomId;
-        int roomId;
-        boost::gregorian::date dateFrom;
-        boost::gregorian::date dateTo;
-        reservationsQuery.readRow(reservationId, reservationRevision, description, reservationStatus, adults, children,
-                                  atomId, roomId, dateFrom, dateTo);
-
-        if (current == nullptr || current->id() != reservationId)
-        {
-          if (current)
-          {
-            result.push_back(std::move(*current));
-            current = nullptr;
-          }
-          current = std::make_unique<hotel::Reservation>(description, roomId,
-                                                         boost::gregorian::date_period(dateFrom, dateTo));
-          current->setId(reservationId);
-          current->setRevision(reservationRevision);
-          current->setStatus(parseReservationStatus(reservationStatus));
-          current->setNumberOfAdults(adults);
-          current->setNumberOfChildren(children);
-        }
-        else
-        {
-          current->addContinuation(roomId, dateTo);
-        }
-        (*current->atoms().rbegin()).setId(atomId);
-      }
-      if (current)
-      {
-        result.push_back(std::move(*current));
-        current = nullptr;
-      }
+      return readReservations(reservationsQuery);
+    }
+
+    template<>
+    std::vector<hotel::Reservation> SqliteStorage::loadChunk(int afterId, std::size_t count)
+    {
+      auto& reservationsQuery = query("reservation_and_atoms.chunk");
+      reservationsQuery.execute(afterId, static_cast<int64_t>(count));
+      return readReservations(reservationsQuery);
+    }
+
+    template<>
+    std::vector<hotel::AtomRecord> SqliteStorage::loadAll()
+    {
+      auto& atomsQuery = query("reservation_atom.all");
+      atomsQuery.execute();
+      return readAtomRecords(atomsQuery);
+    }
+
+    template<>
+    std::vector<hotel::Reservation> SqliteStorage::loadInPeriod(hotel::DayRange period)
+    {
+      auto& reservationsQuery = query("reservation_and_atoms.in_period");
+      reservationsQuery.execute(period.end(), period.begin());
+      return readReservations(reservationsQuery);
+    }
 
+    template<>
+    std::vector<hotel::AtomRecord> SqliteStorage::loadInPeriod(hotel::DayRange period)
+    {
+      auto& atomsQuery = query("reservation_atom.in_period");
+      atomsQuery.execute(period.end(), period.begin());
+      return readAtomRecords(atomsQuery);
+    }
+
+    std::vector<hotel::AtomRecord> SqliteStorage::loadAtomsInRoom(int roomId, hotel::DayRange period)
+    {
+      auto& atomsQuery = query("reservation_atom.in_room_and_period");
+      atomsQuery.execute(roomId, roomId, period.end(), period.begin());
+      return readAtomRecords(atomsQuery);
+    }
+
+    std::vector<hotel::Reservation> SqliteStorage::loadReservationsInRooms(const std::vector<int>& roomIds,
+                                                                           hotel::DayRange period)
+    {
+      if (roomIds.empty())
+        return {};
+
+      // The R*Tree is queried with the bounding interval of the room ids, the exact rooms are checked afterwards
+      auto [minRoom, maxRoom] = std::minmax_element(roomIds.begin(), roomIds.end());
+      auto& reservationsQuery = query("reservation_and_atoms.in_rooms_and_period");
+      reservationsQuery.execute(*maxRoom, *minRoom, period.end(), period.begin());
+      auto result = readReservations(reservationsQuery);
+
+      auto isOutsideRooms = [&roomIds, period](const hotel::Reservation& reservation) {
+        return std::none_of(reservation.atoms().begin(), reservation.atoms().end(), [&](const auto& atom) {
+          return atom.dayRange().intersects(period) &&
+                 std::find(roomIds.begin(), roomIds.end(), atom.roomId()) != roomIds.end();
+        });
+      };
+      result.erase(std::remove_if(result.begin(), result.end(), isOutsideRooms), result.end());
       return result;
     }
 
@@ -277,41 +531,17 @@ namespace persistence
     template<>
     std::optional<hotel::Reservation> SqliteStorage::loadById(int id)
     {
-      std::optional<hotel::Reservation> result;
-
       auto& reservationsQuery = query("reservation_and_atoms.by_reservation_id");
       reservationsQuery.execute(id);
-      while (reservationsQuery.hasResultRow())
+      auto result = readReservations(reservationsQuery);
+      if (result.empty())
       {
-        int reservationRevision;
-        std::string description;
-        std::string reservationStatus;
-        int adults;
-        int children;
-        int atomId;
-        int roomId;
-        boost::gregorian::date dateFrom;
-        boost::gregorian::date dateTo;
-        reservationsQuery.readRow(reservationRevision, description, reservationStatus, adults, children,
-                                  atomId, roomId, dateFrom, dateTo);
-
-        if (result == std::nullopt)
-        {
-          result = hotel::Reservation(description, roomId, boost::gregorian::date_period(dateFrom, dateTo));
-          result->setId(id);
-          result->setRevision(reservationRevision);
-          result->setStatus(parseReservationStatus(reservationStatus));
-          result->setNumberOfAdults(adults);
-          result->setNumberOfChildren(children);
-        }
-        else
-        {
-          result->addContinuation(roomId, dateTo);
-        }
-        (*result->atoms().rbegin()).setId(atomId);
+        auto& archivedQuery = query("reservation_archive_and_atoms.by_reservation_id");
+        archivedQuery.execute(id);
+        result = readReservations(archivedQuery);
       }
 
-      return result;
+      return result.empty() ? std::nullopt : std::optional<hotel::Reservation>(std::move(result.front()));
     }
 
     void SqliteStorage::storeNewHotel(hotel::Hotel& hotel)
@@ -334,6 +564,8 @@ namespace persistence
         query("room.insert").execute(hotel.id(), room->category()->id(), room->name());
         room->setId(static_cast<int>(lastInsertId()));
       }
+
+      hotel.reindex();
     }
 
     void SqliteStorage::storeNewReservationAndAtoms(hotel::Reservation& reservation)
@@ -346,9 +578,12 @@ namespace persistence
       for (auto& atom : reservation.atoms())
       {
         auto& q = query("reservation_atom.insert");
-        q.execute(reservation.id(), atom.roomId(), atom.dateRange().begin(), atom.dateRange().end());
+        q.execute(reservation.id(), atom.roomId(), atom.dayRange().begin(), atom.dayRange().end());
         atom.setId(static_cast<int>(lastInsertId()));
       }
+
+      if (reservation.status() == hotel::Reservation::Archived)
+        moveReservations({reservation.id()}, true);
     }
 
     template <>
@@ -369,13 +604,22 @@ namespace persistence
     template <>
     bool SqliteStorage::update<hotel::Reservation>(hotel::Reservation& value)
     {
+      // Archived reservations are updated in the planning tables, and are then moved back if they stay archived
+      bool wasArchived = isReservationArchived(value.id());
+      if (wasArchived)
+        moveReservations({value.id()}, false);
+
       auto& q1 = query("reservation.update");
       q1.execute(value.description(), serializeReservationStatus(value.status()), value.numberOfAdults(),
                 value.numberOfChildren(), value.id(), value.revision());
 
       int updatedRows = sqlite3_changes(_db);
       if (updatedRows != 1)
+      {
+        if (wasArchived)
+          moveReservations({value.id()}, true);
         return false;
+      }
 
       auto& q2 = query("reservation.delete_atoms");
       q2.execute(value.id());
@@ -383,11 +627,13 @@ namespace persistence
       for (auto& atom : value.atoms())
       {
         auto& q3 = query("reservation_atom.insert");
-        q3.execute(value.id(), atom.roomId(), atom.dateRange().begin(), atom.dateRange().end());
+        q3.execute(value.id(), atom.roomId(), atom.dayRange().begin(), atom.dayRange().end());
         atom.setId(static_cast<int>(lastInsertId()));
       }
       
       value.setRevision(value.revision() + 1);
+      if (value.status() == hotel::Reservation::Archived)
+        moveReservations({value.id()}, true);
       return true;
     }
 
@@ -398,6 +644,81 @@ namespace persistence
       return false;
     }
 
+    std::vector<int> SqliteStorage::archiveReservations(std::optional<hotel::Day> horizon)
+    {
+      query("reservation_archive.unmark_all").execute();
+      query("reservation_archive.mark_by_status").execute();
+      if (horizon)
+        query("reservation_archive.mark_ended_before").execute(*horizon);
+
+      std::vector<int> result;
+      auto& markedQuery = query("reservation_archive.marked");
+      markedQuery.execute();
+      while (markedQuery.hasResultRow())
+      {
+        int id;
+        markedQuery.readRow(id);
+        result.push_back(id);
+      }
+
+      moveMarkedReservations(true);
+      return result;
+    }
+
+    bool SqliteStorage::isReservationArchived(int id)
+    {
+      auto& archivedQuery = query("reservation_archive.by_id");
+      archivedQuery.execute(id);
+      if (!archivedQuery.hasResultRow())
+        return false;
+
+      int archivedId;
+      archivedQuery.readRow(archivedId);
+      return true;
+    }
+
+    std::vector<hotel::Reservation> SqliteStorage::loadArchivedReservations(hotel::DayRange range)
+    {
+      auto& reservationsQuery = query("reservation_archive_and_atoms.by_period");
+      reservationsQuery.execute(range.end(), range.begin());
+      return readReservations(reservationsQuery);
+    }
+
+    std::vector<hotel::AtomRecord> SqliteStorage::loadAllArchivedAtoms()
+    {
+      auto& atomsQuery = query("reservation_atom_archive.all");
+      atomsQuery.execute();
+      return readAtomRecords(atomsQuery);
+    }
+
+    void SqliteStorage::moveReservations(const std::vector<int>& ids, bool toArchive)
+    {
+      query("reservation_archive.unmark_all").execute();
+      for (auto id : ids)
+        query("reservation_archive.mark_by_id").execute(id);
+      moveMarkedReservations(toArchive);
+    }
+
+    void SqliteStorage::moveMarkedReservations(bool toArchive)
+    {
+      // The rows keep their ids. Since the planning tables use AUTOINCREMENT, ids are never reused.
+      if (toArchive)
+      {
+        query("reservation_archive.insert_marked").execute();
+        query("reservation_atom_archive.insert_marked").execute();
+        query("reservation.delete_marked").execute();
+        query("reservation_atom.delete_marked").execute();
+      }
+      else
+      {
+        query("reservation.insert_marked").execute();
+        query("reservation_atom.insert_marked").execute();
+        query("reservation_archive.delete_marked").execute();
+        query("reservation_atom_archive.delete_marked").execute();
+      }
+      query("reservation_archive.unmark_all").execute();
+    }
+
     SqliteStatement& SqliteStorage::query(const std::string& key)
     {
       auto it = _statements.find(key);
@@ -415,12 +736,31 @@ namespace persistence
     void SqliteStorage::commitTransaction() { sqlite3_exec(_db, "COMMIT TRANSACTION", nullptr, nullptr, nullptr); }
     void SqliteStorage::rollbackTransaction() { sqlite3_exec(_db, "ROLLBACK TRANSACTION", nullptr, nullptr, nullptr); }
 
+    void SqliteStorage::savepoint(const std::string& name)
+    {
+      sqlite3_exec(_db, ("SAVEPOINT " + name).c_str(), nullptr, nullptr, nullptr);
+    }
+
+    void SqliteStorage::releaseSavepoint(const std::string& name)
+    {
+      sqlite3_exec(_db, ("RELEASE SAVEPOINT " + name).c_str(), nullptr, nullptr, nullptr);
+    }
+
+    void SqliteStorage::rollbackToSavepoint(const std::string& name)
+    {
+      // ROLLBACK TO leaves the savepoint on the stack
+      sqlite3_exec(_db, ("ROLLBACK TO SAVEPOINT " + name + "; RELEASE SAVEPOINT " + name).c_str(), nullptr, nullptr,
+                   nullptr);
+    }
+
     void SqliteStorage::prepareQueries()
     {
       _statements.emplace("hotel.insert", SqliteStatement(_db, "INSERT INTO h_hotel (name) VALUES (?);"));
       _statements.emplace("hotel.update", SqliteStatement(_db, "UPDATE h_hotel SET name=?, revision=revision+1 WHERE id=? and revision=?;"));
       _statements.emplace("hotel.all", SqliteStatement(_db, "SELECT id, revision, name FROM h_hotel;"));
       _statements.emplace("hotel.by_id", SqliteStatement(_db, "SELECT id, revision, name FROM h_hotel WHERE id = ?;"));
+      _statements.emplace("hotel.chunk", SqliteStatement(_db, "SELECT id, revision, name FROM h_hotel WHERE id > ? "
+                                                              "ORDER BY id LIMIT ?;"));
       _statements.emplace(
           "room_category.insert",
           SqliteStatement(_db, "INSERT INTO h_room_category (hotel_id, short_code, name) VALUES (?, ?, ?);"));
@@ -436,9 +776,16 @@ namespace persistence
           SqliteStatement(_db, "SELECT r.id, r.revision, r.description, r.status, r.adults, r.children, a.id, a.room_id, a.date_from, a.date_to "
                                "FROM h_reservation as r, h_reservation_atom as a WHERE "
                                "a.reservation_id = r.id ORDER BY r.id, a.date_from;"));
+      _statements.emplace(
+          "reservation_and_atoms.chunk",
+          SqliteStatement(_db, "SELECT r.id, r.revision, r.description, r.status, r.adults, r.children, a.id, a.room_id, a.date_from, a.date_to "
+                               "FROM h_reservation as r, h_reservation_atom as a WHERE "
+                               "a.reservation_id = r.id and r.id IN (SELECT id FROM h_reservation WHERE id > ? AND "
+                               "EXISTS (SELECT 1 FROM h_reservation_atom WHERE reservation_id = h_reservation.id) ORDER BY id LIMIT ?) "
+                               "ORDER BY r.id, a.date_from;"));
       _statements.emplace(
           "reservation_and_atoms.by_reservation_id",
-          SqliteStatement(_db, "SELECT r.revision, r.description, r.status, r.adults, r.children, a.id, a.room_id, a.date_from, a.date_to "
+          SqliteStatement(_db, "SELECT r.id, r.revision, r.description, r.status, r.adults, r.children, a.id, a.room_id, a.date_from, a.date_to "
                                "FROM h_reservation as r, h_reservation_atom as a WHERE "
                                "a.reservation_id = r.id and r.id = ? ORDER BY r.id, a.date_from;"));
       _statements.emplace("reservation.insert",
@@ -448,42 +795,129 @@ namespace persistence
       _statements.emplace("reservation.delete_atoms",
                           SqliteStatement(_db, "DELETE FROM h_reservation_atom WHERE reservation_id = ?;"));
       _statements.emplace("reservation.delete",
-                          SqliteStatement(_db, "DELETE FROM h_reservation_atom WHERE reservation_id = ?; DELETE FROM h_reservation WHERE reservation_id = ?;"));
+                          SqliteStatement(_db, "DELETE FROM h_reservation WHERE id = ?;"));
+      _statements.emplace("reservation_atom.all",
+                          SqliteStatement(_db, "SELECT reservation_id, id, room_id, date_from, date_to "
+                                               "FROM h_reservation_atom;"));
+      _statements.emplace(
+          "reservation_and_atoms.in_period",
+          SqliteStatement(_db, "SELECT r.id, r.revision, r.description, r.status, r.adults, r.children, a.id, a.room_id, a.date_from, a.date_to "
+                               "FROM h_reservation as r, h_reservation_atom as a WHERE "
+                               "a.reservation_id = r.id and r.id IN (SELECT p.reservation_id FROM h_reservation_atom_rtree as t, "
+                               "h_reservation_atom as p WHERE t.date_from < ? AND t.date_to > ? AND p.id = t.id) "
+                               "ORDER BY r.id, a.date_from;"));
+      _statements.emplace(
+          "reservation_and_atoms.in_rooms_and_period",
+          SqliteStatement(_db, "SELECT r.id, r.revision, r.description, r.status, r.adults, r.children, a.id, a.room_id, a.date_from, a.date_to "
+                               "FROM h_reservation as r, h_reservation_atom as a WHERE "
+                               "a.reservation_id = r.id and r.id IN (SELECT p.reservation_id FROM h_reservation_atom_rtree as t, "
+                               "h_reservation_atom as p WHERE t.room_from <= ? AND t.room_to >= ? AND t.date_from < ? AND "
+                               "t.date_to > ? AND p.id = t.id) ORDER BY r.id, a.date_from;"));
+      _statements.emplace("reservation_atom.in_period",
+                          SqliteStatement(_db, "SELECT a.reservation_id, a.id, a.room_id, a.date_from, a.date_to "
+                                               "FROM h_reservation_atom_rtree as t, h_reservation_atom as a WHERE "
+                                               "t.date_from < ? AND t.date_to > ? AND a.id = t.id "
+                                               "ORDER BY a.room_id, a.date_from;"));
+      _statements.emplace("reservation_atom.in_room_and_period",
+                          SqliteStatement(_db, "SELECT a.reservation_id, a.id, a.room_id, a.date_from, a.date_to "
+                                               "FROM h_reservation_atom_rtree as t, h_reservation_atom as a WHERE "
+                                               "t.room_from <= ? AND t.room_to >= ? AND t.date_from < ? AND t.date_to > ? "
+                                               "AND a.id = t.id ORDER BY a.date_from;"));
       _statements.emplace("reservation_atom.insert",
                           SqliteStatement(_db, "INSERT INTO h_reservation_atom (reservation_id, room_id, "
                                                "date_from, date_to) VALUES (?, ?, ?, ?);"));
+
+      // Archive
+      const std::string marked = "(SELECT id FROM t_marked_reservation)";
+      _statements.emplace(
+          "reservation_archive_and_atoms.by_reservation_id",
+          SqliteStatement(_db, "SELECT r.id, r.revision, r.description, r.status, r.adults, r.children, a.id, a.room_id, a.date_from, a.date_to "
+                               "FROM h_reservation_archive as r, h_reservation_atom_archive as a WHERE "
+                               "a.reservation_id = r.id and r.id = ? ORDER BY r.id, a.date_from;"));
+      _statements.emplace(
+          "reservation_archive_and_atoms.by_period",
+          SqliteStatement(_db, "SELECT r.id, r.revision, r.description, r.status, r.adults, r.children, a.id, a.room_id, a.date_from, a.date_to "
+                               "FROM h_reservation_archive as r, h_reservation_atom_archive as a WHERE "
+                               "a.reservation_id = r.id and r.id IN (SELECT p.reservation_id FROM "
+                               "h_reservation_atom_archive_rtree as t, h_reservation_atom_archive as p WHERE "
+                               "t.date_from < ? AND t.date_to > ? AND p.id = t.id) ORDER BY r.id, a.date_from;"));
+      _statements.emplace("reservation_atom_archive.all",
+                          SqliteStatement(_db, "SELECT reservation_id, id, room_id, date_from, date_to "
+                                               "FROM h_reservation_atom_archive;"));
+      _statements.emplace("reservation_archive.by_id",
+                          SqliteStatement(_db, "SELECT id FROM h_reservation_archive WHERE id = ?;"));
+      _statements.emplace("reservation_archive.delete",
+                          SqliteStatement(_db, "DELETE FROM h_reservation_archive WHERE id = ?;"));
+      _statements.emplace("reservation_atom_archive.delete",
+                          SqliteStatement(_db, "DELETE FROM h_reservation_atom_archive WHERE reservation_id = ?;"));
+      _statements.emplace("reservation_archive.mark_by_id",
+                          SqliteStatement(_db, "INSERT OR IGNORE INTO t_marked_reservation (id) VALUES (?);"));
+      _statements.emplace("reservation_archive.mark_by_status",
+                          SqliteStatement(_db, "INSERT OR IGNORE INTO t_marked_reservation (id) "
+                                               "SELECT id FROM h_reservation WHERE status = 'archived';"));
+      _statements.emplace("reservation_archive.mark_ended_before",
+                          SqliteStatement(_db, "INSERT OR IGNORE INTO t_marked_reservation (id) "
+                                               "SELECT reservation_id FROM h_reservation_atom "
+                                               "GROUP BY reservation_id HAVING MAX(date_to) <= ?;"));
+      _statements.emplace("reservation_archive.marked",
+                          SqliteStatement(_db, "SELECT id FROM t_marked_reservation ORDER BY id;"));
+      _statements.emplace("reservation_archive.unmark_all", SqliteStatement(_db, "DELETE FROM t_marked_reservation;"));
+      _statements.emplace("reservation_archive.insert_marked",
+                          SqliteStatement(_db, "INSERT INTO h_reservation_archive SELECT id, revision, description, "
+                                               "status, adults, children FROM h_reservation WHERE id IN " + marked + ";"));
+      _statements.emplace("reservation_atom_archive.insert_marked",
+                          SqliteStatement(_db, "INSERT INTO h_reservation_atom_archive SELECT id, reservation_id, room_id, "
+                                               "date_from, date_to FROM h_reservation_atom WHERE reservation_id IN " + marked + ";"));
+      _statements.emplace("reservation.delete_marked",
+                          SqliteStatement(_db, "DELETE FROM h_reservation WHERE id IN " + marked + ";"));
+      _statements.emplace("reservation_atom.delete_marked",
+                          SqliteStatement(_db, "DELETE FROM h_reservation_atom WHERE reservation_id IN " + marked + ";"));
+      _statements.emplace("reservation.insert_marked",
+                          SqliteStatement(_db, "INSERT INTO h_reservation SELECT id, revision, description, "
+                                               "status, adults, children FROM h_reservation_archive WHERE id IN " + marked + ";"));
+      _statements.emplace("reservation_atom.insert_marked",
+                          SqliteStatement(_db, "INSERT INTO h_reservation_atom SELECT id, reservation_id, room_id, "
+                                               "date_from, date_to FROM h_reservation_atom_archive WHERE reservation_id IN " + marked + ";"));
+      _statements.emplace("reservation_archive.delete_marked",
+                          SqliteStatement(_db, "DELETE FROM h_reservation_archive WHERE id IN " + marked + ";"));
+      _statements.emplace("reservation_atom_archive.delete_marked",
+                          SqliteStatement(_db, "DELETE FROM h_reservation_atom_archive WHERE reservation_id IN " + marked + ";"));
     }
 
+    int SqliteStorage::schemaVersion()
+    {
+      SqliteStatement versionQuery(_db, "SELECT MAX(version) FROM h_schema_version;");
+      versionQuery.execute();
+      int version = 0;
+      if (versionQuery.hasResultRow())
+        versionQuery.readRow(version);
+      return version;
+    }
+
+    int SqliteStorage::latestSchemaVersion() { return static_cast<int>(schemaMigrations().size()); }
+
     void SqliteStorage::createSchema()
     {
-      executeSQL(_db, "CREATE TABLE IF NOT EXISTS h_hotel ("
-                      "id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
-                      "revision INTEGER NOT NULL DEFAULT 1, "
-                      "name TEXT NOT NULL);");
-      executeSQL(_db, "CREATE TABLE IF NOT EXISTS h_room_category ("
-                      "id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
-                      "hotel_id INTEGER NOT NULL," // Foreign key
-                      "short_code TEXT NOT NULL,"
-                      "name TEXT NOT NULL);");
-      executeSQL(_db, "CREATE TABLE IF NOT EXISTS h_room ("
-                      "id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
-                      "hotel_id INTEGER NOT NULL,"    // Foreign key
-                      "category_id INTEGER NOT NULL," // Foreign key
-                      "name TEXT NOT NULL);");
-
-      executeSQL(_db, "CREATE TABLE IF NOT EXISTS h_reservation ("
-                      "id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
-                      "revision INTEGER NOT NULL DEFAULT 1, "
-                      "description TEXT NOT NULL, "
-                      "status TEXT NOT NULL,"
-                      "adults INTEGER NOT NULL,"
-                      "children INTEGER NOT NULL);");
-      executeSQL(_db, "CREATE TABLE IF NOT EXISTS h_reservation_atom ("
-                      "id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
-                      "reservation_id INTEGER NOT NULL," // Foreign key
-                      "room_id INTEGER NOT NULL,"        // Foreign key
-                      "date_from TEXT NOT NULL,"
-                      "date_to TEXT NOT NULL);");
+      // Bring the schema up to date, one version at a time. Each step is a savepoint of its own, so that a failed
+      // migration leaves the database at the previous version. Outside of a transaction, a savepoint is a transaction
+      // of its own. Within one, e.g. when all data is erased in a batch, it is only committed along with the batch.
+      executeSQL(_db, "CREATE TABLE IF NOT EXISTS h_schema_version (version INTEGER NOT NULL);");
+      auto& migrations = schemaMigrations();
+      for (auto version = schemaVersion(); version < latestSchemaVersion(); ++version)
+      {
+        savepoint("migration");
+        if (!executeSQL(_db, migrations[static_cast<std::size_t>(version)]) ||
+            !executeSQL(_db, "DELETE FROM h_schema_version; INSERT INTO h_schema_version (version) VALUES (" +
+                                 std::to_string(version + 1) + ");"))
+        {
+          std::cerr << "Cannot migrate database schema to version " << version + 1 << std::endl;
+          rollbackToSavepoint("migration");
+          break;
+        }
+        releaseSavepoint("migration");
+      }
+
+      executeSQL(_db, createMarkedReservationTable);
     }
 
   } // namespace sqlite
@@ -6,10 +6,12 @@
 #include "hotel/hotel.h"
 #include "hotel/hotelcollection.h"
 #include "hotel/planning.h"
+#include "hotel/planningvalidator.h"
 #include "hotel/reservation.h"
 
 #include <sqlite3.h>
 
+#include <cstddef>
 #include <cstdint>
 #include <map>
 #include <memory>
@@ -24,7 +26,15 @@ namespace persistence
     class SqliteStorage
     {
     public:
-      SqliteStorage(const std::string& file);
+      enum class OpenMode { ReadWrite, ReadOnly };
+
+      /**
+       * @brief Opens the database in the given file
+       *
+       * A writable database is put into WAL mode, and its schema is created or migrated if needed. A read only storage
+       * is meant as an additional connection to a database which is open for writing, see SqliteReaderPool.
+       */
+      SqliteStorage(const std::string& file, OpenMode mode = OpenMode::ReadWrite);
       ~SqliteStorage();
 
       void deleteAll();
@@ -36,6 +46,30 @@ namespace persistence
       template<typename T>
       std::optional<T> loadById(int id);
 
+      /**
+       * @brief loadChunk returns up to count items with an id greater than afterId, sorted by id
+       *
+       * Reading all items chunk by chunk, each continuing after the last id of the previous one, never holds more than
+       * one chunk in memory and keeps no statement open between the chunks. This is implemented for Hotel and
+       * Reservation. Reservations without atoms are skipped and do not count towards count, so that a chunk with fewer
+       * than count items is always the last one.
+       */
+      template<typename T>
+      std::vector<T> loadChunk(int afterId, std::size_t count);
+
+      /**
+       * @brief loadInPeriod returns the items which have at least one night in the given period
+       *
+       * This is implemented for Reservation and AtomRecord, and uses the R*Tree over the atoms. Archived reservations
+       * are not included, see loadArchivedReservations.
+       */
+      template<typename T>
+      std::vector<T> loadInPeriod(hotel::DayRange period);
+      //! Returns the atoms in the given room which have at least one night in the given period, sorted by date
+      std::vector<hotel::AtomRecord> loadAtomsInRoom(int roomId, hotel::DayRange period);
+      //! Returns the reservations with at least one night in the given period in one of the given rooms
+      std::vector<hotel::Reservation> loadReservationsInRooms(const std::vector<int>& roomIds, hotel::DayRange period);
+
       void storeNewHotel(hotel::Hotel& hotel);
       void storeNewReservationAndAtoms(hotel::Reservation& reservation);
 
@@ -44,15 +78,52 @@ namespace persistence
 
       void getReservation();
 
+      /**
+       * @brief archiveReservations moves reservations out of the planning into the archive tables
+       *
+       * Archived reservations are kept in separate tables, so that the planning does not have to load them. This moves
+       * all reservations with status Archived, as well as all reservations which end on or before the given horizon.
+       * The ids of the moved reservations are returned.
+       *
+       * Reservations which are stored or updated with status Archived are moved to the archive automatically, and
+       * archived reservations are moved back to the planning when they are updated with any other status.
+       */
+      std::vector<int> archiveReservations(std::optional<hotel::Day> horizon = std::nullopt);
+      bool isReservationArchived(int id);
+      //! Returns the archived reservations which have at least one night in the given range
+      std::vector<hotel::Reservation> loadArchivedReservations(hotel::DayRange range);
+      //! Returns the atoms of all archived reservations, which loadAll<hotel::AtomRecord> leaves out
+      std::vector<hotel::AtomRecord> loadAllArchivedAtoms();
+
+      //! Returns the version of the schema of the database, which is brought up to date when the storage is opened
+      int schemaVersion();
+      static int latestSchemaVersion();
+
       void beginTransaction();
       void commitTransaction();
       void rollbackTransaction();
 
+      /**
+       * @brief Savepoints mark a part of a transaction which can be rolled back on its own
+       *
+       * rollbackToSavepoint undoes all changes made since the savepoint and also releases it, while releaseSavepoint
+       * keeps the changes as part of the enclosing transaction.
+       */
+      void savepoint(const std::string& name);
+      void releaseSavepoint(const std::string& name);
+      void rollbackToSavepoint(const std::string& name);
+
     private:
       SqliteStatement& query(const std::string& key);
+      std::vector<hotel::Hotel> readHotels(SqliteStatement& hotelsQuery);
       int64_t lastInsertId();
 
+      //! Moves the reservations with the given ids from the planning to the archive tables, or back
+      void moveReservations(const std::vector<int>& ids, bool toArchive);
+      void moveMarkedReservations(bool toArchive);
+
       void prepareQueries();
+      //! Creates the schema, or migrates an existing database to the latest schema version
       void createSchema();
 
       sqlite3* _db;
@@ -154,6 +154,8 @@ namespace server
       runCreateStream(obj);
     else if (operation == "remove_stream")
       runRemoveStream(obj);
+    else if (operation == "change_stream_options")
+      runChangeStreamOptions(obj);
     else if (operation == "schedule_operations")
       runScheduleOperations(obj);
     else
@@ -185,6 +187,20 @@ namespace server
     }
   }
 
+  void NetClientSession::runChangeStreamOptions(const nlohmann::json& obj)
+  {
+    int clientId = obj["id"];
+    auto it = std::find_if(_streams.begin(), _streams.end(),
+                           [clientId](const auto& pair) { return pair.second->clientStreamId() == clientId; });
+
+    if (it != _streams.end())
+    {
+      std::cout << " [R] Change options of stream s[" << it->first.stream()->streamId() << "] => c["
+                << it->second->clientStreamId() << "]" << std::endl;
+      it->first.changeOptions(obj["options"]);
+    }
+  }
+
   void NetClientSession::runScheduleOperations(const nlohmann::json& obj)
   {
     std::cout << " [R] Schedule " << obj["operations"].size() << " operation(s)" << std::endl;
@@ -99,6 +99,7 @@ namespace server
     void runCommand(const nlohmann::json &obj);
     void runCreateStream(const nlohmann::json &obj);
     void runRemoveStream(const nlohmann::json &obj);
+    void runChangeStreamOptions(const nlohmann::json &obj);
     void runScheduleOperations(const nlohmann::json &obj);
 
 
@@ -12,7 +12,8 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
   std::cout << " hotel_serverapp (listening on port 8081)                                       " << std::endl;
   std::cout << "================================================================================" << std::endl;
 
-  auto dataBackend = std::make_unique<persistence::sqlite::SqliteBackend>("data.db");
+  // The server is the only writer to its database, so it can serve all planning reads from memory
+  auto dataBackend = std::make_unique<persistence::sqlite::SqliteBackend>("data.db", std::nullopt, 4, true);
   server::NetServer server(std::move(dataBackend));
 
   std::cout << std::endl << "starting server..." << std::endl;
@@ -1,9 +1,16 @@
 #include "gtest/gtest.h"
 
+#include "hotel/day.h"
+#include "hotel/fenwicktree.h"
+#include "hotel/reservationarchive.h"
 #include "hotel/hotel.h"
 #include "hotel/hotelcollection.h"
+#include "hotel/persistentmap.h"
 #include "hotel/person.h"
 #include "hotel/reservation.h"
+#include "hotel/smallvector.h"
+
+#include <numeric>
 
 TEST(Hotel, Person)
 {
@@ -92,6 +99,23 @@ TEST(Hotel, Hotel)
   ASSERT_EQ("CODE", copy.getCategoryById(1)->shortCode());
   ASSERT_EQ(1, copy.getCategoryByShortCode("CODE")->id());
   ASSERT_EQ("Room 1", copy.rooms()[0]->name());
+  ASSERT_EQ(1u, copy.getRoomsByCategory(copy.getCategoryById(1)).size());
+  ASSERT_EQ(copy.rooms()[0].get(), copy.getRoomsByCategory(copy.getCategoryById(1))[0]);
+
+  // Indices follow id changes once reindexed, and are replaced on assignment
+  copy.addRoomCategory(std::make_unique<hotel::RoomCategory>("OTHER", "Other Category"));
+  copy.addRoom(std::make_unique<hotel::HotelRoom>("Room 2"), "OTHER");
+  ASSERT_EQ(1u, copy.getRoomsByCategory(copy.getCategoryByShortCode("OTHER")).size());
+  copy.getCategoryByShortCode("CODE")->setId(2);
+  copy.reindex();
+  ASSERT_EQ(nullptr, copy.getCategoryById(1));
+  ASSERT_EQ("CODE", copy.getCategoryById(2)->shortCode());
+  copy = hotel;
+  ASSERT_EQ(1u, copy.categories().size());
+  ASSERT_EQ(nullptr, copy.getCategoryByShortCode("OTHER"));
+  ASSERT_EQ(nullptr, copy.getCategoryById(2));
+  ASSERT_EQ("CODE", copy.getCategoryById(1)->shortCode());
+  ASSERT_EQ(0u, hotel.getRoomsByCategory(nullptr).size());
 }
 
 TEST(Hotel, HotelCollection)
@@ -134,6 +158,240 @@ TEST(Hotel, HotelCollection)
   ASSERT_EQ(1u, copy.allRoomsByCategory(1).size());
   ASSERT_EQ("Room", copy.allRooms()[0]->name());
   ASSERT_EQ("Room", copy.allRoomsByCategory(1)[0]->name());
+
+  // Rooms which are added or renumbered after the hotel joined the collection are found once it has been reindexed
+  auto& copiedHotel = *copy.hotels()[0];
+  copiedHotel.addRoom(std::make_unique<hotel::HotelRoom>("Room 2"), "CAT");
+  copiedHotel.rooms()[1]->setId(3);
+  copiedHotel.rooms()[0]->setId(4);
+  copy.reindexHotel(copiedHotel);
+  ASSERT_EQ(nullptr, copy.findRoomById(2));
+  ASSERT_EQ("Room 2", copy.findRoomById(3)->name());
+  ASSERT_EQ("Room", copy.findRoomById(4)->name());
+  ASSERT_EQ(2u, copy.allRoomsByCategory(1).size());
+  ASSERT_EQ(1u, collection.allRoomsByCategory(1).size());
+  ASSERT_NE(nullptr, collection.findRoomById(2));
+
+  // Replacing a hotel of the collection drops the ids of its old rooms
+  copiedHotel = hotel::Hotel("Other Hotel");
+  copy.reindexHotel(copiedHotel);
+  ASSERT_EQ(nullptr, copy.findRoomById(3));
+  ASSERT_EQ(0u, copy.allRoomsByCategory(1).size());
+  ASSERT_EQ(0u, copy.allRoomIDs().size());
+}
+
+TEST(Hotel, Day)
+{
+  using namespace boost::gregorian;
+  static_assert(sizeof(hotel::Day) == 4, "days should be stored as 32 bit numbers");
+  static_assert(std::is_trivially_copyable<hotel::DayRange>::value, "day ranges should be trivially copyable");
+  static_assert(hotel::Day::fromYmd(1970, 1, 1).number() == 0, "day 0 should be the epoch");
+  static_assert(hotel::Day::fromYmd(2017, 3, 1) - hotel::Day::fromYmd(2017, 2, 1) == 28, "");
+
+  // Compare all of the helpers with boost, across leap years and before the epoch
+  for (auto d = date(1899, 12, 1); d < date(2101, 2, 1); d += days(1))
+  {
+    auto day = hotel::Day::fromDate(d);
+    ASSERT_EQ(d, day.toDate());
+    ASSERT_EQ(day, hotel::Day::fromYmd(d.year(), d.month(), d.day()));
+    ASSERT_EQ(d.year(), day.year());
+    ASSERT_EQ(d.month(), day.month());
+    ASSERT_EQ(d.day(), day.dayOfMonth());
+    ASSERT_EQ(d.day_of_week(), day.weekday());
+  }
+  ASSERT_ANY_THROW(hotel::Day::fromDate(date()));
+
+  auto day = hotel::Day::fromYmd(2017, 1, 1);
+  ASSERT_EQ(hotel::Day::fromYmd(2017, 1, 11), day + 10);
+  ASSERT_EQ(hotel::Day::fromYmd(2016, 12, 22), day - 10);
+  ASSERT_EQ(-10, (day - 10) - day);
+  ASSERT_TRUE(day < day + 1);
+  ASSERT_TRUE(day >= day);
+
+  // Day ranges exclude their end, just like date_period
+  auto range = hotel::DayRange(day, day + 5);
+  ASSERT_EQ(date_period(date(2017, 1, 1), date(2017, 1, 6)), range.toPeriod());
+  ASSERT_EQ(range, hotel::DayRange::fromPeriod(range.toPeriod()));
+  ASSERT_EQ(5, range.length());
+  ASSERT_FALSE(range.isEmpty());
+  ASSERT_TRUE(hotel::DayRange(day, day).isEmpty());
+  ASSERT_TRUE(range.contains(day));
+  ASSERT_FALSE(range.contains(day + 5));
+  ASSERT_TRUE(range.intersects(hotel::DayRange(day + 4, day + 10)));
+  ASSERT_FALSE(range.intersects(hotel::DayRange(day + 5, day + 10)));
+  ASSERT_FALSE(range.intersects(hotel::DayRange(day + 2, day + 2)));
+}
+
+TEST(Hotel, SmallVector)
+{
+  hotel::SmallVector<std::string, 2> vector;
+  ASSERT_TRUE(vector.empty());
+  vector.push_back("a");
+  vector.emplace_back("b");
+  ASSERT_TRUE(vector.isInline());
+
+  // Growing beyond the inline capacity moves the elements to the heap, even if the new element comes from the vector
+  vector.push_back(vector[0]);
+  ASSERT_FALSE(vector.isInline());
+  ASSERT_EQ(3u, vector.size());
+  ASSERT_EQ("a", vector.front());
+  ASSERT_EQ("a", vector.back());
+
+  auto copy = vector;
+  ASSERT_EQ(vector, copy);
+  vector.erase(vector.begin());
+  ASSERT_EQ(std::vector<std::string>({"b", "a"}), std::vector<std::string>(vector.begin(), vector.end()));
+  ASSERT_NE(vector, copy);
+
+  auto moved = std::move(copy);
+  ASSERT_EQ(3u, moved.size());
+  ASSERT_TRUE(copy.empty());
+  hotel::SmallVector<std::string, 2> small;
+  small.push_back("c");
+  moved = std::move(small);
+  ASSERT_TRUE(moved.isInline());
+  ASSERT_EQ("c", moved[0]);
+  moved.pop_back();
+  ASSERT_TRUE(moved.empty());
+}
+
+TEST(Hotel, PersistentMap)
+{
+  hotel::PersistentMap<int, std::string> empty;
+  ASSERT_TRUE(empty.empty());
+  ASSERT_EQ(nullptr, empty.find(1));
+  ASSERT_EQ(nullptr, empty.first());
+
+  // Every version of the map stays unchanged
+  std::vector<hotel::PersistentMap<int, std::string>> versions = {empty};
+  for (int i = 0; i < 100; ++i)
+    versions.push_back(versions.back().insert((i * 37) % 100, std::to_string(i)));
+  for (int i = 0; i < 100; i += 2)
+    versions.push_back(versions.back().erase(i));
+  ASSERT_TRUE(empty.empty());
+  ASSERT_EQ(50u, versions[50].size());
+  ASSERT_EQ(100u, versions[100].size());
+  ASSERT_EQ(50u, versions.back().size());
+  ASSERT_EQ(nullptr, versions[1].find(37));
+  ASSERT_EQ("1", versions[2].find(37)->second);
+  ASSERT_EQ("1", versions.back().find(37)->second);
+  ASSERT_EQ(nullptr, versions.back().find(36));
+
+  auto& map = versions.back();
+  std::vector<int> keys;
+  map.forEach([&keys](auto& entry) { keys.push_back(entry.first); });
+  ASSERT_EQ(50u, keys.size());
+  ASSERT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+  ASSERT_EQ(1, map.first()->first);
+  ASSERT_EQ(99, map.last()->first);
+  ASSERT_EQ(35, map.findLastNotAfter(36)->first);
+  ASSERT_EQ(37, map.findLastNotAfter(37)->first);
+  ASSERT_EQ(37, map.findFirstAfter(36)->first);
+  ASSERT_EQ(nullptr, map.findLastNotAfter(0));
+  ASSERT_EQ(nullptr, map.findFirstAfter(99));
+  ASSERT_EQ("x", map.insert(37, "x").find(37)->second);
+  ASSERT_EQ(50u, map.insert(37, "x").size());
+}
+
+TEST(Hotel, RangeFenwickTree)
+{
+  // Compare against a plain array, the tree built from values must match the one built by updates
+  std::vector<int64_t> values(37, 0);
+  hotel::RangeFenwickTree tree(values.size());
+  for (std::size_t i = 0; i < 200; ++i)
+  {
+    auto begin = (i * 7) % values.size();
+    auto end = std::min(values.size(), begin + (i * 13) % 11);
+    auto delta = static_cast<int64_t>(i % 5) - 2;
+    tree.add(begin, end, delta);
+    for (auto j = begin; j < end; ++j)
+      values[j] += delta;
+  }
+  ASSERT_EQ(values, tree.values());
+  ASSERT_EQ(values, hotel::RangeFenwickTree(values).values());
+  for (std::size_t begin = 0; begin <= values.size(); ++begin)
+    for (std::size_t end = begin; end <= values.size(); ++end)
+      ASSERT_EQ(std::accumulate(values.begin() + begin, values.begin() + end, int64_t(0)), tree.sum(begin, end));
+  ASSERT_EQ(0, tree.sum(5, 2));
+  ASSERT_EQ(values[3], tree.value(3));
+}
+
+TEST(Hotel, ReservationArchive)
+{
+  auto makeReservation = [](int id, int begin, int end, const std::string& description) {
+    hotel::Reservation reservation(description, id % 3, hotel::DayRange(hotel::Day(begin), hotel::Day(begin + 2)));
+    if (end > begin + 2)
+      reservation.addContinuation(id % 3 + 1, hotel::Day(end));
+    reservation.setId(id);
+    reservation.setRevision(id + 1);
+    reservation.setStatus(hotel::Reservation::Archived);
+    reservation.setNumberOfAdults(2);
+    reservation.atoms()[0].setId(10 * id);
+    reservation.atoms().back().setId(10 * id + 1);
+    return reservation;
+  };
+  auto ids = [](const std::vector<hotel::Reservation>& reservations) {
+    std::vector<int> result;
+    for (auto& reservation : reservations)
+      result.push_back(reservation.id());
+    return result;
+  };
+
+  hotel::ReservationArchive archive;
+  std::vector<hotel::Reservation> reservations;
+  for (int id = 1; id <= 20; ++id)
+  {
+    auto begin = 5 * (20 - id);
+    reservations.push_back(makeReservation(id, begin, begin + (id == 20 ? 40 : 4), "R" + std::to_string(id)));
+  }
+  archive.add(reservations);
+  ASSERT_EQ(20u, archive.size());
+  ASSERT_EQ(reservations[3], *archive.getReservation(4));
+  ASSERT_EQ(reservations[19], *archive.getReservation(20));
+  ASSERT_EQ(std::nullopt, archive.getReservation(21));
+
+  // Reservation 20 starts on day 0, but its length makes it reach into later ranges
+  auto idsInRange = [&](int begin, int end) {
+    return ids(archive.getReservationsInRange(hotel::DayRange(hotel::Day(begin), hotel::Day(end))));
+  };
+  ASSERT_EQ(std::vector<int>({20, 19}), idsInRange(3, 6));
+  ASSERT_EQ(std::vector<int>({20, 13, 12}), idsInRange(36, 41));
+  ASSERT_EQ(std::vector<int>({20, 12}), idsInRange(39, 41));
+  ASSERT_TRUE(idsInRange(200, 300).empty());
+
+  // Replacing and removing reservations, enough to compact the storage
+  archive.add({makeReservation(12, 150, 160, "Moved")});
+  ASSERT_EQ(std::vector<int>({20, 13}), idsInRange(36, 41));
+  ASSERT_EQ("Moved", archive.getReservation(12)->description());
+  archive.remove({1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 42});
+  ASSERT_EQ(8u, archive.size());
+  ASSERT_FALSE(archive.contains(13));
+  ASSERT_TRUE(archive.contains(12));
+  ASSERT_EQ(makeReservation(12, 150, 160, "Moved"), *archive.getReservation(12));
+  ASSERT_EQ(reservations[16], *archive.getReservation(17));
+  ASSERT_EQ(std::vector<int>({20, 17}), idsInRange(15, 20));
+  ASSERT_EQ(std::vector<int>({12}), idsInRange(159, 160));
+
+  // Loaded ranges are merged, only the gaps are missing
+  ASSERT_EQ(std::vector<hotel::DayRange>({hotel::DayRange(hotel::Day(0), hotel::Day(10))}),
+            archive.missingRanges(hotel::DayRange(hotel::Day(0), hotel::Day(10))));
+  archive.markLoaded(hotel::DayRange(hotel::Day(2), hotel::Day(4)));
+  archive.markLoaded(hotel::DayRange(hotel::Day(6), hotel::Day(8)));
+  ASSERT_EQ(std::vector<hotel::DayRange>({hotel::DayRange(hotel::Day(0), hotel::Day(2)),
+                                          hotel::DayRange(hotel::Day(4), hotel::Day(6)),
+                                          hotel::DayRange(hotel::Day(8), hotel::Day(10))}),
+            archive.missingRanges(hotel::DayRange(hotel::Day(0), hotel::Day(10))));
+  archive.markLoaded(hotel::DayRange(hotel::Day(4), hotel::Day(6)));
+  ASSERT_EQ(std::vector<hotel::DayRange>({hotel::DayRange(hotel::Day(1), hotel::Day(2))}),
+            archive.missingRanges(hotel::DayRange(hotel::Day(1), hotel::Day(8))));
+  ASSERT_TRUE(archive.missingRanges(hotel::DayRange(hotel::Day(3), hotel::Day(7))).empty());
+
+  // Clearing keeps the loaded ranges
+  archive.clear();
+  ASSERT_EQ(0u, archive.size());
+  ASSERT_FALSE(archive.contains(12));
+  ASSERT_EQ(std::nullopt, archive.getReservation(20));
+  ASSERT_TRUE(archive.missingRanges(hotel::DayRange(hotel::Day(3), hotel::Day(7))).empty());
 }
 
 TEST(Hotel, ReservationAtom)
@@ -1,8 +1,16 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
+#include "hotel/availabilitysearch.h"
+#include "hotel/hotelcollection.h"
+#include "hotel/planningoptimizer.h"
+#include "hotel/planningvalidator.h"
 #include "hotel/planning.h"
 
+#include <atomic>
+#include <random>
+#include <tuple>
+
 class HotelPlanning : public testing::Test
 {
 public:
@@ -100,3 +108,845 @@ TEST_F(HotelPlanning, Planning)
   ASSERT_EQ(1u, board.getReservationsInPeriod(board.getPlanningExtent()).size());
   ASSERT_ANY_THROW(board.removeReservation(nullptr));
 }
+
+TEST_F(HotelPlanning, RoomIndex)
+{
+  // Insert reservations in non-chronological order and with gaps, then compare the indexed queries to a brute force
+  // evaluation over all of the reservations
+  hotel::PlanningBoard board;
+  std::vector<std::pair<int, int>> periods = {{20, 22}, {0, 3}, {10, 11}, {5, 8}, {3, 5}, {14, 20}, {11, 12}};
+  for (auto& period : periods)
+    board.addReservation(std::make_unique<hotel::Reservation>(makeReservation(1, period.first, period.second)));
+
+  auto isOccupied = [&](int day) {
+    return std::any_of(periods.begin(), periods.end(),
+                       [day](auto& period) { return period.first <= day && day < period.second; });
+  };
+
+  for (int from = -2; from < 25; ++from)
+  {
+    int expectedAvailableDays = 0;
+    while (from + expectedAvailableDays < 25 && !isOccupied(from + expectedAvailableDays))
+      ++expectedAvailableDays;
+    if (from + expectedAvailableDays == 25)
+      expectedAvailableDays = std::numeric_limits<int>::max();
+    ASSERT_EQ(expectedAvailableDays, board.getAvailableDaysFrom(1, makeDate(from))) << "from day " << from;
+
+    for (int to = from; to < 25; ++to)
+    {
+      bool expectedFree = !isOccupied(from);
+      for (int day = from; day < to; ++day)
+        expectedFree = expectedFree && !isOccupied(day);
+      ASSERT_EQ(expectedFree, board.isFree(1, boost::gregorian::date_period(makeDate(from), makeDate(to))))
+          << "period " << from << " - " << to;
+    }
+  }
+
+  // Removing reservations frees their periods again
+  for (auto reservation : board.reservations())
+    if (reservation->dateRange().begin() == makeDate(5))
+      board.removeReservation(reservation);
+  ASSERT_TRUE(board.isFree(1, boost::gregorian::date_period(makeDate(5), makeDate(8))));
+  ASSERT_FALSE(board.isFree(1, boost::gregorian::date_period(makeDate(4), makeDate(8))));
+  ASSERT_EQ(5, board.getAvailableDaysFrom(1, makeDate(5)));
+}
+
+TEST_F(HotelPlanning, ReservationIndex)
+{
+  hotel::PlanningBoard board;
+  std::vector<const hotel::Reservation*> added;
+  for (int i = 0; i < 10; ++i)
+  {
+    auto reservation = std::make_unique<hotel::Reservation>(makeReservation(i, 0, 5));
+    reservation->setId(100 + i);
+    added.push_back(board.addReservation(std::move(reservation)));
+  }
+  ASSERT_EQ(nullptr, board.getReservationById(0));
+  ASSERT_EQ(nullptr, board.getReservationById(99));
+  for (int i = 0; i < 10; ++i)
+    ASSERT_EQ(added[i], board.getReservationById(100 + i));
+
+  // Ids must be unique
+  auto duplicate = std::make_unique<hotel::Reservation>(makeReservation(20, 0, 5));
+  duplicate->setId(105);
+  ASSERT_ANY_THROW(board.addReservation(std::move(duplicate)));
+
+  // Remove by id and by pointer. The remaining reservations must not move in memory.
+  board.removeReservation(100);
+  board.removeReservation(added[5]);
+  board.removeReservation(109);
+  board.removeReservation(12345);
+  ASSERT_EQ(7u, board.reservations().size());
+  ASSERT_EQ(nullptr, board.getReservationById(100));
+  ASSERT_EQ(nullptr, board.getReservationById(105));
+  ASSERT_EQ(nullptr, board.getReservationById(109));
+  for (int i : {1, 2, 3, 4, 6, 7, 8})
+  {
+    ASSERT_EQ(added[i], board.getReservationById(100 + i));
+    ASSERT_EQ(100 + i, added[i]->id());
+  }
+  ASSERT_TRUE(board.isFree(0, boost::gregorian::date_period(makeDate(0), makeDate(5))));
+  ASSERT_FALSE(board.isFree(1, boost::gregorian::date_period(makeDate(0), makeDate(5))));
+
+  // Reservations without id can only be removed by pointer
+  auto unsaved = board.addReservation(std::make_unique<hotel::Reservation>(makeReservation(0, 0, 5)));
+  board.removeReservation(0);
+  ASSERT_EQ(8u, board.reservations().size());
+  board.removeReservation(unsaved);
+  ASSERT_EQ(7u, board.reservations().size());
+}
+
+TEST_F(HotelPlanning, PeriodIndex)
+{
+  using namespace boost::gregorian;
+
+  // Reservations of very different lengths, some of them spanning many weeks
+  hotel::PlanningBoard board;
+  std::vector<std::pair<int, int>> periods = {{0, 1}, {0, 60}, {3, 10}, {13, 14}, {30, 100}, {90, 91}, {200, 400}};
+  for (std::size_t i = 0; i < periods.size(); ++i)
+  {
+    auto reservation = makeReservation(static_cast<int>(i), periods[i].first, periods[i].second);
+    board.addReservation(std::make_unique<hotel::Reservation>(reservation));
+  }
+
+  for (int from = -10; from < 410; from += 3)
+  {
+    for (int length : {0, 1, 5, 30, 200})
+    {
+      auto period = date_period(makeDate(from), makeDate(from + length));
+      std::size_t expected = 0;
+      for (auto& reservation : board.reservations())
+        if (reservation->dateRange().intersects(period))
+          ++expected;
+
+      // Every reservation is reported exactly once
+      std::vector<const hotel::Reservation*> visited;
+      const auto& constBoard = board;
+      constBoard.forEachReservationInPeriod(period, [&](const hotel::Reservation* r) { visited.push_back(r); });
+      std::sort(visited.begin(), visited.end());
+      ASSERT_EQ(visited.end(), std::unique(visited.begin(), visited.end()));
+      ASSERT_EQ(expected, visited.size()) << "period " << from << " + " << length;
+      ASSERT_EQ(expected, board.getReservationsInPeriod(period).size());
+    }
+  }
+
+  // Removed reservations are no longer reported
+  for (auto reservation : board.getReservationsInPeriod(date_period(makeDate(50), makeDate(51))))
+    board.removeReservation(reservation);
+  ASSERT_EQ(0u, board.getReservationsInPeriod(date_period(makeDate(50), makeDate(51))).size());
+  ASSERT_EQ(3u, board.getReservationsInPeriod(date_period(makeDate(0), makeDate(14))).size());
+  ASSERT_EQ(1u, board.getReservationsInPeriod(date_period(makeDate(90), makeDate(91))).size());
+}
+
+TEST_F(HotelPlanning, OccupancyBitmap)
+{
+  using namespace boost::gregorian;
+
+  // Reservations in 100 rooms, crossing the boundaries between the chunks and words of the bitmap
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<> lengthDist(1, 40);
+  hotel::PlanningBoard board;
+  std::vector<int> roomIds;
+  for (int room = 1; room <= 100; ++room)
+  {
+    roomIds.push_back(room);
+    for (int day = room % 7; day < 900; day += lengthDist(rng))
+    {
+      auto length = lengthDist(rng);
+      board.addReservation(std::make_unique<hotel::Reservation>(makeReservation(room, day, day + length)));
+      day += length;
+    }
+  }
+  roomIds.push_back(1000); // A room without any reservations
+
+  auto checkFreeRooms = [&]() {
+    for (int from = -10; from < 910; from += 7)
+    {
+      for (int length : {0, 1, 5, 64, 200})
+      {
+        auto period = date_period(makeDate(from), makeDate(from + length));
+        std::vector<int> expected;
+        for (auto roomId : roomIds)
+          if (board.isFree(roomId, period))
+            expected.push_back(roomId);
+        ASSERT_EQ(expected, board.getFreeRooms(roomIds, period)) << "period " << from << " + " << length;
+      }
+    }
+  };
+
+  // The results do not depend on whether the bitmap is enabled
+  ASSERT_FALSE(board.isOccupancyBitmapEnabled());
+  checkFreeRooms();
+  board.setOccupancyBitmapEnabled(true);
+  ASSERT_TRUE(board.isOccupancyBitmapEnabled());
+  checkFreeRooms();
+
+  // The bitmap is updated when reservations are removed and added
+  auto reservations = board.reservations();
+  for (std::size_t i = 0; i < reservations.size(); i += 3)
+    board.removeReservation(reservations[i]);
+  checkFreeRooms();
+  board.addReservation(std::make_unique<hotel::Reservation>(makeReservation(1000, 0, 900)));
+  checkFreeRooms();
+
+  // Copies keep the bitmap
+  hotel::PlanningBoard copy;
+  copy = board;
+  ASSERT_TRUE(copy.isOccupancyBitmapEnabled());
+  ASSERT_EQ(board.getFreeRooms(roomIds, date_period(makeDate(100), makeDate(110))),
+            copy.getFreeRooms(roomIds, date_period(makeDate(100), makeDate(110))));
+
+  // Query over a room category
+  std::vector<std::unique_ptr<hotel::Hotel>> hotels;
+  hotels.push_back(std::make_unique<hotel::Hotel>("Hotel"));
+  hotels[0]->addRoomCategory(std::make_unique<hotel::RoomCategory>("A", "Category A"));
+  hotels[0]->addRoomCategory(std::make_unique<hotel::RoomCategory>("B", "Category B"));
+  hotels[0]->getCategoryByShortCode("A")->setId(1);
+  hotels[0]->getCategoryByShortCode("B")->setId(2);
+  for (int room = 1; room <= 4; ++room)
+  {
+    hotels[0]->addRoom(std::make_unique<hotel::HotelRoom>("Room " + std::to_string(room)), room <= 2 ? "A" : "B");
+    hotels[0]->rooms().back()->setId(room);
+  }
+  hotel::HotelCollection collection(std::move(hotels));
+
+  hotel::PlanningBoard smallBoard;
+  smallBoard.setOccupancyBitmapEnabled(true);
+  smallBoard.addReservation(std::make_unique<hotel::Reservation>(makeReservation(1, 0, 10)));
+  smallBoard.addReservation(std::make_unique<hotel::Reservation>(makeReservation(3, 5, 7)));
+  ASSERT_EQ(std::vector<int>({2}), smallBoard.getFreeRooms(collection, 1, date_period(makeDate(2), makeDate(3))));
+  ASSERT_EQ(std::vector<int>({4}), smallBoard.getFreeRooms(collection, 2, date_period(makeDate(4), makeDate(6))));
+  ASSERT_EQ(std::vector<int>({3, 4}), smallBoard.getFreeRooms(collection, 2, date_period(makeDate(7), makeDate(9))));
+}
+
+TEST_F(HotelPlanning, BulkLoad)
+{
+  using namespace boost::gregorian;
+
+  // Random reservations with many conflicts, both within the batch and with the planning board
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<> roomDist(1, 10);
+  std::uniform_int_distribution<> dayDist(0, 300);
+  std::uniform_int_distribution<> lengthDist(1, 10);
+  std::uniform_int_distribution<> idDist(0, 1000);
+  auto makeBatch = [&](int n) {
+    std::vector<std::unique_ptr<hotel::Reservation>> batch;
+    for (int i = 0; i < n; ++i)
+    {
+      auto day = dayDist(rng);
+      auto length = lengthDist(rng);
+      auto reservation = std::make_unique<hotel::Reservation>(makeReservation(roomDist(rng), day, day + length));
+      if (i % 3 == 0)
+        reservation->addContinuation(roomDist(rng), reservation->dateRange().end() + days(lengthDist(rng)));
+      reservation->setId(idDist(rng));
+      batch.push_back(std::move(reservation));
+    }
+    batch.push_back(nullptr);
+    batch.push_back(std::make_unique<hotel::Reservation>(makeReservation(1, 5, 5)));
+    return batch;
+  };
+
+  hotel::PlanningBoard bulkBoard;
+  hotel::PlanningBoard referenceBoard;
+  for (int round = 0; round < 3; ++round)
+  {
+    auto batch = makeBatch(200);
+    std::vector<bool> expected;
+    for (auto& reservation : batch)
+    {
+      try
+      {
+        referenceBoard.addReservation(reservation ? std::make_unique<hotel::Reservation>(*reservation) : nullptr);
+        expected.push_back(true);
+      }
+      catch (const std::exception&)
+      {
+        expected.push_back(false);
+      }
+    }
+
+    std::vector<std::unique_ptr<hotel::Reservation>> originals;
+    for (auto& reservation : batch)
+      originals.push_back(reservation ? std::make_unique<hotel::Reservation>(*reservation) : nullptr);
+    auto added = bulkBoard.addReservations(std::move(batch));
+    ASSERT_EQ(expected.size(), added.size());
+    for (std::size_t i = 0; i < added.size(); ++i)
+    {
+      ASSERT_EQ(expected[i], added[i] != nullptr) << "round " << round << " item " << i;
+      if (added[i] != nullptr)
+        ASSERT_EQ(*originals[i], *added[i]);
+    }
+  }
+
+  // Both boards answer all queries the same way
+  ASSERT_EQ(referenceBoard.reservations().size(), bulkBoard.reservations().size());
+  ASSERT_EQ(referenceBoard.getPlanningExtent(), bulkBoard.getPlanningExtent());
+  for (int room = 1; room <= 10; ++room)
+    for (int day = -5; day < 320; ++day)
+      ASSERT_EQ(referenceBoard.getAvailableDaysFrom(room, makeDate(day)),
+                bulkBoard.getAvailableDaysFrom(room, makeDate(day)));
+  for (int day = -5; day < 320; day += 4)
+  {
+    auto period = date_period(makeDate(day), makeDate(day + 3));
+    ASSERT_EQ(referenceBoard.getReservationsInPeriod(period).size(), bulkBoard.getReservationsInPeriod(period).size());
+  }
+  for (auto reservation : referenceBoard.reservations())
+    if (reservation->id() != 0)
+      ASSERT_EQ(*reservation, *bulkBoard.getReservationById(reservation->id()));
+}
+
+TEST_F(HotelPlanning, PlanningExtent)
+{
+  using namespace boost::gregorian;
+
+  // Add and remove random reservations, many of them sharing the boundary dates
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<> dayDist(0, 50);
+  std::uniform_int_distribution<> lengthDist(1, 5);
+  hotel::PlanningBoard board;
+  for (int i = 0; i < 2000; ++i)
+  {
+    auto reservations = board.reservations();
+    if (i % 3 == 2 && !reservations.empty())
+    {
+      std::uniform_int_distribution<std::size_t> indexDist(0, reservations.size() - 1);
+      board.removeReservation(reservations[indexDist(rng)]);
+    }
+    else
+    {
+      auto day = dayDist(rng);
+      auto reservation = makeReservation(i % 20, day, day + lengthDist(rng));
+      if (board.canAddReservation(reservation))
+        board.addReservation(std::make_unique<hotel::Reservation>(reservation));
+    }
+
+    reservations = board.reservations();
+    if (reservations.empty())
+      continue;
+    auto from = reservations[0]->dateRange().begin();
+    auto to = reservations[0]->dateRange().end();
+    for (auto reservation : reservations)
+    {
+      from = std::min(from, reservation->dateRange().begin());
+      to = std::max(to, reservation->dateRange().end());
+    }
+    ASSERT_EQ(date_period(from, to), board.getPlanningExtent());
+  }
+
+  board.clear();
+  ASSERT_TRUE(board.getPlanningExtent().is_null());
+}
+
+TEST_F(HotelPlanning, ReservationStorage)
+{
+  using namespace boost::gregorian;
+
+  // Reservations are moved into the storage of the planning board
+  hotel::PlanningBoard board;
+  std::vector<hotel::Reservation> reservations;
+  for (int i = 0; i < 1000; ++i)
+  {
+    reservations.push_back(makeReservation(i % 10, 2 * (i / 10), 2 * (i / 10) + 1));
+    if (i % 4 == 0)
+      reservations.back().addContinuation(100 + i % 10, makeDate(2 * (i / 10) + 2));
+    reservations.back().setId(i + 1);
+  }
+  auto expected = reservations;
+  auto added = board.addReservations(std::move(reservations));
+  ASSERT_EQ(1000u, board.reservations().size());
+  for (std::size_t i = 0; i < added.size(); ++i)
+  {
+    ASSERT_NE(nullptr, added[i]);
+    ASSERT_EQ(expected[i], *added[i]);
+    ASSERT_EQ(added[i], board.getReservationById(static_cast<int>(i + 1)));
+  }
+
+  // Removing reservations does not move any of the other ones, and freed storage is reused
+  for (std::size_t i = 0; i < added.size(); i += 2)
+    board.removeReservation(added[i]);
+  ASSERT_EQ(500u, board.reservations().size());
+  for (std::size_t i = 1; i < added.size(); i += 2)
+    ASSERT_EQ(expected[i], *added[i]);
+  auto readded = board.addReservation(std::make_unique<hotel::Reservation>(expected[0]));
+  ASSERT_EQ(readded, board.getReservationById(1));
+  std::vector<hotel::Reservation*> freed;
+  for (std::size_t i = 0; i < added.size(); i += 2)
+    if (added[i] != readded)
+      freed.push_back(added[i]);
+  ASSERT_EQ(499u, freed.size());
+
+  // Pointers which are not owned by the board are ignored
+  board.removeReservation(&expected[1]);
+  ASSERT_EQ(501u, board.reservations().size());
+  board.removeReservation(freed[0]);
+  ASSERT_EQ(501u, board.reservations().size());
+}
+
+TEST_F(HotelPlanning, Snapshots)
+{
+  using namespace boost::gregorian;
+
+  hotel::PlanningBoard board;
+  ASSERT_THROW(board.snapshot(), std::logic_error);
+
+  std::vector<hotel::Reservation> reservations;
+  for (int i = 0; i < 200; ++i)
+  {
+    reservations.push_back(makeReservation(i % 20, 3 * (i / 20), 3 * (i / 20) + 2));
+    if (i % 3 == 0)
+      reservations.back().addContinuation(100 + i % 20, makeDate(3 * (i / 20) + 3));
+    reservations.back().setId(i % 7 == 0 ? 0 : i + 1);
+  }
+  board.addReservations(std::vector<hotel::Reservation>(reservations.begin(), reservations.begin() + 100));
+
+  // Enabling the tracking takes the reservations which are already on the board into account
+  board.setSnapshotTrackingEnabled(true);
+  auto initial = board.snapshot();
+  ASSERT_EQ(100u, initial.size());
+  for (int i = 100; i < 200; ++i)
+    board.addReservation(std::make_unique<hotel::Reservation>(reservations[i]));
+  for (int i = 1; i < 200; i += 5)
+    board.removeReservation(i + 1);
+  auto current = board.snapshot();
+
+  // The first snapshot is not affected by later changes to the board
+  ASSERT_EQ(100u, initial.size());
+  ASSERT_EQ(board.reservations().size(), current.size());
+  ASSERT_EQ(date_period(makeDate(0), makeDate(30)), current.getPlanningExtent());
+  ASSERT_EQ(date_period(makeDate(0), makeDate(15)), initial.getPlanningExtent());
+  ASSERT_EQ(nullptr, initial.getReservationById(103));
+  ASSERT_EQ(reservations[102], *current.getReservationById(103));
+  ASSERT_EQ(reservations[1], *initial.getReservationById(2));
+  ASSERT_EQ(nullptr, current.getReservationById(2));
+
+  // Snapshots answer availability queries like the board they were taken from
+  for (int room : {0, 1, 5, 100, 103, 200})
+    for (int from = -2; from < 32; ++from)
+      for (int length : {0, 1, 2, 5})
+      {
+        auto period = date_period(makeDate(from), makeDate(from + length));
+        ASSERT_EQ(board.isFree(room, period), current.isFree(room, period));
+        ASSERT_EQ(board.getAvailableDaysFrom(room, makeDate(from)),
+                  current.getAvailableDaysFrom(room, hotel::Day::fromDate(makeDate(from))));
+      }
+
+  std::vector<hotel::Reservation> contents;
+  current.forEachReservation([&contents](const hotel::Reservation* reservation) { contents.push_back(*reservation); });
+  ASSERT_EQ(board.reservations().size(), contents.size());
+  for (auto& reservation : contents)
+    ASSERT_FALSE(board.canAddReservation(reservation));
+
+  // Snapshots can be modified on their own, and they reject the same reservations as the board does
+  auto modified = initial.withoutReservation(2).withReservation(reservations[150]);
+  ASSERT_EQ(100u, modified.size());
+  ASSERT_EQ(nullptr, modified.getReservationById(2));
+  ASSERT_NE(nullptr, initial.getReservationById(2));
+  ASSERT_THROW(modified.withReservation(reservations[150]), std::logic_error);
+  ASSERT_THROW(modified.withReservation(makeReservation(0, 0, 1)), std::logic_error);
+  ASSERT_EQ(modified.size(), modified.withoutReservation(9999).size());
+
+  // Reservations are identified by their id and first atom, so they may differ from the stored copy
+  auto changed = reservations[150];
+  changed.setDescription("Changed");
+  ASSERT_EQ(99u, modified.withoutReservation(changed).size());
+  ASSERT_EQ(nullptr, modified.withoutReservation(changed).getReservationById(changed.id()));
+
+  // Copies of the board keep tracking snapshots
+  hotel::PlanningBoard copy;
+  copy = board;
+  ASSERT_TRUE(copy.isSnapshotTrackingEnabled());
+  copy.removeReservation(3);
+  ASSERT_EQ(copy.reservations().size(), copy.snapshot().size());
+  ASSERT_EQ(nullptr, copy.snapshot().getReservationById(3));
+  ASSERT_NE(nullptr, board.snapshot().getReservationById(3));
+
+  board.clear();
+  ASSERT_TRUE(board.snapshot().empty());
+  ASSERT_FALSE(current.empty());
+}
+
+TEST_F(HotelPlanning, AvailabilitySearch)
+{
+  using namespace boost::gregorian;
+
+  std::vector<std::unique_ptr<hotel::Hotel>> hotels;
+  hotels.push_back(std::make_unique<hotel::Hotel>("Hotel"));
+  hotels[0]->addRoomCategory(std::make_unique<hotel::RoomCategory>("A", "Category A"));
+  hotels[0]->addRoomCategory(std::make_unique<hotel::RoomCategory>("B", "Category B"));
+  hotels[0]->getCategoryByShortCode("A")->setId(1);
+  hotels[0]->getCategoryByShortCode("B")->setId(2);
+  for (int room = 1; room <= 5; ++room)
+  {
+    hotels[0]->addRoom(std::make_unique<hotel::HotelRoom>("Room " + std::to_string(room)), room <= 4 ? "A" : "B");
+    hotels[0]->rooms().back()->setId(room);
+  }
+  hotel::HotelCollection collection(std::move(hotels));
+
+  hotel::PlanningBoard board;
+  board.setSnapshotTrackingEnabled(true);
+  for (auto& reservation : {makeReservation(1, 0, 5), makeReservation(1, 8, 20), makeReservation(2, 3, 10),
+                            makeReservation(3, 0, 2), makeReservation(4, 0, 4), makeReservation(4, 11, 15)})
+    board.addReservation(std::make_unique<hotel::Reservation>(reservation));
+
+  // Room 3 is free from day 2 on, room 4 would leave one night unsold on both sides of the stay
+  auto roomCapacity = [](const hotel::HotelRoom& room) { return room.id() == 3 ? 2 : 4; };
+  hotel::AvailabilitySearch search(collection, board, roomCapacity);
+  hotel::AvailabilitySearch::Query query;
+  query.categoryIds = {1};
+  query.period = date_period(makeDate(5), makeDate(10));
+  auto plans = search.search(query);
+  ASSERT_EQ(2u, plans.size());
+  ASSERT_EQ(3, plans[0].segments[0].roomId);
+  ASSERT_EQ(0, plans[0].orphanedNights);
+  ASSERT_EQ(4, plans[1].segments[0].roomId);
+  ASSERT_EQ(2, plans[1].orphanedNights);
+
+  // Plans with room changes come after all plans without
+  query.maxRoomChanges = 1;
+  plans = search.search(query);
+  ASSERT_EQ(4u, plans.size());
+  ASSERT_EQ(1, plans[2].roomChanges());
+  ASSERT_EQ(1, plans[2].segments[0].roomId);
+  ASSERT_EQ(3, plans[2].segments[1].roomId);
+  ASSERT_EQ(hotel::Day::fromDate(makeDate(8)), plans[2].segments[1].range.begin());
+  ASSERT_EQ(4, plans[3].segments[1].roomId);
+  for (auto& plan : plans)
+  {
+    auto reservation = plan.toReservation("Plan");
+    ASSERT_EQ(query.period, reservation.dateRange());
+    ASSERT_TRUE(board.canAddReservation(reservation));
+  }
+  query.maxPlans = 3;
+  ASSERT_EQ(3u, search.search(query).size());
+
+  // Rooms which are too small for the party or of another category are skipped
+  query.partySize = 3;
+  plans = search.search(query);
+  ASSERT_EQ(2u, plans.size());
+  ASSERT_EQ(4, plans[0].segments[0].roomId);
+  ASSERT_EQ(1, plans[1].segments[0].roomId);
+  ASSERT_EQ(4, plans[1].segments[1].roomId);
+  query.categoryIds = {2};
+  ASSERT_EQ(5, search.search(query).at(0).segments[0].roomId);
+  query.categoryIds = {3};
+  ASSERT_TRUE(search.search(query).empty());
+
+  // Searching on a snapshot gives the same results
+  query.categoryIds = {1, 2};
+  query.partySize = 1;
+  query.maxPlans = 10;
+  hotel::AvailabilitySearch snapshotSearch(collection, board.snapshot(), roomCapacity);
+  auto expected = search.search(query);
+  auto actual = snapshotSearch.search(query);
+  ASSERT_EQ(expected.size(), actual.size());
+  for (std::size_t i = 0; i < expected.size(); ++i)
+    ASSERT_EQ(expected[i].toReservation(""), actual[i].toReservation(""));
+}
+
+TEST_F(HotelPlanning, GroupAllocation)
+{
+  using namespace boost::gregorian;
+
+  // Rows 1-6 are of category A, rows 7-8 of category B. Room 9 is in the second hotel, also of category A.
+  std::vector<std::unique_ptr<hotel::Hotel>> hotels;
+  for (auto name : {"Hotel 1", "Hotel 2"})
+  {
+    hotels.push_back(std::make_unique<hotel::Hotel>(name));
+    hotels.back()->addRoomCategory(std::make_unique<hotel::RoomCategory>("A", "Category A"));
+    hotels.back()->addRoomCategory(std::make_unique<hotel::RoomCategory>("B", "Category B"));
+  }
+  hotels[0]->getCategoryByShortCode("A")->setId(1);
+  hotels[0]->getCategoryByShortCode("B")->setId(2);
+  hotels[1]->getCategoryByShortCode("A")->setId(3);
+  hotels[1]->getCategoryByShortCode("B")->setId(4);
+  for (int room = 1; room <= 8; ++room)
+  {
+    hotels[0]->addRoom(std::make_unique<hotel::HotelRoom>(std::to_string(room)), room <= 6 ? "A" : "B");
+    hotels[0]->rooms().back()->setId(room);
+  }
+  hotels[1]->addRoom(std::make_unique<hotel::HotelRoom>("9"), "A");
+  hotels[1]->rooms().back()->setId(9);
+  hotel::HotelCollection collection(std::move(hotels));
+
+  hotel::PlanningBoard board;
+  board.addReservation(std::make_unique<hotel::Reservation>(makeReservation(2, 0, 5)));
+  board.addReservation(std::make_unique<hotel::Reservation>(makeReservation(7, 4, 8)));
+
+  // The free rooms 3, 4 and 5 are closer together than 1, 3 and 4 (room 2 is occupied)
+  hotel::ThreadPool pool(3);
+  hotel::GroupRequest request;
+  request.period = date_period(makeDate(3), makeDate(10));
+  request.roomsPerCategory = {{1, 3}, {2, 1}};
+  auto allocation = board.allocateGroup(collection, request, pool);
+  ASSERT_TRUE(allocation.succeeded());
+  ASSERT_EQ(std::vector<int>({3, 4, 5, 8}), allocation.roomIds);
+  request.roomsPerCategory = {{1, 4}};
+  ASSERT_EQ(std::vector<int>({3, 4, 5, 6}), board.allocateGroup(collection, request, pool).roomIds);
+
+  auto reservations = allocation.toReservations("Group");
+  ASSERT_EQ(4u, reservations.size());
+  for (auto& reservation : reservations)
+    ASSERT_NE(nullptr, board.addReservation(std::make_unique<hotel::Reservation>(reservation)));
+
+  // Failures explain every category which cannot be accommodated, and do not return any rooms
+  request.roomsPerCategory = {{1, 3}, {2, 1}, {3, 1}, {5, 1}};
+  allocation = board.allocateGroup(collection, request, pool);
+  ASSERT_FALSE(allocation.succeeded());
+  ASSERT_TRUE(allocation.roomIds.empty());
+  ASSERT_EQ("category A (1): 3 rooms requested, but only 2 of 6 rooms are free from 2017-01-04 to 2017-01-11; "
+            "category B (2): 1 rooms requested, but only 0 of 2 rooms are free from 2017-01-04 to 2017-01-11; "
+            "category 5: there are no rooms in this category",
+            allocation.error);
+  request.period = date_period(makeDate(3), makeDate(3));
+  ASSERT_FALSE(board.allocateGroup(collection, request, pool).succeeded());
+
+  // Loops on the pool run every index exactly once, also without workers and when nested
+  for (unsigned threads : {0u, 1u, 4u})
+  {
+    hotel::ThreadPool loopPool(threads);
+    std::vector<std::atomic<int>> calls(1000);
+    loopPool.parallelFor(10, [&](std::size_t i) {
+      loopPool.parallelFor(100, [&](std::size_t j) { ++calls[100 * i + j]; });
+    });
+    ASSERT_TRUE(std::all_of(calls.begin(), calls.end(), [](auto& count) { return count == 1; }));
+    ASSERT_THROW(loopPool.parallelFor(100, [](std::size_t i) { if (i == 42) throw std::runtime_error(""); }),
+                 std::runtime_error);
+  }
+}
+
+TEST_F(HotelPlanning, PlanningOptimizer)
+{
+  using namespace boost::gregorian;
+
+  // Rooms 1-2 are of category A, rooms 3-4 of category B
+  auto hotel = std::make_unique<hotel::Hotel>("Hotel 1");
+  hotel->addRoomCategory(std::make_unique<hotel::RoomCategory>("A", "Category A"));
+  hotel->addRoomCategory(std::make_unique<hotel::RoomCategory>("B", "Category B"));
+  hotel->getCategoryByShortCode("A")->setId(1);
+  hotel->getCategoryByShortCode("B")->setId(2);
+  for (int room = 1; room <= 4; ++room)
+  {
+    hotel->addRoom(std::make_unique<hotel::HotelRoom>(std::to_string(room)), room <= 2 ? "A" : "B");
+    hotel->rooms().back()->setId(room);
+  }
+  hotel::HotelCollection collection;
+  collection.addHotel(std::move(hotel));
+
+  // Room 1 has an orphaned gap of two nights between the first and the second reservation, which disappears if the
+  // second reservation is moved to room 2. The third reservation changes rooms for no reason.
+  auto fillPlanning = [&](hotel::PlanningBoard& board, hotel::Reservation::ReservationStatus status) {
+    board.clear();
+    auto reservations = {makeReservation(1, 0, 5), makeReservation(1, 7, 10), makeReservation(2, 0, 4),
+                         makeReservation(3, 10, 12)};
+    int id = 1;
+    for (auto& reservation : reservations)
+    {
+      auto copy = std::make_unique<hotel::Reservation>(reservation);
+      copy->setId(id++);
+      if (copy->id() == 2)
+        copy->setStatus(status);
+      if (copy->id() == 4)
+        copy->addAtom(4, date_period(makeDate(12), makeDate(15)));
+      board.addReservation(std::move(copy));
+    }
+  };
+
+  hotel::ThreadPool pool(2);
+  hotel::PlanningOptimizer::Options options;
+  options.budget = std::chrono::milliseconds(20);
+
+  hotel::PlanningBoard board;
+  fillPlanning(board, hotel::Reservation::Confirmed);
+
+  // The optimizer works on a copy of the planning, so the board may change in the meantime
+  hotel::PlanningOptimizer optimizer(collection, board);
+  board.clear();
+  fillPlanning(board, hotel::Reservation::Confirmed);
+  auto result = optimizer.optimize(options, pool);
+  ASSERT_EQ(2, result.orphanedNightsBefore);
+  ASSERT_EQ(0, result.orphanedNightsAfter);
+  ASSERT_EQ(1, result.roomChangesBefore);
+  ASSERT_EQ(0, result.roomChangesAfter);
+  ASSERT_EQ(2u, result.changedReservations.size());
+  ASSERT_EQ(2, result.changedReservations[0].id());
+  ASSERT_EQ(2, result.changedReservations[0].atoms()[0].roomId());
+  ASSERT_EQ(date_period(makeDate(7), makeDate(10)), result.changedReservations[0].dateRange());
+  ASSERT_EQ(4, result.changedReservations[1].id());
+  ASSERT_EQ(1u, result.changedReservations[1].atoms().size());
+  ASSERT_EQ(date_period(makeDate(10), makeDate(15)), result.changedReservations[1].dateRange());
+
+  // Applying the changes leaves nothing to improve
+  for (auto& reservation : result.changedReservations)
+  {
+    board.removeReservation(reservation.id());
+    ASSERT_NE(nullptr, board.addReservation(std::make_unique<hotel::Reservation>(reservation)));
+  }
+  ASSERT_TRUE(hotel::PlanningOptimizer(collection, board).optimize(options, pool).changedReservations.empty());
+
+  // Guests which are checked in are never moved
+  fillPlanning(board, hotel::Reservation::CheckedIn);
+  result = hotel::PlanningOptimizer(collection, board).optimize(options, pool);
+  ASSERT_EQ(1u, result.changedReservations.size());
+  ASSERT_EQ(4, result.changedReservations[0].id());
+  ASSERT_EQ(2, result.orphanedNightsAfter);
+}
+
+TEST_F(HotelPlanning, PlanningValidator)
+{
+  using namespace boost::gregorian;
+
+  // Rooms 1-3 exist, room 9 does not
+  auto hotel = std::make_unique<hotel::Hotel>("Hotel 1");
+  hotel->addRoomCategory(std::make_unique<hotel::RoomCategory>("A", "Category A"));
+  for (int room = 1; room <= 3; ++room)
+  {
+    hotel->addRoom(std::make_unique<hotel::HotelRoom>(std::to_string(room)), "A");
+    hotel->rooms().back()->setId(room);
+  }
+  hotel::HotelCollection collection;
+  collection.addHotel(std::move(hotel));
+  hotel::PlanningValidator validator(collection);
+  hotel::ThreadPool pool(2);
+
+  auto day = hotel::Day::fromDate(makeDate(0));
+  std::vector<hotel::AtomRecord> atoms = {
+      {1, 1, 1, hotel::DayRange(day, day + 5)},       // Overlaps reservations 2 and 3
+      {2, 2, 1, hotel::DayRange(day + 2, day + 4)},   // Overlaps reservation 1
+      {3, 3, 1, hotel::DayRange(day + 4, day + 6)},   // Overlaps reservation 1
+      {3, 4, 2, hotel::DayRange(day + 7, day + 9)},   // Does not continue atom 3
+      {4, 5, 9, hotel::DayRange(day, day + 5)},       // Dangling room
+      {5, 6, 3, hotel::DayRange(day + 3, day + 3)},   // Empty
+      {6, 7, 3, hotel::DayRange(day, day + 3)},       // Valid continuation
+      {6, 8, 2, hotel::DayRange(day + 3, day + 7)}};
+  auto issues = validator.validate(atoms, pool);
+
+  std::vector<std::tuple<hotel::PlanningIssue::Kind, int, int>> summary;
+  for (auto& issue : issues)
+    summary.emplace_back(issue.kind, issue.atom.atomId, issue.other.atomId);
+  ASSERT_EQ((std::vector<std::tuple<hotel::PlanningIssue::Kind, int, int>>{
+                {hotel::PlanningIssue::Overlap, 2, 1},
+                {hotel::PlanningIssue::Overlap, 3, 1},
+                {hotel::PlanningIssue::InvalidContinuation, 4, 3},
+                {hotel::PlanningIssue::EmptyRange, 6, 0},
+                {hotel::PlanningIssue::DanglingRoom, 5, 0}}),
+            summary);
+  ASSERT_EQ("reservation 2 (atom 2, 2017-01-03 to 2017-01-05) overlaps reservation 1 (atom 1, 2017-01-01 to "
+            "2017-01-06) in room 1",
+            issues[0].toString());
+  ASSERT_EQ("reservation 4: atom 5 (2017-01-01 to 2017-01-06) refers to room 9, which does not exist",
+            issues[4].toString());
+
+  // Reservations which can be loaded into the planning board have no issues
+  std::vector<hotel::Reservation> reservations = {makeReservation(1, 0, 5), makeReservation(1, 5, 7),
+                                                  makeReservation(2, 0, 7)};
+  reservations[1].addAtom(3, date_period(makeDate(7), makeDate(9)));
+  for (std::size_t i = 0; i < reservations.size(); ++i)
+    reservations[i].setId(static_cast<int>(i + 1));
+  ASSERT_TRUE(validator.validate(reservations, pool).empty());
+}
+
+TEST_F(HotelPlanning, OccupancyAnalytics)
+{
+  // Hotel 10 has the categories 1 (rooms 1-2) and 2 (room 3), hotel 20 has category 3 (room 4). Room 9 is unknown.
+  std::vector<std::unique_ptr<hotel::Hotel>> hotels;
+  for (auto hotelId : {10, 20})
+  {
+    hotels.push_back(std::make_unique<hotel::Hotel>("Hotel " + std::to_string(hotelId)));
+    hotels.back()->setId(hotelId);
+  }
+  auto addRoom = [&hotels](int hotel, int categoryId, int roomId) {
+    auto shortCode = std::to_string(categoryId);
+    if (hotels[hotel]->getCategoryByShortCode(shortCode) == nullptr)
+    {
+      hotels[hotel]->addRoomCategory(std::make_unique<hotel::RoomCategory>(shortCode, shortCode));
+      hotels[hotel]->getCategoryByShortCode(shortCode)->setId(categoryId);
+    }
+    hotels[hotel]->addRoom(std::make_unique<hotel::HotelRoom>(std::to_string(roomId)), shortCode);
+    hotels[hotel]->rooms().back()->setId(roomId);
+  };
+  addRoom(0, 1, 1);
+  addRoom(0, 1, 2);
+  addRoom(0, 2, 3);
+  addRoom(1, 3, 4);
+  hotel::HotelCollection collection(std::move(hotels));
+  std::map<int, int> roomCategories = {{1, 1}, {2, 1}, {3, 2}, {4, 3}};
+  std::map<int, int> categoryHotels = {{1, 10}, {2, 10}, {3, 20}};
+
+  // Counts the occupied nights by going through all reservations
+  auto countNights = [&](const hotel::PlanningBoard& board, hotel::DayRange range, auto&& roomFilter) {
+    int64_t nights = 0;
+    for (auto reservation : board.reservations())
+      for (auto& atom : reservation->atoms())
+        if (roomFilter(atom.roomId()))
+        {
+          auto begin = std::max(range.begin(), atom.dayRange().begin());
+          auto end = std::min(range.end(), atom.dayRange().end());
+          nights += std::max(0, end - begin);
+        }
+    return nights;
+  };
+  auto checkAnalytics = [&](const hotel::PlanningBoard& board) {
+    auto& analytics = board.occupancyAnalytics();
+    auto anyRoom = [](int) { return true; };
+    auto day = hotel::Day::fromDate(makeDate(0));
+    for (int from = -5; from < 120; from += 7)
+    {
+      auto range = hotel::DayRange(day + from, day + from + 30);
+      ASSERT_EQ(countNights(board, range, anyRoom), analytics.occupiedNights(range));
+      for (auto& category : categoryHotels)
+      {
+        auto inCategory = [&](int room) {
+          return roomCategories.count(room) && roomCategories[room] == category.first;
+        };
+        ASSERT_EQ(countNights(board, range, inCategory), analytics.occupiedNightsInCategory(category.first, range));
+      }
+      for (auto hotelId : {10, 20})
+      {
+        auto inHotel = [&](int room) {
+          return roomCategories.count(room) && categoryHotels[roomCategories[room]] == hotelId;
+        };
+        ASSERT_EQ(countNights(board, range, inHotel), analytics.occupiedNightsInHotel(hotelId, range));
+      }
+    }
+    ASSERT_EQ(0, analytics.occupiedNightsInHotel(30, hotel::DayRange(day, day + 100)));
+  };
+
+  hotel::PlanningBoard board;
+  ASSERT_FALSE(board.isOccupancyAnalyticsEnabled());
+  ASSERT_THROW(board.occupancyAnalytics(), std::logic_error);
+  board.addReservation(std::make_unique<hotel::Reservation>(makeReservation(1, 40, 45)));
+  board.enableOccupancyAnalytics(collection);
+  ASSERT_TRUE(board.isOccupancyAnalyticsEnabled());
+  checkAnalytics(board);
+
+  // The analytics follow the planning board, also beyond the days they initially covered
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<> roomDist(0, 4);
+  std::uniform_int_distribution<> dayDist(0, 110);
+  std::uniform_int_distribution<> lengthDist(1, 10);
+  for (int i = 0; i < 200; ++i)
+  {
+    auto room = std::vector<int>{1, 2, 3, 4, 9}[roomDist(rng)];
+    auto from = dayDist(rng);
+    auto reservation = makeReservation(room, from, from + lengthDist(rng));
+    reservation.setId(i + 1);
+    if (board.canAddReservation(reservation))
+      board.addReservation(std::make_unique<hotel::Reservation>(reservation));
+  }
+  for (int id = 1; id <= 200; id += 3)
+    board.removeReservation(id);
+  checkAnalytics(board);
+
+  // Rebuilding from scratch gives the same result, as does copying the planning board
+  hotel::ThreadPool pool(2);
+  board.enableOccupancyAnalytics(collection, pool);
+  checkAnalytics(board);
+  hotel::PlanningBoard copy;
+  copy = board;
+  checkAnalytics(copy);
+
+  board.clear();
+  checkAnalytics(board);
+  board.disableOccupancyAnalytics();
+  ASSERT_FALSE(board.isOccupancyAnalyticsEnabled());
+}
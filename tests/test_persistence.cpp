@@ -5,14 +5,20 @@
 #include "persistence/backend.h"
 #include "persistence/changequeue.h"
 #include "persistence/sqlite/sqlitebackend.h"
+#include "persistence/sqlite/sqlitemirror.h"
+#include "persistence/sqlite/sqlitestorage.h"
 #include "persistence/op/operations.h"
 #include "persistence/json/jsonserializer.h"
 #include "persistence/net/netclientbackend.h"
 
 #include "hotel/hotelcollection.h"
+#include "hotel/planning.h"
 
+#include <algorithm>
 #include <condition_variable>
 #include <chrono>
+#include <cstdio>
+#include <map>
 #include <thread>
 
 void waitForStreamInitialization(persistence::Backend& backend)
@@ -138,6 +144,878 @@ TEST_F(Persistence, ReservationPersistence)
   }
 }
 
+TEST_F(Persistence, GroupAllocation)
+{
+  using namespace boost::gregorian;
+  persistence::sqlite::SqliteBackend backend("test.db");
+  persistence::VectorDataStreamObserver<hotel::Hotel> hotels;
+  auto hotelsStreamHandle = backend.createStreamTyped(&hotels);
+  storeHotel(backend, makeNewHotel("Hotel 1", "Category 1", 10));
+
+  hotel::HotelCollection collection;
+  collection.addHotel(std::make_unique<hotel::Hotel>(hotels.items()[0]));
+  hotel::GroupRequest request;
+  request.period = date_period(date(2017, 1, 1), date(2017, 1, 8));
+  request.roomsPerCategory[hotels.items()[0].categories()[0]->id()] = 4;
+  hotel::PlanningBoard board;
+  auto allocation = board.allocateGroup(collection, request);
+  ASSERT_TRUE(allocation.succeeded());
+
+  // All rooms of the group are stored in a single transaction
+  persistence::VectorDataStreamObserver<hotel::Reservation> reservations;
+  auto reservationsStreamHandle = backend.createStreamTyped(&reservations);
+  auto future = backend.queueOperations(persistence::op::storeGroupAllocation(allocation, "Group"));
+  future.wait();
+  backend.changeQueue().applyStreamChanges();
+  ASSERT_EQ(4u, reservations.items().size());
+  for (auto& reservation : reservations.items())
+  {
+    ASSERT_EQ("Group", reservation.description());
+    ASSERT_EQ(request.period, reservation.dateRange());
+  }
+
+  request.roomsPerCategory.begin()->second = 11;
+  ASSERT_THROW(persistence::op::storeGroupAllocation(board.allocateGroup(collection, request), "Group"),
+               std::invalid_argument);
+}
+
+TEST_F(Persistence, PlanningValidator)
+{
+  // The storage does not check for conflicts, so overlapping reservations can end up in the database
+  auto hotel = makeNewHotel("Hotel 1", "Category 1", 2);
+  auto reservation1 = makeNewReservation("Reservation 1", 0);
+  auto reservation2 = makeNewReservation("Reservation 2", 0);
+  {
+    persistence::sqlite::SqliteStorage storage("test.db");
+    storage.storeNewHotel(hotel);
+    reservation1.atoms()[0].setRoomId(hotel.rooms()[0]->id());
+    reservation2.atoms()[0].setRoomId(hotel.rooms()[0]->id());
+    storage.storeNewReservationAndAtoms(reservation1);
+    storage.storeNewReservationAndAtoms(reservation2);
+  }
+
+  persistence::sqlite::SqliteStorage storage("test.db");
+  hotel::HotelCollection collection;
+  collection.addHotel(std::make_unique<hotel::Hotel>(storage.loadAll<hotel::Hotel>()[0]));
+  auto atoms = storage.loadAll<hotel::AtomRecord>();
+  ASSERT_EQ(2u, atoms.size());
+  auto issues = hotel::PlanningValidator(collection).validate(atoms);
+  ASSERT_EQ(1u, issues.size());
+  ASSERT_EQ(hotel::PlanningIssue::Overlap, issues[0].kind);
+  ASSERT_EQ(reservation2.id(), issues[0].atom.reservationId);
+  ASSERT_EQ(reservation1.id(), issues[0].other.reservationId);
+}
+
+TEST_F(Persistence, ArchivedReservations)
+{
+  nlohmann::json january;
+  january["from"] = "2017-01-05";
+  january["to"] = "2017-01-06";
+  nlohmann::json february;
+  february["from"] = "2017-02-01";
+  february["to"] = "2017-03-01";
+  auto updateReservation = [](persistence::Backend& backend, const hotel::Reservation& reservation) {
+    auto task = backend.queueOperation(persistence::op::Update{std::make_unique<hotel::Reservation>(reservation)});
+    ASSERT_EQ(persistence::TaskResultStatus::Successful, task.get()[0].status);
+    backend.changeQueue().applyStreamChanges();
+  };
+
+  {
+    persistence::sqlite::SqliteBackend backend("test.db");
+    persistence::VectorDataStreamObserver<hotel::Hotel> hotels;
+    persistence::VectorDataStreamObserver<hotel::Reservation> reservations;
+    auto hotelsStreamHandle = backend.createStreamTyped(&hotels);
+    auto reservationsStreamHandle = backend.createStreamTyped(&reservations);
+    storeHotel(backend, makeNewHotel("Hotel 1", "Category 1", 10));
+
+    // Archived reservations are not part of the default stream
+    storeReservation(backend, makeNewReservation("Planned", hotels.items()[0].rooms()[0]->id()));
+    auto archived = makeNewReservation("Archived", hotels.items()[0].rooms()[1]->id());
+    archived.setStatus(hotel::Reservation::Archived);
+    storeReservation(backend, archived);
+    ASSERT_EQ(1u, reservations.items().size());
+    ASSERT_EQ("Planned", reservations.items()[0].description());
+
+    persistence::VectorDataStreamObserver<hotel::Reservation> archivedInJanuary;
+    persistence::VectorDataStreamObserver<hotel::Reservation> archivedInFebruary;
+    auto januaryStreamHandle = backend.createStreamTyped(&archivedInJanuary, "reservation.archived", january);
+    auto februaryStreamHandle = backend.createStreamTyped(&archivedInFebruary, "reservation.archived", february);
+    waitForStreamInitialization(backend);
+    ASSERT_EQ(1u, archivedInJanuary.items().size());
+    ASSERT_EQ("Archived", archivedInJanuary.items()[0].description());
+    ASSERT_EQ(0u, archivedInFebruary.items().size());
+
+    // Archiving a reservation moves it from one stream to the other, and back again when it is restored
+    auto planned = reservations.items()[0];
+    planned.setStatus(hotel::Reservation::Archived);
+    updateReservation(backend, planned);
+    ASSERT_EQ(0u, reservations.items().size());
+    ASSERT_EQ(2u, archivedInJanuary.items().size());
+
+    planned = archivedInJanuary.items()[1];
+    planned.setStatus(hotel::Reservation::CheckedOut);
+    updateReservation(backend, planned);
+    ASSERT_EQ(1u, reservations.items().size());
+    ASSERT_EQ(planned, reservations.items()[0]);
+    ASSERT_EQ(1u, archivedInJanuary.items().size());
+  }
+
+  // Reservations which ended before the horizon are archived when the backend starts
+  {
+    persistence::sqlite::SqliteBackend backend("test.db", 30);
+    persistence::VectorDataStreamObserver<hotel::Reservation> reservations;
+    persistence::VectorDataStreamObserver<hotel::Reservation> archivedInJanuary;
+    auto reservationsStreamHandle = backend.createStreamTyped(&reservations);
+    auto januaryStreamHandle = backend.createStreamTyped(&archivedInJanuary, "reservation.archived", january);
+    waitForStreamInitialization(backend);
+    ASSERT_EQ(0u, reservations.items().size());
+    ASSERT_EQ(2u, archivedInJanuary.items().size());
+
+    // Archived reservations can still be loaded and deleted by id
+    auto archivedId = archivedInJanuary.items()[0].id();
+    persistence::VectorDataStreamObserver<hotel::Reservation> reservation;
+    nlohmann::json streamOptions;
+    streamOptions["id"] = archivedId;
+    auto reservationStreamHandle = backend.createStreamTyped(&reservation, "reservation.by_id", streamOptions);
+    waitForStreamInitialization(backend);
+    ASSERT_EQ(1u, reservation.items().size());
+    ASSERT_EQ(archivedInJanuary.items()[0], reservation.items()[0]);
+
+    auto task = backend.queueOperation(persistence::op::Delete{persistence::op::StreamableType::Reservation, archivedId});
+    task.wait();
+    backend.changeQueue().applyStreamChanges();
+    ASSERT_EQ(1u, archivedInJanuary.items().size());
+    ASSERT_EQ(0u, reservation.items().size());
+  }
+
+  persistence::sqlite::SqliteStorage storage("test.db");
+  ASSERT_EQ(1u, storage.loadArchivedReservations(hotel::DayRange(hotel::Day::fromYmd(2017, 1, 1),
+                                                                 hotel::Day::fromYmd(2017, 2, 1))).size());
+  ASSERT_EQ(0u, storage.loadAll<hotel::Reservation>().size());
+  ASSERT_EQ(0u, storage.loadAll<hotel::AtomRecord>().size());
+  ASSERT_EQ(1u, storage.loadAllArchivedAtoms().size());
+}
+
+TEST_F(Persistence, ArchivedReservationsHeldByStreams)
+{
+  using namespace boost::gregorian;
+  persistence::sqlite::SqliteStorage storage("test.db");
+  auto hotel = makeNewHotel("Hotel 1", "Category 1", 1);
+  storage.storeNewHotel(hotel);
+  auto inJanuary = makeNewReservation("January", hotel.rooms()[0]->id());
+  inJanuary.setStatus(hotel::Reservation::Archived);
+  storage.storeNewReservationAndAtoms(inJanuary);
+  hotel::Reservation inFebruary("February", hotel.rooms()[0]->id(), date_period(date(2017, 2, 1), date(2017, 2, 5)));
+  inFebruary.setStatus(hotel::Reservation::Archived);
+  storage.storeNewReservationAndAtoms(inFebruary);
+
+  // The first two streams share their initial data
+  auto rangeOptions = [](const std::string& from, const std::string& to) {
+    nlohmann::json options;
+    options["from"] = from;
+    options["to"] = to;
+    return options;
+  };
+  persistence::ChangeQueue changeQueue;
+  persistence::detail::DataStreamManager manager;
+  std::vector<persistence::VectorDataStreamObserver<hotel::Reservation>> observers(3);
+  std::vector<std::shared_ptr<persistence::DataStream>> streams;
+  for (std::size_t i = 0; i < observers.size(); ++i)
+  {
+    auto options = i < 2 ? rangeOptions("2017-01-01", "2017-02-01") : rangeOptions("2017-02-01", "2017-03-01");
+    streams.push_back(std::make_shared<persistence::DataStream>(persistence::StreamableType::Reservation,
+                                                                "reservation.archived", options));
+    streams.back()->connect(static_cast<int>(i) + 1, &observers[i]);
+    changeQueue.addStream(streams.back());
+    manager.addNewStream(streams.back());
+  }
+  manager.initialize(changeQueue, storage);
+  changeQueue.applyStreamChanges();
+  ASSERT_EQ(1u, manager.savedInitialLoads());
+
+  // Growing the range only sends the reservations which enter it
+  hotel::Reservation inMarch("March", hotel.rooms()[0]->id(), date_period(date(2017, 3, 1), date(2017, 3, 5)));
+  inMarch.setStatus(hotel::Reservation::Archived);
+  storage.storeNewReservationAndAtoms(inMarch);
+  std::vector<persistence::DataStreamDifferential> changes;
+  manager.addItems(changes, persistence::StreamableType::Reservation, std::vector<hotel::Reservation>{inMarch});
+  ASSERT_TRUE(changes.empty());
+  manager.changeStreamOptions(streams[2], rangeOptions("2017-02-01", "2017-04-01"));
+  manager.applyOptionChanges(changeQueue, storage);
+  changeQueue.applyStreamChanges();
+  ASSERT_EQ(2u, observers[2].items().size());
+  ASSERT_EQ("March", observers[2].items()[1].description());
+
+  // Removals are only sent to the streams which hold the reservation
+  auto removedFrom = [&changes]() {
+    std::vector<int> streamIds;
+    for (auto& change : changes)
+      if (std::holds_alternative<persistence::DataStreamItemsRemoved>(change.change))
+        streamIds.push_back(change.streamId);
+    std::sort(streamIds.begin(), streamIds.end());
+    changes.clear();
+    return streamIds;
+  };
+  auto restored = inFebruary;
+  restored.setStatus(hotel::Reservation::CheckedOut);
+  manager.updateItems(changes, persistence::StreamableType::Reservation, std::vector<hotel::Reservation>{restored});
+  ASSERT_EQ(std::vector<int>({3}), removedFrom());
+  manager.removeItems(changes, persistence::StreamableType::Reservation, {inJanuary.id()});
+  ASSERT_EQ(std::vector<int>({1, 2}), removedFrom());
+  manager.removeItems(changes, persistence::StreamableType::Reservation, {inJanuary.id(), inFebruary.id()});
+  ASSERT_TRUE(changes.empty());
+  manager.removeItems(changes, persistence::StreamableType::Reservation, {inMarch.id()});
+  ASSERT_EQ(std::vector<int>({3}), removedFrom());
+}
+
+TEST_F(Persistence, ReservationsByPeriod)
+{
+  class RemovalObserver : public persistence::VectorDataStreamObserver<hotel::Reservation>
+  {
+  public:
+    virtual void removeItems(const std::vector<int>& ids) override
+    {
+      std::copy(ids.begin(), ids.end(), std::back_inserter(removedIds));
+      VectorDataStreamObserver<hotel::Reservation>::removeItems(ids);
+    }
+
+    std::vector<int> removedIds;
+  };
+
+  auto makeOptions = [](const std::string& from, const std::string& to) {
+    nlohmann::json options;
+    options["from"] = from;
+    options["to"] = to;
+    return options;
+  };
+  auto makeReservation = [](const std::string& description, int roomId, hotel::Day from, int nights) {
+    hotel::Reservation reservation(description, roomId, hotel::DayRange(from, from + nights));
+    reservation.setStatus(hotel::Reservation::New);
+    return reservation;
+  };
+  auto updateReservation = [](persistence::Backend& backend, const hotel::Reservation& reservation) {
+    auto task = backend.queueOperation(persistence::op::Update{std::make_unique<hotel::Reservation>(reservation)});
+    ASSERT_EQ(persistence::TaskResultStatus::Successful, task.get()[0].status);
+    backend.changeQueue().applyStreamChanges();
+  };
+  auto descriptions = [](const persistence::VectorDataStreamObserver<hotel::Reservation>& stream) {
+    std::vector<std::string> result;
+    for (auto& reservation : stream.items())
+      result.push_back(reservation.description());
+    std::sort(result.begin(), result.end());
+    return result;
+  };
+  typedef std::vector<std::string> Descriptions;
+
+  persistence::sqlite::SqliteBackend backend("test.db");
+  persistence::VectorDataStreamObserver<hotel::Hotel> hotels;
+  auto hotelsStreamHandle = backend.createStreamTyped(&hotels);
+  storeHotel(backend, makeNewHotel("Hotel 1", "Category 1", 3));
+  std::vector<int> roomIds;
+  for (auto& room : hotels.items()[0].rooms())
+    roomIds.push_back(room->id());
+
+  storeReservation(backend, makeReservation("A", roomIds[0], hotel::Day::fromYmd(2017, 1, 1), 10));
+  storeReservation(backend, makeReservation("B", roomIds[1], hotel::Day::fromYmd(2017, 2, 1), 4));
+  storeReservation(backend, makeReservation("C", roomIds[2], hotel::Day::fromYmd(2017, 3, 1), 4));
+
+  persistence::VectorDataStreamObserver<hotel::Reservation> january;
+  RemovalObserver lastRooms;
+  auto januaryStreamHandle =
+      backend.createStreamTyped(&january, "reservation.by_period", makeOptions("2017-01-01", "2017-02-01"));
+  auto lastRoomsOptions = makeOptions("2017-01-01", "2017-04-01");
+  lastRoomsOptions["rooms"] = {roomIds[1], roomIds[2]};
+  auto lastRoomsStreamHandle = backend.createStreamTyped(&lastRooms, "reservation.by_period", lastRoomsOptions);
+  waitForStreamInitialization(backend);
+  ASSERT_EQ(Descriptions({"A"}), descriptions(january));
+  ASSERT_EQ(Descriptions({"B", "C"}), descriptions(lastRooms));
+
+  // Only changes within the window are forwarded
+  storeReservation(backend, makeReservation("D", roomIds[0], hotel::Day::fromYmd(2017, 1, 20), 2));
+  ASSERT_EQ(Descriptions({"A", "D"}), descriptions(january));
+  ASSERT_EQ(Descriptions({"B", "C"}), descriptions(lastRooms));
+
+  // Reservations which are moved into the window are added, reservations which are moved out of it are removed
+  auto b = lastRooms.items()[0].description() == "B" ? lastRooms.items()[0] : lastRooms.items()[1];
+  auto movedB = makeReservation("B", roomIds[1], hotel::Day::fromYmd(2017, 1, 25), 2);
+  movedB.setId(b.id());
+  movedB.setRevision(b.revision());
+  movedB.atoms()[0].setId(b.atoms()[0].id());
+  updateReservation(backend, movedB);
+  ASSERT_EQ(Descriptions({"A", "B", "D"}), descriptions(january));
+  ASSERT_EQ(Descriptions({"B", "C"}), descriptions(lastRooms));
+
+  auto a = *std::find_if(january.items().begin(), january.items().end(),
+                         [](auto& reservation) { return reservation.description() == "A"; });
+  auto movedA = makeReservation("A", roomIds[0], hotel::Day::fromYmd(2017, 4, 1), 10);
+  movedA.setId(a.id());
+  movedA.setRevision(a.revision());
+  movedA.atoms()[0].setId(a.atoms()[0].id());
+  updateReservation(backend, movedA);
+  ASSERT_EQ(Descriptions({"B", "D"}), descriptions(january));
+
+  // Moving the window only sends the reservations which enter or leave it
+  januaryStreamHandle.changeOptions(makeOptions("2017-01-21", "2017-04-02"));
+  backend.queueOperations({}).wait();
+  backend.changeQueue().applyStreamChanges();
+  ASSERT_EQ(Descriptions({"A", "B", "C", "D"}), descriptions(january));
+  januaryStreamHandle.changeOptions(makeOptions("2017-03-01", "2017-05-01"));
+  backend.queueOperations({}).wait();
+  backend.changeQueue().applyStreamChanges();
+  ASSERT_EQ(Descriptions({"A", "C"}), descriptions(january));
+
+  auto c = *std::find_if(january.items().begin(), january.items().end(),
+                         [](auto& reservation) { return reservation.description() == "C"; });
+  auto task = backend.queueOperation(persistence::op::Delete{persistence::op::StreamableType::Reservation, c.id()});
+  task.wait();
+  backend.changeQueue().applyStreamChanges();
+  ASSERT_EQ(Descriptions({"A"}), descriptions(january));
+  ASSERT_EQ(Descriptions({"B"}), descriptions(lastRooms));
+
+  // Removals are only sent for reservations the stream holds, A never was in the last rooms
+  ASSERT_EQ(std::vector<int>({c.id()}), lastRooms.removedIds);
+}
+
+TEST_F(Persistence, ChunkedStreamInitialization)
+{
+  class ChunkObserver : public persistence::VectorDataStreamObserver<hotel::Reservation>
+  {
+  public:
+    virtual void addItems(const std::vector<hotel::Reservation>& items) override
+    {
+      chunkSizes.push_back(items.size());
+      VectorDataStreamObserver<hotel::Reservation>::addItems(items);
+    }
+
+    std::vector<std::size_t> chunkSizes;
+  };
+
+  // Without readers, the chunks are sent by the worker thread itself
+  persistence::sqlite::SqliteBackend backend("test.db", std::nullopt, 0);
+  persistence::VectorDataStreamObserver<hotel::Hotel> hotels;
+  persistence::VectorDataStreamObserver<hotel::Reservation> reservations;
+  auto hotelsStreamHandle = backend.createStreamTyped(&hotels);
+  auto reservationsStreamHandle = backend.createStreamTyped(&reservations);
+  storeHotel(backend, makeNewHotel("Hotel 1", "Category 1", 1));
+  auto roomId = hotels.items()[0].rooms()[0]->id();
+  for (int i = 0; i < 25; ++i)
+  {
+    auto from = hotel::Day::fromYmd(2017, 1, 1) + 10 * i;
+    storeReservation(backend, hotel::Reservation("Reservation " + std::to_string(i), roomId,
+                                                 hotel::DayRange(from, from + 5)));
+  }
+  ASSERT_EQ(25u, reservations.items().size());
+
+  // Writes are executed between the chunks, without sending changes of reservations twice
+  nlohmann::json options;
+  options["chunk_size"] = 10;
+  ChunkObserver chunkedReservations;
+  auto chunkedStreamHandle = backend.createStreamTyped(&chunkedReservations, "", options);
+  auto updated = reservations.items().back();
+  updated.setDescription("Updated");
+  auto task = backend.queueOperation(persistence::op::Update{std::make_unique<hotel::Reservation>(updated)});
+  storeReservation(backend, hotel::Reservation("New", roomId, hotel::DayRange(hotel::Day::fromYmd(2018, 1, 1),
+                                                                               hotel::Day::fromYmd(2018, 1, 5))));
+  ASSERT_EQ(persistence::TaskResultStatus::Successful, task.get()[0].status);
+  waitForStreamInitialization(backend);
+  backend.changeQueue().applyStreamChanges();
+
+  ASSERT_EQ(26u, chunkedReservations.items().size());
+  std::vector<int> ids;
+  for (auto& reservation : chunkedReservations.items())
+    ids.push_back(reservation.id());
+  std::sort(ids.begin(), ids.end());
+  ASSERT_EQ(ids.end(), std::adjacent_find(ids.begin(), ids.end()));
+  ASSERT_EQ(1, std::count_if(chunkedReservations.items().begin(), chunkedReservations.items().end(),
+                             [](auto& reservation) { return reservation.description() == "Updated"; }));
+  ASSERT_LE(3u, chunkedReservations.chunkSizes.size());
+  for (auto chunkSize : chunkedReservations.chunkSizes)
+    ASSERT_GE(10u, chunkSize);
+
+  // A reservation without atoms is not sent, and does not end the initialization early
+  sqlite3* db = nullptr;
+  ASSERT_EQ(SQLITE_OK, sqlite3_open("test.db", &db));
+  auto deleteAtoms = "DELETE FROM h_reservation_atom WHERE reservation_id = " + std::to_string(ids[1]) + ";";
+  ASSERT_EQ(SQLITE_OK, sqlite3_exec(db, deleteAtoms.c_str(), nullptr, nullptr, nullptr));
+  sqlite3_close(db);
+
+  persistence::sqlite::SqliteStorage storage("test.db");
+  persistence::ChangeQueue changeQueue;
+  persistence::detail::DataStreamManager manager;
+  options["chunk_size"] = 2;
+  ChunkObserver pairs;
+  auto stream = std::make_shared<persistence::DataStream>(persistence::StreamableType::Reservation, "", options);
+  stream->connect(1, &pairs);
+  changeQueue.addStream(stream);
+  manager.addNewStream(stream);
+  manager.initialize(changeQueue, storage);
+  while (manager.isInitializingStreams())
+    manager.initialize(changeQueue, storage);
+  changeQueue.applyStreamChanges();
+  ASSERT_EQ(25u, pairs.items().size());
+  ASSERT_EQ(13u, pairs.chunkSizes.size());
+}
+
+TEST_F(Persistence, ParallelStreamInitialization)
+{
+  auto reservationsById = [](const std::vector<hotel::Reservation>& reservations) {
+    std::map<int, std::string> result;
+    for (auto& reservation : reservations)
+      result[reservation.id()] = reservation.description();
+    return result;
+  };
+
+  persistence::sqlite::SqliteBackend backend("test.db", std::nullopt, 2);
+  persistence::VectorDataStreamObserver<hotel::Hotel> hotels;
+  persistence::VectorDataStreamObserver<hotel::Reservation> reservations;
+  auto hotelsStreamHandle = backend.createStreamTyped(&hotels);
+  auto reservationsStreamHandle = backend.createStreamTyped(&reservations);
+  storeHotel(backend, makeNewHotel("Hotel 1", "Category 1", 1));
+  auto roomId = hotels.items()[0].rooms()[0]->id();
+  for (int i = 0; i < 30; ++i)
+  {
+    auto from = hotel::Day::fromYmd(2017, 1, 1) + 10 * i;
+    storeReservation(backend, hotel::Reservation("Reservation " + std::to_string(i), roomId,
+                                                 hotel::DayRange(from, from + 5)));
+  }
+
+  // More streams than readers, initialized while the database is written to
+  nlohmann::json options;
+  options["chunk_size"] = 4;
+  std::vector<persistence::VectorDataStreamObserver<hotel::Reservation>> streams(6);
+  std::vector<persistence::UniqueDataStreamHandle> streamHandles;
+  auto updated = reservations.items()[20];
+  updated.setDescription("Updated");
+  auto removedId = reservations.items()[3].id();
+  for (auto& stream : streams)
+  {
+    streamHandles.push_back(backend.createStreamTyped(&stream, "", options));
+    if (streamHandles.size() == 2)
+      backend.queueOperation(persistence::op::Update{std::make_unique<hotel::Reservation>(updated)});
+    if (streamHandles.size() == 4)
+      backend.queueOperation(persistence::op::Delete{persistence::op::StreamableType::Reservation, removedId});
+  }
+  storeReservation(backend, hotel::Reservation("New", roomId, hotel::DayRange(hotel::Day::fromYmd(2018, 1, 1),
+                                                                               hotel::Day::fromYmd(2018, 1, 5))));
+  waitForStreamInitialization(backend);
+  backend.queueOperations({}).wait();
+  backend.changeQueue().applyStreamChanges();
+
+  auto expected = reservationsById(reservations.items());
+  ASSERT_EQ(30u, expected.size());
+  ASSERT_EQ("Updated", expected[updated.id()]);
+  ASSERT_EQ(0u, expected.count(removedId));
+  for (auto& stream : streams)
+  {
+    ASSERT_EQ(expected.size(), stream.items().size());
+    ASSERT_EQ(expected, reservationsById(stream.items()));
+  }
+
+  // Readers rely on the write-ahead log for their snapshots
+  sqlite3* db = nullptr;
+  ASSERT_EQ(SQLITE_OK, sqlite3_open("test.db", &db));
+  sqlite3_stmt* statement = nullptr;
+  sqlite3_prepare_v2(db, "PRAGMA journal_mode;", -1, &statement, nullptr);
+  ASSERT_EQ(SQLITE_ROW, sqlite3_step(statement));
+  ASSERT_EQ(std::string("wal"), reinterpret_cast<const char*>(sqlite3_column_text(statement, 0)));
+  sqlite3_finalize(statement);
+  sqlite3_close(db);
+}
+
+TEST_F(Persistence, SharedStreamInitialization)
+{
+  persistence::sqlite::SqliteStorage storage("test.db");
+  auto hotel = makeNewHotel("Hotel 1", "Category 1", 1);
+  storage.storeNewHotel(hotel);
+  storage.beginTransaction();
+  for (int i = 0; i < 10; ++i)
+  {
+    auto reservation = makeNewReservation("Reservation " + std::to_string(i), hotel.rooms()[0]->id());
+    storage.storeNewReservationAndAtoms(reservation);
+  }
+  storage.commitTransaction();
+
+  // Three streams wait for the same data, the last one has different options
+  nlohmann::json options;
+  options["chunk_size"] = 4;
+  nlohmann::json otherOptions;
+  otherOptions["chunk_size"] = 5;
+  persistence::ChangeQueue changeQueue;
+  persistence::detail::DataStreamManager manager;
+  std::vector<persistence::VectorDataStreamObserver<hotel::Reservation>> observers(4);
+  std::vector<std::shared_ptr<persistence::DataStream>> streams;
+  for (std::size_t i = 0; i < observers.size(); ++i)
+  {
+    streams.push_back(std::make_shared<persistence::DataStream>(persistence::StreamableType::Reservation, "",
+                                                                i < 3 ? options : otherOptions));
+    streams.back()->connect(static_cast<int>(i) + 1, &observers[i]);
+    changeQueue.addStream(streams.back());
+    manager.addNewStream(streams.back());
+  }
+
+  manager.initialize(changeQueue, storage);
+  while (manager.isInitializingStreams())
+    manager.initialize(changeQueue, storage);
+  changeQueue.applyStreamChanges();
+
+  for (std::size_t i = 0; i < observers.size(); ++i)
+  {
+    ASSERT_TRUE(streams[i]->isInitialized());
+    ASSERT_EQ(10u, observers[i].items().size());
+  }
+  // Each of the three chunks has been loaded once for the identical streams
+  ASSERT_EQ(6u, manager.savedInitialLoads());
+
+  // Loading the chunks from a mirror counts the same way
+  persistence::sqlite::SqliteMirror mirror;
+  mirror.load(storage);
+  std::vector<persistence::VectorDataStreamObserver<hotel::Reservation>> mirroredObservers(2);
+  for (std::size_t i = 0; i < mirroredObservers.size(); ++i)
+  {
+    streams.push_back(std::make_shared<persistence::DataStream>(persistence::StreamableType::Reservation, "", options));
+    streams.back()->connect(static_cast<int>(streams.size()), &mirroredObservers[i]);
+    changeQueue.addStream(streams.back());
+    manager.addNewStream(streams.back());
+  }
+  manager.initialize(changeQueue, storage, nullptr, &mirror);
+  changeQueue.applyStreamChanges();
+  for (auto& observer : mirroredObservers)
+    ASSERT_EQ(10u, observer.items().size());
+  ASSERT_EQ(9u, manager.savedInitialLoads());
+}
+
+TEST_F(Persistence, IndexedStreamFanOut)
+{
+  persistence::sqlite::SqliteStorage storage("test.db");
+  auto hotel = makeNewHotel("Hotel 1", "Category 1", 1);
+  storage.storeNewHotel(hotel);
+  std::vector<hotel::Reservation> reservations;
+  for (int i = 0; i < 3; ++i)
+  {
+    reservations.push_back(makeNewReservation("Reservation " + std::to_string(i), hotel.rooms()[0]->id()));
+    storage.storeNewReservationAndAtoms(reservations.back());
+  }
+
+  // One stream for each reservation, and one for all of them
+  persistence::ChangeQueue changeQueue;
+  persistence::detail::DataStreamManager manager;
+  std::vector<persistence::VectorDataStreamObserver<hotel::Reservation>> observers(4);
+  std::vector<std::shared_ptr<persistence::DataStream>> streams;
+  for (std::size_t i = 0; i < observers.size(); ++i)
+  {
+    nlohmann::json options;
+    if (i < reservations.size())
+      options["id"] = reservations[i].id();
+    streams.push_back(std::make_shared<persistence::DataStream>(persistence::StreamableType::Reservation,
+                                                                i < reservations.size() ? "reservation.by_id" : "",
+                                                                options));
+    streams.back()->connect(static_cast<int>(i) + 1, &observers[i]);
+    changeQueue.addStream(streams.back());
+    manager.addNewStream(streams.back());
+  }
+  manager.initialize(changeQueue, storage);
+
+  auto notifiedStreams = [&](const hotel::Reservation& reservation) {
+    std::vector<persistence::DataStreamDifferential> changes;
+    manager.updateItems(changes, persistence::StreamableType::Reservation,
+                        std::vector<hotel::Reservation>{reservation});
+    std::vector<int> streamIds;
+    for (auto& change : changes)
+      streamIds.push_back(change.streamId);
+    std::sort(streamIds.begin(), streamIds.end());
+    return streamIds;
+  };
+  ASSERT_EQ(std::vector<int>({2, 4}), notifiedStreams(reservations[1]));
+
+  // Streams are indexed by their new id once their options change
+  nlohmann::json options;
+  options["id"] = reservations[2].id();
+  manager.changeStreamOptions(streams[0], options);
+  manager.applyOptionChanges(changeQueue, storage);
+  ASSERT_EQ(std::vector<int>({4}), notifiedStreams(reservations[0]));
+  ASSERT_EQ(std::vector<int>({1, 3, 4}), notifiedStreams(reservations[2]));
+
+  manager.removeStream(streams[2]);
+  ASSERT_EQ(std::vector<int>({1, 4}), notifiedStreams(reservations[2]));
+
+  // A stream for a single item without a valid id is not notified of any changes
+  persistence::VectorDataStreamObserver<hotel::Reservation> invalidObserver;
+  auto invalidStream = std::make_shared<persistence::DataStream>(persistence::StreamableType::Reservation,
+                                                                 "reservation.by_id", nlohmann::json{{"id", "1"}});
+  invalidStream->connect(5, &invalidObserver);
+  changeQueue.addStream(invalidStream);
+  manager.addNewStream(invalidStream);
+  manager.initialize(changeQueue, storage);
+  changeQueue.applyStreamChanges();
+  ASSERT_TRUE(invalidStream->isInitialized());
+  ASSERT_TRUE(invalidObserver.items().empty());
+  ASSERT_EQ(std::vector<int>({1, 4}), notifiedStreams(reservations[2]));
+}
+
+TEST_F(Persistence, InMemoryMirror)
+{
+  auto reservationsById = [](const std::vector<hotel::Reservation>& reservations) {
+    std::map<int, std::pair<std::string, int>> result;
+    for (auto& reservation : reservations)
+      result[reservation.id()] = {reservation.description(), reservation.revision()};
+    return result;
+  };
+
+  persistence::sqlite::SqliteBackend backend("test.db", std::nullopt, 4, true);
+  persistence::VectorDataStreamObserver<hotel::Hotel> hotels;
+  persistence::VectorDataStreamObserver<hotel::Reservation> reservations;
+  auto hotelsStreamHandle = backend.createStreamTyped(&hotels);
+  auto reservationsStreamHandle = backend.createStreamTyped(&reservations);
+  storeHotel(backend, makeNewHotel("Hotel 1", "Category 1", 2));
+  auto roomId = hotels.items()[0].rooms()[0]->id();
+  for (int i = 0; i < 4; ++i)
+    storeReservation(backend, makeNewReservation("Reservation " + std::to_string(i), roomId));
+  auto archived = makeNewReservation("Archived", roomId);
+  archived.setStatus(hotel::Reservation::Archived);
+  int archivedId = backend.queueOperation(persistence::op::StoreNew{std::make_unique<hotel::Reservation>(archived)})
+                       .get()[0]
+                       .result["id"];
+
+  // Writes go through the mirror, rolled back transactions are undone in the mirror as well
+  auto updated = reservations.items()[1];
+  updated.setDescription("Updated");
+  backend.queueOperation(persistence::op::Update{std::make_unique<hotel::Reservation>(updated)}).wait();
+  auto removedId = reservations.items()[2].id();
+  backend.queueOperation(persistence::op::Delete{persistence::op::StreamableType::Reservation, removedId}).wait();
+  auto failed = reservations.items()[0];
+  failed.setDescription("Failed");
+  persistence::op::Operations ops;
+  ops.push_back(persistence::op::Update{std::make_unique<hotel::Reservation>(failed)});
+  ops.push_back(persistence::op::Update{std::make_unique<hotel::Reservation>(failed)});
+  ASSERT_EQ(persistence::TaskResultStatus::Error, backend.queueOperations(std::move(ops)).get()[1].status);
+  auto renamedHotel = hotels.items()[0];
+  renamedHotel.setName("Hotel 2");
+  backend.queueOperation(persistence::op::Update{std::make_unique<hotel::Hotel>(renamedHotel)}).wait();
+  backend.changeQueue().applyStreamChanges();
+
+  persistence::sqlite::SqliteStorage storage("test.db");
+  auto stored = reservationsById(storage.loadAll<hotel::Reservation>());
+  ASSERT_EQ(3u, stored.size());
+  ASSERT_EQ("Updated", stored[updated.id()].first);
+
+  // New streams get the same data as from the storage...
+  persistence::VectorDataStreamObserver<hotel::Hotel> mirroredHotels;
+  persistence::VectorDataStreamObserver<hotel::Reservation> mirroredReservations;
+  auto mirroredHotelsStreamHandle = backend.createStreamTyped(&mirroredHotels);
+  auto mirroredReservationsStreamHandle = backend.createStreamTyped(&mirroredReservations);
+  waitForStreamInitialization(backend);
+  ASSERT_EQ(stored, reservationsById(mirroredReservations.items()));
+  ASSERT_EQ(storage.loadAll<hotel::Hotel>(), mirroredHotels.items());
+
+  // ...which is served from memory. Only archived reservations are still read from the storage.
+  sqlite3* db = nullptr;
+  ASSERT_EQ(SQLITE_OK, sqlite3_open("test.db", &db));
+  const char* externalUpdate = "UPDATE h_reservation SET description = 'Changed';";
+  ASSERT_EQ(SQLITE_OK, sqlite3_exec(db, externalUpdate, nullptr, nullptr, nullptr));
+  sqlite3_close(db);
+  persistence::VectorDataStreamObserver<hotel::Reservation> reservation;
+  persistence::VectorDataStreamObserver<hotel::Reservation> archivedReservation;
+  auto reservationStreamHandle =
+      backend.createStreamTyped(&reservation, "reservation.by_id", nlohmann::json{{"id", updated.id()}});
+  auto archivedStreamHandle =
+      backend.createStreamTyped(&archivedReservation, "reservation.by_id", nlohmann::json{{"id", archivedId}});
+  waitForStreamInitialization(backend);
+  ASSERT_EQ(1u, reservation.items().size());
+  ASSERT_EQ("Updated", reservation.items()[0].description());
+  ASSERT_EQ(1u, archivedReservation.items().size());
+  ASSERT_EQ("Archived", archivedReservation.items()[0].description());
+}
+
+TEST_F(Persistence, GroupCommit)
+{
+  auto descriptions = [](const std::vector<hotel::Reservation>& reservations) {
+    std::vector<std::string> result;
+    for (auto& reservation : reservations)
+      result.push_back(reservation.description());
+    std::sort(result.begin(), result.end());
+    return result;
+  };
+
+  persistence::sqlite::SqliteBackend backend("test.db", std::nullopt, 4, true);
+  persistence::VectorDataStreamObserver<hotel::Hotel> hotels;
+  persistence::VectorDataStreamObserver<hotel::Reservation> reservations;
+  auto hotelsStreamHandle = backend.createStreamTyped(&hotels);
+  auto reservationsStreamHandle = backend.createStreamTyped(&reservations);
+  storeHotel(backend, makeNewHotel("Hotel 1", "Category 1", 1));
+  auto roomId = hotels.items()[0].rooms()[0]->id();
+  storeReservation(backend, makeNewReservation("Existing", roomId));
+
+  // Batches which are queued together are committed together, but the failed batch is still rolled back on its own
+  auto store = [&](const std::string& description) {
+    return persistence::op::StoreNew{std::make_unique<hotel::Reservation>(makeNewReservation(description, roomId))};
+  };
+  auto updated = reservations.items()[0];
+  updated.setDescription("Updated");
+  persistence::op::Operations failing;
+  failing.push_back(store("Rolled back"));
+  failing.push_back(persistence::op::Update{std::make_unique<hotel::Reservation>(updated)});
+  failing.push_back(persistence::op::Update{std::make_unique<hotel::Reservation>(updated)});
+  std::vector<fas::Future<std::vector<persistence::TaskResult>>> tasks;
+  tasks.push_back(backend.queueOperation(store("Before")));
+  tasks.push_back(backend.queueOperations(std::move(failing)));
+  tasks.push_back(backend.queueOperation(store("After")));
+
+  // Results are only available once they have been committed
+  persistence::sqlite::SqliteStorage storage("test.db", persistence::sqlite::SqliteStorage::OpenMode::ReadOnly);
+  ASSERT_EQ(persistence::TaskResultStatus::Successful, tasks[0].get()[0].status);
+  auto stored = descriptions(storage.loadAll<hotel::Reservation>());
+  ASSERT_EQ(1, std::count(stored.begin(), stored.end(), "Before"));
+  ASSERT_EQ(persistence::TaskResultStatus::Error, tasks[1].get()[2].status);
+  ASSERT_EQ(persistence::TaskResultStatus::Successful, tasks[2].get()[0].status);
+  backend.changeQueue().applyStreamChanges();
+
+  auto expected = std::vector<std::string>({"After", "Before", "Existing"});
+  ASSERT_EQ(expected, descriptions(storage.loadAll<hotel::Reservation>()));
+  ASSERT_EQ(expected, descriptions(reservations.items()));
+
+  // The mirror has rolled back the failed batch as well
+  persistence::VectorDataStreamObserver<hotel::Reservation> mirroredReservations;
+  auto mirroredStreamHandle = backend.createStreamTyped(&mirroredReservations);
+  waitForStreamInitialization(backend);
+  ASSERT_EQ(expected, descriptions(mirroredReservations.items()));
+
+  // A failed batch which erased all data is rolled back without committing the group early
+  persistence::op::Operations erasing;
+  erasing.push_back(persistence::op::EraseAllData());
+  erasing.push_back(persistence::op::Update{std::unique_ptr<hotel::Reservation>()});
+  tasks.clear();
+  tasks.push_back(backend.queueOperation(store("Before erasing")));
+  tasks.push_back(backend.queueOperations(std::move(erasing)));
+  tasks.push_back(backend.queueOperation(store("After erasing")));
+  ASSERT_EQ(persistence::TaskResultStatus::Successful, tasks[0].get()[0].status);
+  ASSERT_EQ(persistence::TaskResultStatus::Error, tasks[1].get()[1].status);
+  ASSERT_EQ(persistence::TaskResultStatus::Successful, tasks[2].get()[0].status);
+  backend.changeQueue().applyStreamChanges();
+
+  expected = std::vector<std::string>({"After", "After erasing", "Before", "Before erasing", "Existing"});
+  ASSERT_EQ(expected, descriptions(storage.loadAll<hotel::Reservation>()));
+  ASSERT_EQ(1u, storage.loadAll<hotel::Hotel>().size());
+  ASSERT_EQ(expected, descriptions(reservations.items()));
+  ASSERT_EQ(1u, hotels.items().size());
+  persistence::VectorDataStreamObserver<hotel::Reservation> remirroredReservations;
+  auto remirroredStreamHandle = backend.createStreamTyped(&remirroredReservations);
+  waitForStreamInitialization(backend);
+  ASSERT_EQ(expected, descriptions(remirroredReservations.items()));
+}
+
+TEST_F(Persistence, SchemaMigration)
+{
+  // Create a database with the schema from before versioning, which stored dates as text
+  const char* path = "test_migration.db";
+  std::remove(path);
+  sqlite3* db = nullptr;
+  ASSERT_EQ(SQLITE_OK, sqlite3_open(path, &db));
+  const char* legacySchema =
+      "CREATE TABLE h_hotel (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, revision INTEGER NOT NULL DEFAULT 1, "
+      "name TEXT NOT NULL);"
+      "CREATE TABLE h_room_category (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, hotel_id INTEGER NOT NULL,"
+      "short_code TEXT NOT NULL, name TEXT NOT NULL);"
+      "CREATE TABLE h_room (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, hotel_id INTEGER NOT NULL,"
+      "category_id INTEGER NOT NULL, name TEXT NOT NULL);"
+      "CREATE TABLE h_reservation (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, revision INTEGER NOT NULL DEFAULT 1, "
+      "description TEXT NOT NULL, status TEXT NOT NULL, adults INTEGER NOT NULL, children INTEGER NOT NULL);"
+      "CREATE TABLE h_reservation_atom (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, reservation_id INTEGER NOT NULL,"
+      "room_id INTEGER NOT NULL, date_from TEXT NOT NULL, date_to TEXT NOT NULL);"
+      "INSERT INTO h_hotel (name) VALUES ('Hotel 1');"
+      "INSERT INTO h_room_category (hotel_id, short_code, name) VALUES (1, 'C', 'Category');"
+      "INSERT INTO h_room (hotel_id, category_id, name) VALUES (1, 1, 'Room 1'), (1, 1, 'Room 2');"
+      "INSERT INTO h_reservation (description, status, adults, children) VALUES ('Stay', 'confirmed', 2, 1);"
+      "INSERT INTO h_reservation_atom (reservation_id, room_id, date_from, date_to) VALUES "
+      "(1, 1, '20161230', '20170102'), (1, 2, '20170102', '20170105'), (1, 2, '20170105', '20170106');"
+      "DELETE FROM h_reservation_atom WHERE id = 3;";
+  ASSERT_EQ(SQLITE_OK, sqlite3_exec(db, legacySchema, nullptr, nullptr, nullptr));
+  sqlite3_close(db);
+
+  persistence::sqlite::SqliteStorage storage(path);
+  ASSERT_EQ(persistence::sqlite::SqliteStorage::latestSchemaVersion(), storage.schemaVersion());
+  auto reservations = storage.loadAll<hotel::Reservation>();
+  ASSERT_EQ(1u, reservations.size());
+  ASSERT_EQ("Stay", reservations[0].description());
+  ASSERT_EQ(2u, reservations[0].atoms().size());
+  ASSERT_EQ(hotel::DayRange(hotel::Day::fromYmd(2016, 12, 30), hotel::Day::fromYmd(2017, 1, 2)),
+            reservations[0].atoms()[0].dayRange());
+  ASSERT_EQ(hotel::DayRange(hotel::Day::fromYmd(2017, 1, 2), hotel::Day::fromYmd(2017, 1, 5)),
+            reservations[0].atoms()[1].dayRange());
+
+  // The ids of deleted atoms are not reused after the migration
+  reservations[0].setStatus(hotel::Reservation::CheckedOut);
+  ASSERT_TRUE(storage.update(reservations[0]));
+  ASSERT_EQ(4, reservations[0].atoms()[0].id());
+
+  // Range queries work on the converted dates, and the R*Tree has been filled with the existing atoms
+  ASSERT_EQ(1u, storage.loadInPeriod<hotel::Reservation>(hotel::DayRange(hotel::Day::fromYmd(2017, 1, 4),
+                                                                         hotel::Day::fromYmd(2017, 1, 5))).size());
+  ASSERT_EQ(std::vector<int>({1}), storage.archiveReservations(hotel::Day::fromYmd(2017, 1, 5)));
+  ASSERT_EQ(1u, storage.loadArchivedReservations(hotel::DayRange(hotel::Day::fromYmd(2017, 1, 4),
+                                                                 hotel::Day::fromYmd(2017, 1, 5))).size());
+  ASSERT_EQ(0u, storage.loadArchivedReservations(hotel::DayRange(hotel::Day::fromYmd(2017, 1, 5),
+                                                                 hotel::Day::fromYmd(2017, 1, 6))).size());
+
+  // Opening the database again does not migrate it twice
+  persistence::sqlite::SqliteStorage reopened(path);
+  ASSERT_EQ(persistence::sqlite::SqliteStorage::latestSchemaVersion(), reopened.schemaVersion());
+  ASSERT_EQ(1u, reopened.loadArchivedReservations(hotel::DayRange(hotel::Day::fromYmd(2016, 1, 1),
+                                                                  hotel::Day::fromYmd(2018, 1, 1))).size());
+}
+
+TEST_F(Persistence, LoadInPeriod)
+{
+  auto day = [](int dayOfMonth) { return hotel::Day::fromYmd(2017, 1, dayOfMonth); };
+  auto reservationIds = [](const std::vector<hotel::Reservation>& reservations) {
+    std::vector<int> result;
+    for (auto& reservation : reservations)
+      result.push_back(reservation.id());
+    return result;
+  };
+
+  persistence::sqlite::SqliteStorage storage("test.db");
+  auto hotel = makeNewHotel("Hotel 1", "Category 1", 2);
+  storage.storeNewHotel(hotel);
+  auto room1 = hotel.rooms()[0]->id();
+  auto room2 = hotel.rooms()[1]->id();
+
+  // Reservation 1 stays from the 1st to the 11th, reservation 2 changes rooms on the 15th
+  auto reservation1 = makeNewReservation("Reservation 1", room1);
+  hotel::Reservation reservation2("Reservation 2", room1, hotel::DayRange(day(12), day(15)));
+  reservation2.addContinuation(room2, day(20));
+  storage.beginTransaction();
+  storage.storeNewReservationAndAtoms(reservation1);
+  storage.storeNewReservationAndAtoms(reservation2);
+  storage.commitTransaction();
+
+  ASSERT_EQ(std::vector<int>({reservation1.id()}),
+            reservationIds(storage.loadInPeriod<hotel::Reservation>(hotel::DayRange(day(5), day(12)))));
+  ASSERT_EQ(std::vector<int>({reservation1.id(), reservation2.id()}),
+            reservationIds(storage.loadInPeriod<hotel::Reservation>(hotel::DayRange(day(10), day(13)))));
+  auto inPeriod = storage.loadInPeriod<hotel::Reservation>(hotel::DayRange(day(19), day(25)));
+  ASSERT_EQ(1u, inPeriod.size());
+  ASSERT_EQ(reservation2, inPeriod[0]);
+  ASSERT_EQ(1u, storage.loadInPeriod<hotel::AtomRecord>(hotel::DayRange(day(19), day(25))).size());
+  ASSERT_EQ(0u, storage.loadAtomsInRoom(room1, hotel::DayRange(day(15), day(25))).size());
+  ASSERT_EQ(1u, storage.loadAtomsInRoom(room2, hotel::DayRange(day(15), day(25))).size());
+
+  // The index follows updates, deletions and archiving
+  reservation2.atoms()[1].setRoomId(room1);
+  ASSERT_TRUE(storage.update(reservation2));
+  ASSERT_EQ(0u, storage.loadAtomsInRoom(room2, hotel::DayRange(day(15), day(25))).size());
+  ASSERT_EQ(1u, storage.loadAtomsInRoom(room1, hotel::DayRange(day(15), day(25))).size());
+
+  storage.deleteReservationById(reservation1.id());
+  ASSERT_TRUE(storage.loadInPeriod<hotel::Reservation>(hotel::DayRange(day(1), day(12))).empty());
+
+  reservation2.setStatus(hotel::Reservation::Archived);
+  ASSERT_TRUE(storage.update(reservation2));
+  ASSERT_TRUE(storage.loadInPeriod<hotel::AtomRecord>(hotel::DayRange(day(1), day(31))).empty());
+  reservation2.setStatus(hotel::Reservation::CheckedOut);
+  ASSERT_TRUE(storage.update(reservation2));
+  ASSERT_EQ(2u, storage.loadInPeriod<hotel::AtomRecord>(hotel::DayRange(day(1), day(31))).size());
+}
+
 TEST_F(Persistence, VersionConflicts)
 {
   persistence::sqlite::SqliteBackend backend("test.db");
@@ -289,6 +1167,17 @@ TEST_F(Persistence, FailedTransaction)
     ASSERT_EQ(1u, hotels.items().size());
     ASSERT_EQ(1u, hotels.items()[0].revision());
     ASSERT_EQ("Hotel 1", hotels.items()[0].name());
+
+    // Erasing all data is rolled back as well
+    ops.clear();
+    ops.push_back(persistence::op::EraseAllData());
+    ops.push_back(persistence::op::Update{std::unique_ptr<hotel::Hotel>()});
+    auto eraseTaskResults = backend.queueOperations(std::move(ops)).get();
+    backend.changeQueue().applyStreamChanges();
+
+    ASSERT_EQ(persistence::TaskResultStatus::Successful, eraseTaskResults[0].status);
+    ASSERT_EQ(persistence::TaskResultStatus::Error, eraseTaskResults[1].status);
+    ASSERT_EQ(1u, hotels.items().size());
   }
 
   // After reloading the database, we should still see no changes...
@@ -0,0 +1,51 @@
+#include "persistence/sqlite/sqlitestorage.h"
+
+#include "hotel/hotelcollection.h"
+#include "hotel/planningvalidator.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+// Checks all reservations of a database, including the archived ones, for overlaps, broken continuations and dangling
+// rooms. The database is opened read only and is never migrated.
+// Usage: hotel_validateapp [database file, defaults to data.db]
+// Returns 0 if the planning is consistent, 1 if issues were found and 2 if the database cannot be read or its schema is
+// out of date.
+int main(int argc, char** argv)
+{
+  std::string file = argc > 1 ? argv[1] : "data.db";
+  if (!std::ifstream(file))
+  {
+    std::cerr << "Cannot open database: " << file << std::endl;
+    return 2;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  using persistence::sqlite::SqliteStorage;
+  SqliteStorage storage(file, SqliteStorage::OpenMode::ReadOnly);
+  if (storage.schemaVersion() < SqliteStorage::latestSchemaVersion())
+  {
+    std::cerr << "The schema of " << file << " is at version " << storage.schemaVersion() << ", but version "
+              << SqliteStorage::latestSchemaVersion() << " is needed. Open it with the server once to migrate it."
+              << std::endl;
+    return 2;
+  }
+
+  hotel::HotelCollection hotels;
+  for (auto& hotel : storage.loadAll<hotel::Hotel>())
+    hotels.addHotel(std::make_unique<hotel::Hotel>(std::move(hotel)));
+  auto atoms = storage.loadAll<hotel::AtomRecord>();
+  auto archivedAtoms = storage.loadAllArchivedAtoms();
+  atoms.insert(atoms.end(), archivedAtoms.begin(), archivedAtoms.end());
+  auto atomCount = atoms.size();
+
+  auto issues = hotel::PlanningValidator(hotels).validate(std::move(atoms));
+  for (auto& issue : issues)
+    std::cout << issue.toString() << std::endl;
+
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  std::cout << atomCount << " atoms checked in " << duration.count() << " ms, " << issues.size() << " issues found"
+            << std::endl;
+  return issues.empty() ? 0 : 1;
+}